@@ -0,0 +1,139 @@
+#include "AnalysisSession6502.h"
+#include "BankedDisassembly6502.h"
+#include "ListingLine6502.h"
+#include "SymbolTable6502.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace {
+
+	// Guesses at the text per row to size the listing once; symbol names are usually short
+	const size_t SYMBOL_LINE_LEN = 24;
+
+}
+
+AnalysisSession6502::Image::Image(std::pmr::memory_resource* resource) :
+	baseAddress(0),
+	columns(resource),
+	referenceTargets(resource),
+	referenceRows(resource),
+	listing(resource)
+{
+}
+
+std::pair<size_t, size_t> AnalysisSession6502::Image::referencesTo(uint16_t target) const
+{
+	const std::pair<std::pmr::vector<uint16_t>::const_iterator, std::pmr::vector<uint16_t>::const_iterator> range =
+		std::equal_range(referenceTargets.begin(), referenceTargets.end(), target);
+
+	return std::make_pair(range.first - referenceTargets.begin(), range.second - referenceTargets.begin());
+}
+
+AnalysisSession6502::OverflowResource::OverflowResource() : allocated(0) {}
+
+void* AnalysisSession6502::OverflowResource::do_allocate(size_t bytes, size_t alignment)
+{
+	void* pointer = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	allocated += bytes;
+
+	return pointer;
+}
+
+void AnalysisSession6502::OverflowResource::do_deallocate(void* pointer, size_t bytes, size_t alignment)
+{
+	std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+	allocated -= bytes;
+}
+
+bool AnalysisSession6502::OverflowResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+AnalysisSession6502::AnalysisSession6502(size_t arenaSize) :
+	buffer(new unsigned char[arenaSize > 0 ? arenaSize : 1]),
+	bufferSize(arenaSize > 0 ? arenaSize : 1)
+{
+	arena.emplace(buffer.get(), bufferSize, &overflow);
+}
+
+std::pmr::memory_resource* AnalysisSession6502::resource()
+{
+	return &*arena;
+}
+
+AnalysisSession6502::Image& AnalysisSession6502::decode(const uint8_t* data, size_t length, uint16_t baseAddress)
+{
+	// never destroyed: its members only hold arena memory, which reset() takes back wholesale
+	Image* image = new (resource()->allocate(sizeof(Image), alignof(Image))) Image(resource());
+
+	image->baseAddress = baseAddress;
+	image->columns = InstructionColumns6502::decode(data, length, baseAddress, resource());
+
+	const InstructionColumns6502::View view = image->columns.view();
+	std::pmr::vector<std::pair<uint16_t, uint32_t> > references(resource());
+	references.reserve(view.count);
+
+	for (size_t row = 0; row < view.count; row++) {
+		uint16_t target;
+
+		if (BankedDisassembly6502::branchTarget(view, row, target)) {
+			references.push_back(std::make_pair(target, static_cast<uint32_t>(row)));
+		}
+	}
+
+	std::sort(references.begin(), references.end());
+
+	image->referenceTargets.reserve(references.size());
+	image->referenceRows.reserve(references.size());
+
+	for (const std::pair<uint16_t, uint32_t>& reference : references) {
+		image->referenceTargets.push_back(reference.first);
+		image->referenceRows.push_back(reference.second);
+	}
+
+	return *image;
+}
+
+void AnalysisSession6502::render(Image& image, const SymbolTable6502* symbols)
+{
+	const InstructionColumns6502::View view = image.columns.view();
+
+	image.listing.clear();
+	image.listing.reserve(view.count * (symbols == NULL ? ListingLine6502::MAX_LEN : SYMBOL_LINE_LEN));
+
+	for (size_t row = 0; row < view.count; row++) {
+		ListingLine6502::append(image.listing, view, row, symbols);
+	}
+}
+
+const char* AnalysisSession6502::format(const StreamingDisassembler6502::Record& record)
+{
+	char* text = static_cast<char*>(resource()->allocate(StreamingDisassembler6502::MAX_TEXT_LEN + 1, 1));
+	StreamingDisassembler6502::format(record, text, StreamingDisassembler6502::MAX_TEXT_LEN + 1);
+
+	return text;
+}
+
+void AnalysisSession6502::reset()
+{
+	const size_t peak = bufferSize + overflow.allocated;
+
+	arena.reset();
+
+	if (peak > bufferSize) {
+		buffer.reset();
+		buffer.reset(new unsigned char[peak]);
+		bufferSize = peak;
+	}
+
+	arena.emplace(buffer.get(), bufferSize, &overflow);
+}
+
+size_t AnalysisSession6502::getReservedBytes() const
+{
+	return bufferSize + overflow.allocated;
+}
@@ -0,0 +1,92 @@
+#ifndef ANALYSIS_SESSION_6502_H
+#define ANALYSIS_SESSION_6502_H
+
+#include "InstructionColumns6502.h"
+#include "StreamingDisassembler6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class SymbolTable6502;
+
+// Owns one monotonic arena for everything derived from the image being analyzed: decoded columns,
+// cross references and text. Allocation is a pointer bump and reset() drops it all at once, so a worker
+// that analyzes many images reuses the same memory instead of fragmenting the heap.
+// When an image needed more than the arena holds, reset() grows the arena to that peak,
+// so after the largest image has been seen the session does not touch the heap any more.
+class AnalysisSession6502
+{
+public:
+
+	static const size_t DEFAULT_ARENA_SIZE = 1024 * 1024;
+
+	struct Image {
+		uint16_t baseAddress;
+		InstructionColumns6502 columns;
+		// rows with a branch or absolute operand, sorted by target
+		std::pmr::vector<uint16_t> referenceTargets;
+		std::pmr::vector<uint32_t> referenceRows;
+		// "$XXXX\tTEXT\n" lines like TextSink6502, empty until render()
+		std::pmr::string listing;
+
+		explicit Image(std::pmr::memory_resource* resource);
+
+		// Sources of the references to target as a range of referenceRows
+		std::pair<size_t, size_t> referencesTo(uint16_t target) const;
+	};
+
+private:
+
+	// Heap behind the arena, counted to know how far the arena overflowed
+	class OverflowResource : public std::pmr::memory_resource
+	{
+	public:
+
+		size_t allocated;
+
+		OverflowResource();
+
+	private:
+
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+	};
+
+	std::unique_ptr<unsigned char[]> buffer;
+	size_t bufferSize;
+	OverflowResource overflow;
+	std::optional<std::pmr::monotonic_buffer_resource> arena;
+
+public:
+
+	explicit AnalysisSession6502(size_t arenaSize = DEFAULT_ARENA_SIZE);
+
+	AnalysisSession6502(const AnalysisSession6502&) = delete;
+	AnalysisSession6502& operator=(const AnalysisSession6502&) = delete;
+
+	std::pmr::memory_resource* resource();
+
+	// Linear sweep of data with its cross reference index. The image lives in the arena until reset()
+	Image& decode(const uint8_t* data, size_t length, uint16_t baseAddress = 0);
+
+	// Fills image.listing, with symbols like TextSink6502 when symbols is not NULL
+	void render(Image& image, const SymbolTable6502* symbols = NULL);
+
+	// StreamingDisassembler6502::format() into arena memory, valid until reset()
+	const char* format(const StreamingDisassembler6502::Record& record);
+
+	// Frees everything allocated since the last reset; images, strings and pointers from the session become invalid
+	void reset();
+
+	// Bytes of the arena buffer plus what overflowed to the heap since the last reset
+	size_t getReservedBytes() const;
+};
+
+#endif
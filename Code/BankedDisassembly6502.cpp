@@ -0,0 +1,111 @@
+#include "BankedDisassembly6502.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+std::vector<BankedDisassembly6502::WindowColumns> BankedDisassembly6502::decode(const MemoryMap6502& map, const uint8_t* image, size_t imageLength, unsigned threadCount)
+{
+	const std::vector<MemoryMap6502::Window>& windows = map.windows();
+	std::vector<WindowColumns> result(windows.size());
+
+	if (threadCount == 0) {
+		threadCount = std::thread::hardware_concurrency();
+	}
+
+	if (threadCount > windows.size()) {
+		threadCount = static_cast<unsigned>(windows.size());
+	}
+
+	std::atomic<size_t> nextWindow(0);
+
+	auto worker = [&]() {
+		for (size_t i = nextWindow++; i < windows.size(); i = nextWindow++) {
+			const MemoryMap6502::Window& window = windows[i];
+			// a window past the end of the image decodes as empty; image + fileOffset is not formed for it
+			const uint8_t* data = image;
+			size_t length = 0;
+
+			if (window.fileOffset < imageLength) {
+				data = image + window.fileOffset;
+				length = std::min<size_t>(window.length, imageLength - window.fileOffset);
+			}
+
+			result[i].window = window;
+			result[i].columns = InstructionColumns6502::decode(data, length, window.cpuAddress);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned i = 1; i < threadCount; i++) {
+		workers.emplace_back(worker);
+	}
+
+	worker();
+
+	for (std::thread& thread : workers) {
+		thread.join();
+	}
+
+	return result;
+}
+
+bool BankedDisassembly6502::branchTarget(const InstructionColumns6502::View& view, size_t row, uint16_t& target)
+{
+	if (view.opcodes[row] == InstructionColumns6502::INVALID_OPCODE || view.operandLengths[row] == 0) {
+		return false;
+	}
+
+	if (view.addressingModes[row] == Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM) {
+		target = static_cast<uint16_t>(view.addresses[row] + 2 + static_cast<int8_t>(view.operands[row]));
+		return true;
+	}
+
+	if (view.operandLengths[row] == 2) {
+		target = view.operands[row];
+		return true;
+	}
+
+	return false;
+}
+
+std::vector<BankedDisassembly6502::CrossReference> BankedDisassembly6502::crossReferences(const MemoryMap6502& map, const std::vector<WindowColumns>& windows)
+{
+	std::vector<CrossReference> references;
+
+	for (const WindowColumns& window : windows) {
+		const InstructionColumns6502::View view = window.columns.view();
+		const uint16_t bank = window.window.bank;
+
+		for (size_t row = 0; row < view.count; row++) {
+			uint16_t target;
+
+			if (!branchTarget(view, row, target)) {
+				continue;
+			}
+
+			MemoryMap6502::Location location = { MemoryMap6502::NO_BANK, MemoryMap6502::UNMAPPED };
+			map.resolve(bank, target, location);
+
+			references.push_back({ bank, view.addresses[row], location.bank, target, location.fileOffset, view.opcodes[row] });
+		}
+	}
+
+	std::sort(references.begin(), references.end(), [](const CrossReference& left, const CrossReference& right) {
+		if (left.toBank != right.toBank) {
+			return left.toBank < right.toBank;
+		}
+
+		if (left.toAddress != right.toAddress) {
+			return left.toAddress < right.toAddress;
+		}
+
+		if (left.fromBank != right.fromBank) {
+			return left.fromBank < right.fromBank;
+		}
+
+		return left.fromAddress < right.fromAddress;
+	});
+
+	return references;
+}
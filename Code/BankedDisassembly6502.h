@@ -0,0 +1,41 @@
+#ifndef BANKED_DISASSEMBLY_6502_H
+#define BANKED_DISASSEMBLY_6502_H
+
+#include "InstructionColumns6502.h"
+#include "MemoryMap6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Disassembles every window of a banked image and resolves operands through the memory map,
+// so a branch or JSR inside bank 3 points at bank 3 (or the fixed bank) rather than at a flat offset.
+class BankedDisassembly6502
+{
+public:
+
+	struct WindowColumns {
+		MemoryMap6502::Window window;
+		InstructionColumns6502 columns;
+	};
+
+	struct CrossReference {
+		uint16_t fromBank;
+		uint16_t fromAddress;
+		// MemoryMap6502::NO_BANK when the target is not mapped, e.g. an I/O register
+		uint16_t toBank;
+		uint16_t toAddress;
+		uint32_t toFileOffset;
+		uint8_t opcode;
+	};
+
+	// Windows are independent, so they are decoded on up to threadCount threads (0 for all cores)
+	static std::vector<WindowColumns> decode(const MemoryMap6502& map, const uint8_t* image, size_t imageLength, unsigned threadCount = 0);
+
+	static bool branchTarget(const InstructionColumns6502::View& view, size_t row, uint16_t& target);
+
+	// Relative branches and all absolute operands, sorted by target
+	static std::vector<CrossReference> crossReferences(const MemoryMap6502& map, const std::vector<WindowColumns>& windows);
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "BoundaryResolver6502.h"
+#include "InstructionLengthKernel6502.h"
+
+#include <cstring>
+#include <functional>
+#include <thread>
+
+namespace {
+
+	const size_t MIN_CHUNK_LENGTH = 64 * 1024;
+	const size_t MAX_INSTRUCTION_LENGTH = 3;
+
+	// An instruction can overhang into the next chunk by up to two bytes, so each chunk is
+	// swept once per possible entry phase. Phase e marks its opcodes with bit e of instructionStarts.
+	struct Chunk {
+		size_t begin;
+		size_t end;
+		uint8_t exitPhase[MAX_INSTRUCTION_LENGTH];
+		uint8_t entryPhase;
+	};
+
+	void sweepChunk(const uint8_t* data, uint8_t* classes, uint8_t* instructionStarts, Chunk& chunk)
+	{
+		InstructionLengthKernel6502::classify(data + chunk.begin, chunk.end - chunk.begin, classes + chunk.begin);
+		memset(instructionStarts + chunk.begin, 0, chunk.end - chunk.begin);
+
+		for (size_t phase = 0; phase < MAX_INSTRUCTION_LENGTH; phase++) {
+			const uint8_t bit = static_cast<uint8_t>(1 << phase);
+			size_t offset = chunk.begin + phase;
+
+			while (offset < chunk.end) {
+				instructionStarts[offset] |= bit;
+				offset += InstructionLengthKernel6502::instructionLength(classes[offset]);
+			}
+
+			chunk.exitPhase[phase] = static_cast<uint8_t>(offset - chunk.end);
+		}
+	}
+
+	void selectPhase(uint8_t* instructionStarts, const Chunk& chunk)
+	{
+		const uint8_t shift = chunk.entryPhase;
+
+		for (size_t offset = chunk.begin; offset < chunk.end; offset++) {
+			instructionStarts[offset] = (instructionStarts[offset] >> shift) & 1;
+		}
+	}
+
+	template <typename Function>
+	void forEachChunk(std::vector<Chunk>& chunks, Function function)
+	{
+		std::vector<std::thread> workers;
+		workers.reserve(chunks.size() - 1);
+
+		for (size_t i = 1; i < chunks.size(); i++) {
+			workers.emplace_back(function, std::ref(chunks[i]));
+		}
+
+		function(chunks[0]);
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	}
+
+}
+
+void BoundaryResolver6502::resolve(const uint8_t* data, size_t length, size_t start, uint8_t* instructionStarts, unsigned threadCount)
+{
+	if (start >= length) {
+		memset(instructionStarts, 0, length);
+		return;
+	}
+
+	if (threadCount == 0) {
+		threadCount = std::thread::hardware_concurrency();
+	}
+
+	const size_t sweepLength = length - start;
+	size_t chunkCount = sweepLength / MIN_CHUNK_LENGTH;
+
+	if (chunkCount > threadCount) {
+		chunkCount = threadCount;
+	}
+
+	if (chunkCount <= 1) {
+		resolveSerial(data, length, start, instructionStarts);
+		return;
+	}
+
+	memset(instructionStarts, 0, start);
+
+	std::vector<uint8_t> classes(length);
+	std::vector<Chunk> chunks(chunkCount);
+
+	for (size_t i = 0; i < chunkCount; i++) {
+		chunks[i].begin = start + sweepLength * i / chunkCount;
+		chunks[i].end = start + sweepLength * (i + 1) / chunkCount;
+	}
+
+	forEachChunk(chunks, [&](Chunk& chunk) {
+		sweepChunk(data, classes.data(), instructionStarts, chunk);
+	});
+
+	// the exit phase of each chunk is the entry phase of the next one
+	chunks[0].entryPhase = 0;
+	for (size_t i = 1; i < chunkCount; i++) {
+		chunks[i].entryPhase = chunks[i - 1].exitPhase[chunks[i - 1].entryPhase];
+	}
+
+	forEachChunk(chunks, [&](Chunk& chunk) {
+		selectPhase(instructionStarts, chunk);
+	});
+}
+
+void BoundaryResolver6502::resolveSerial(const uint8_t* data, size_t length, size_t start, uint8_t* instructionStarts)
+{
+	memset(instructionStarts, 0, length);
+
+	for (size_t offset = start; offset < length;) {
+		const uint8_t classByte = InstructionLengthKernel6502::classify(data[offset]);
+
+		instructionStarts[offset] = 1;
+		offset += InstructionLengthKernel6502::instructionLength(classByte);
+	}
+}
+
+void BoundaryResolver6502::collectStarts(const uint8_t* instructionStarts, size_t length, std::vector<size_t>& offsets)
+{
+	for (size_t offset = 0; offset < length; offset++) {
+		if (instructionStarts[offset]) {
+			offsets.push_back(offset);
+		}
+	}
+}
@@ -0,0 +1,24 @@
+#ifndef BOUNDARY_RESOLVER_6502_H
+#define BOUNDARY_RESOLVER_6502_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Finds which offsets a linear sweep starting at `start` decodes as opcodes, using every core.
+// The result is exactly what feeding the bytes from `start` through Disassembler6502::analyze() would give:
+// invalid bytes are one byte long and a trailing instruction cut off by the end of the buffer still counts.
+class BoundaryResolver6502
+{
+public:
+
+	// instructionStarts receives one byte per offset: 1 where an instruction starts, 0 elsewhere.
+	// threadCount 0 uses std::thread::hardware_concurrency().
+	static void resolve(const uint8_t* data, size_t length, size_t start, uint8_t* instructionStarts, unsigned threadCount = 0);
+
+	static void resolveSerial(const uint8_t* data, size_t length, size_t start, uint8_t* instructionStarts);
+
+	static void collectStarts(const uint8_t* instructionStarts, size_t length, std::vector<size_t>& offsets);
+};
+
+#endif
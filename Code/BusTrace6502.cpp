@@ -0,0 +1,607 @@
+#include "BusTrace6502.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	const char FILE_MAGIC[8] = { '6', '5', '0', '2', 'T', 'R', 'C', 0 };
+	const uint32_t FILE_VERSION = 3;
+
+	struct FileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t blockSamples;
+		uint64_t sampleCount;
+		uint64_t indexCount;
+		uint64_t indexOffset;
+		// 0 when the trace has no PC index. The masks are followed by PC_BUCKET_COUNT + 1 uint64 starts of the
+		// per bucket block lists and the uint32 block lists themselves
+		uint64_t pcMaskOffset;
+		// The runs follow the index and the cycle offsets follow the runs
+		uint64_t runCount;
+		uint64_t cycleOffsetCount;
+	};
+
+	static_assert(sizeof(FileHeader) == 64, "FileHeader must stay 64 Bytes");
+	static_assert(sizeof(BusTrace6502::Sample) == 4, "Sample must stay 4 Bytes");
+
+	uint64_t alignIndex(uint64_t offset)
+	{
+		return (offset + 7) & ~static_cast<uint64_t>(7);
+	}
+
+	bool compareEntryCycle(const uint64_t cycle, const BusTrace6502::IndexEntry& entry)
+	{
+		return cycle < entry.cycle;
+	}
+
+	bool compareRunSample(const uint64_t sample, const BusTrace6502::Run& run)
+	{
+		return sample < run.sample;
+	}
+
+	bool compareRunCycle(const uint64_t cycle, const BusTrace6502::Run& run)
+	{
+		return cycle < run.cycle;
+	}
+
+}
+
+BusTraceWriter6502::BusTraceWriter6502() :
+	file(NULL),
+	pcIndex(false),
+	failed(false),
+	sampleCount(0),
+	nextCycle(0),
+	pendingSyncEntries(0)
+{
+}
+
+BusTraceWriter6502::~BusTraceWriter6502()
+{
+	close();
+}
+
+bool BusTraceWriter6502::open(const char* path, bool pcIndex)
+{
+	close();
+
+	file = fopen(path, "wb");
+	if (file == NULL) {
+		return false;
+	}
+
+	this->pcIndex = pcIndex;
+	failed = false;
+	sampleCount = 0;
+	nextCycle = 0;
+	pendingSyncEntries = 0;
+	buffer.clear();
+	buffer.reserve(BusTrace6502::BLOCK_SAMPLES);
+	index.clear();
+	blockRuns.clear();
+	runs.clear();
+	cycleOffsets.clear();
+	pcMasks.clear();
+	fetchBlocks.assign(pcIndex ? BusTrace6502::PC_BUCKET_COUNT : 0, std::vector<uint32_t>());
+
+	// the header is written again with the final counts by close()
+	FileHeader header;
+	memset(&header, 0, sizeof(header));
+	failed = fwrite(&header, sizeof(header), 1, file) != 1;
+
+	return !failed;
+}
+
+void BusTraceWriter6502::flush()
+{
+	if (!buffer.empty()) {
+		finishBlock();
+	}
+
+	if (!buffer.empty() && fwrite(buffer.data(), sizeof(BusTrace6502::Sample), buffer.size(), file) != buffer.size()) {
+		failed = true;
+	}
+
+	buffer.clear();
+}
+
+void BusTraceWriter6502::startBlock(uint64_t cycle)
+{
+	const BusTrace6502::IndexEntry entry = { cycle, BusTrace6502::NO_SAMPLE, 0, 0 };
+	index.push_back(entry);
+	pendingSyncEntries++;
+
+	if (pcIndex) {
+		pcMasks.resize(pcMasks.size() + BusTrace6502::PC_MASK_WORDS, 0);
+	}
+}
+
+void BusTraceWriter6502::addRun(uint64_t cycle)
+{
+	const BusTrace6502::Run run = { cycle, sampleCount };
+	blockRuns.push_back(run);
+}
+
+void BusTraceWriter6502::finishBlock()
+{
+	if (pcIndex) {
+		const uint64_t* mask = pcMasks.data() + pcMasks.size() - BusTrace6502::PC_MASK_WORDS;
+		const uint32_t block = static_cast<uint32_t>(index.size() - 1);
+
+		for (size_t word = 0; word < BusTrace6502::PC_MASK_WORDS; word++) {
+			size_t bucket = word * 64;
+
+			for (uint64_t bits = mask[word]; bits != 0; bits >>= 1, bucket++) {
+				if ((bits & 1) != 0) {
+					fetchBlocks[bucket].push_back(block);
+				}
+			}
+		}
+	}
+
+	if (blockRuns.empty()) {
+		return;
+	}
+
+	BusTrace6502::IndexEntry& entry = index.back();
+
+	if (blockRuns.size() <= BusTrace6502::DENSE_RUN_COUNT || nextCycle - 1 - entry.cycle > 0xFFFFFFFF) {
+		entry.gapOffset = runs.size();
+		entry.runCount = blockRuns.size();
+		runs.insert(runs.end(), blockRuns.begin(), blockRuns.end());
+	}
+	else {
+		const uint64_t blockStart = (index.size() - 1) * BusTrace6502::BLOCK_SAMPLES;
+		uint64_t runCycle = entry.cycle;
+		uint64_t runSample = blockStart;
+		size_t next = 0;
+
+		entry.gapOffset = cycleOffsets.size();
+		entry.runCount = BusTrace6502::DENSE_RUNS;
+
+		for (uint64_t sample = blockStart; sample < blockStart + buffer.size(); sample++) {
+			if (next < blockRuns.size() && blockRuns[next].sample == sample) {
+				runCycle = blockRuns[next].cycle;
+				runSample = sample;
+				next++;
+			}
+
+			cycleOffsets.push_back(static_cast<uint32_t>(runCycle + (sample - runSample) - entry.cycle));
+		}
+	}
+
+	blockRuns.clear();
+}
+
+void BusTraceWriter6502::resolveSyncEntries()
+{
+	for (size_t i = index.size() - pendingSyncEntries; i < index.size(); i++) {
+		index[i].syncSample = sampleCount;
+	}
+
+	pendingSyncEntries = 0;
+}
+
+bool BusTraceWriter6502::close()
+{
+	if (file == NULL) {
+		return false;
+	}
+
+	flush();
+
+	FileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+	header.version = FILE_VERSION;
+	header.blockSamples = BusTrace6502::BLOCK_SAMPLES;
+	header.sampleCount = sampleCount;
+	header.indexCount = index.size();
+	header.indexOffset = alignIndex(sizeof(FileHeader) + sampleCount * sizeof(BusTrace6502::Sample));
+	header.runCount = runs.size();
+	header.cycleOffsetCount = cycleOffsets.size();
+
+	const uint64_t cycleOffsetOffset = header.indexOffset + index.size() * sizeof(BusTrace6502::IndexEntry) + runs.size() * sizeof(BusTrace6502::Run);
+	const uint64_t cycleOffsetEnd = cycleOffsetOffset + cycleOffsets.size() * sizeof(uint32_t);
+	header.pcMaskOffset = pcIndex ? alignIndex(cycleOffsetEnd) : 0;
+
+	static const char padding[8] = { 0 };
+	const size_t paddingLength = static_cast<size_t>(header.indexOffset - sizeof(FileHeader) - sampleCount * sizeof(BusTrace6502::Sample));
+	bool ok = !failed && fwrite(padding, 1, paddingLength, file) == paddingLength;
+
+	if (ok && !index.empty()) {
+		ok = fwrite(index.data(), sizeof(BusTrace6502::IndexEntry), index.size(), file) == index.size();
+	}
+
+	if (ok && !runs.empty()) {
+		ok = fwrite(runs.data(), sizeof(BusTrace6502::Run), runs.size(), file) == runs.size();
+	}
+
+	if (ok && !cycleOffsets.empty()) {
+		ok = fwrite(cycleOffsets.data(), sizeof(uint32_t), cycleOffsets.size(), file) == cycleOffsets.size();
+	}
+
+	const size_t maskPaddingLength = pcIndex ? static_cast<size_t>(header.pcMaskOffset - cycleOffsetEnd) : 0;
+	ok = ok && fwrite(padding, 1, maskPaddingLength, file) == maskPaddingLength;
+
+	if (ok && !pcMasks.empty()) {
+		ok = fwrite(pcMasks.data(), sizeof(uint64_t), pcMasks.size(), file) == pcMasks.size();
+	}
+
+	if (pcIndex) {
+		uint64_t fetchBlockBegin[BusTrace6502::PC_BUCKET_COUNT + 1];
+		fetchBlockBegin[0] = 0;
+
+		for (size_t bucket = 0; bucket < BusTrace6502::PC_BUCKET_COUNT; bucket++) {
+			fetchBlockBegin[bucket + 1] = fetchBlockBegin[bucket] + fetchBlocks[bucket].size();
+		}
+
+		ok = ok && fwrite(fetchBlockBegin, sizeof(fetchBlockBegin), 1, file) == 1;
+
+		for (size_t bucket = 0; ok && bucket < BusTrace6502::PC_BUCKET_COUNT; bucket++) {
+			ok = fetchBlocks[bucket].empty() || fwrite(fetchBlocks[bucket].data(), sizeof(uint32_t), fetchBlocks[bucket].size(), file) == fetchBlocks[bucket].size();
+		}
+	}
+
+	ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = fclose(file) == 0 && ok;
+
+	file = NULL;
+	buffer.clear();
+	index.clear();
+	blockRuns.clear();
+	runs.clear();
+	cycleOffsets.clear();
+	pcMasks.clear();
+	fetchBlocks.clear();
+
+	return ok;
+}
+
+uint64_t BusTraceWriter6502::getSampleCount() const
+{
+	return sampleCount;
+}
+
+MappedBusTrace6502::MappedBusTrace6502() :
+	mapping(NULL),
+	mappingLength(0),
+#ifdef _WIN32
+	fileHandle(NULL),
+	mappingHandle(NULL),
+#endif
+	samples(NULL),
+	sampleCount(0),
+	index(NULL),
+	indexCount(0),
+	runs(NULL),
+	cycleOffsets(NULL),
+	pcMasks(NULL),
+	fetchBlockBegin(NULL),
+	fetchBlocks(NULL)
+{
+}
+
+MappedBusTrace6502::~MappedBusTrace6502()
+{
+	close();
+}
+
+bool MappedBusTrace6502::open(const char* path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader))) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE fileMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (fileMapping == NULL) {
+		CloseHandle(file);
+		return false;
+	}
+
+	mapping = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+	if (mapping == NULL) {
+		CloseHandle(fileMapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = fileMapping;
+	mappingLength = static_cast<size_t>(fileSize.QuadPart);
+#else
+	const int file = ::open(path, O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < sizeof(FileHeader)) {
+		::close(file);
+		return false;
+	}
+
+	void* mapped = mmap(NULL, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_SHARED, file, 0);
+	::close(file);
+
+	if (mapped == MAP_FAILED) {
+		return false;
+	}
+
+	mapping = mapped;
+	mappingLength = static_cast<size_t>(fileStat.st_size);
+#endif
+
+	const uint8_t* base = static_cast<const uint8_t*>(mapping);
+	const FileHeader* header = reinterpret_cast<const FileHeader*>(base);
+
+	if (memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header->version != FILE_VERSION ||
+		header->blockSamples != BusTrace6502::BLOCK_SAMPLES) {
+		close();
+		return false;
+	}
+
+	const uint64_t blockCount = (header->sampleCount + BusTrace6502::BLOCK_SAMPLES - 1) / BusTrace6502::BLOCK_SAMPLES;
+	const uint64_t pcMaskLength = blockCount * BusTrace6502::PC_MASK_WORDS * sizeof(uint64_t) + (BusTrace6502::PC_BUCKET_COUNT + 1) * sizeof(uint64_t);
+
+	if (header->sampleCount > (mappingLength - sizeof(FileHeader)) / sizeof(BusTrace6502::Sample) ||
+		header->indexOffset % 8 != 0 ||
+		header->indexOffset < sizeof(FileHeader) + header->sampleCount * sizeof(BusTrace6502::Sample) ||
+		header->indexOffset > mappingLength ||
+		header->indexCount != blockCount ||
+		header->indexCount > (mappingLength - header->indexOffset) / sizeof(BusTrace6502::IndexEntry) ||
+		header->runCount > (mappingLength - header->indexOffset - header->indexCount * sizeof(BusTrace6502::IndexEntry)) / sizeof(BusTrace6502::Run) ||
+		header->cycleOffsetCount > (mappingLength - header->indexOffset - header->indexCount * sizeof(BusTrace6502::IndexEntry) -
+			header->runCount * sizeof(BusTrace6502::Run)) / sizeof(uint32_t) ||
+		(header->pcMaskOffset != 0 &&
+			(header->pcMaskOffset % 8 != 0 ||
+			header->pcMaskOffset > mappingLength ||
+			blockCount > (mappingLength - header->pcMaskOffset) / (BusTrace6502::PC_MASK_WORDS * sizeof(uint64_t)) ||
+			pcMaskLength > mappingLength - header->pcMaskOffset))) {
+		close();
+		return false;
+	}
+
+	samples = reinterpret_cast<const BusTrace6502::Sample*>(base + sizeof(FileHeader));
+	sampleCount = static_cast<size_t>(header->sampleCount);
+	index = reinterpret_cast<const BusTrace6502::IndexEntry*>(base + header->indexOffset);
+	indexCount = static_cast<size_t>(header->indexCount);
+	runs = reinterpret_cast<const BusTrace6502::Run*>(index + indexCount);
+	cycleOffsets = reinterpret_cast<const uint32_t*>(runs + header->runCount);
+	pcMasks = header->pcMaskOffset != 0 ? reinterpret_cast<const uint64_t*>(base + header->pcMaskOffset) : NULL;
+	fetchBlockBegin = pcMasks != NULL ? pcMasks + blockCount * BusTrace6502::PC_MASK_WORDS : NULL;
+	fetchBlocks = pcMasks != NULL ? reinterpret_cast<const uint32_t*>(fetchBlockBegin + BusTrace6502::PC_BUCKET_COUNT + 1) : NULL;
+
+	// findFetch() trusts every block list to be sorted and inside the trace
+	if (pcMasks != NULL) {
+		const uint64_t fetchBlockCount = fetchBlockBegin[BusTrace6502::PC_BUCKET_COUNT];
+		bool valid = fetchBlockBegin[0] == 0 && fetchBlockCount <= (mappingLength - header->pcMaskOffset - pcMaskLength) / sizeof(uint32_t);
+
+		for (size_t bucket = 0; valid && bucket < BusTrace6502::PC_BUCKET_COUNT; bucket++) {
+			valid = fetchBlockBegin[bucket] <= fetchBlockBegin[bucket + 1] && fetchBlockBegin[bucket + 1] <= fetchBlockCount;
+
+			for (uint64_t i = fetchBlockBegin[bucket]; valid && i < fetchBlockBegin[bucket + 1]; i++) {
+				valid = fetchBlocks[i] < blockCount && (i == fetchBlockBegin[bucket] || fetchBlocks[i - 1] < fetchBlocks[i]);
+			}
+		}
+
+		if (!valid) {
+			close();
+			return false;
+		}
+	}
+
+	// the searches trust the runs and cycle offsets of every block to stay inside the block
+	for (size_t block = 0; block < indexCount; block++) {
+		const BusTrace6502::IndexEntry& entry = index[block];
+		const uint64_t blockStart = static_cast<uint64_t>(block) * BusTrace6502::BLOCK_SAMPLES;
+		const uint64_t blockLength = std::min(static_cast<uint64_t>(BusTrace6502::BLOCK_SAMPLES), header->sampleCount - blockStart);
+		const uint64_t count = entry.runCount == BusTrace6502::DENSE_RUNS ? blockLength : entry.runCount;
+		const uint64_t available = entry.runCount == BusTrace6502::DENSE_RUNS ? header->cycleOffsetCount : header->runCount;
+		bool valid = entry.gapOffset <= available && count <= available - entry.gapOffset;
+
+		if (valid && entry.runCount != BusTrace6502::DENSE_RUNS) {
+			for (uint64_t i = 0; valid && i < count; i++) {
+				const BusTrace6502::Run& run = runs[entry.gapOffset + i];
+				valid = run.sample > (i > 0 ? runs[entry.gapOffset + i - 1].sample : blockStart) && run.sample < blockStart + blockLength;
+			}
+		}
+
+		if (!valid) {
+			close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void MappedBusTrace6502::close()
+{
+	if (mapping != NULL) {
+#ifdef _WIN32
+		UnmapViewOfFile(mapping);
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		mappingHandle = NULL;
+		fileHandle = NULL;
+#else
+		munmap(mapping, mappingLength);
+#endif
+	}
+
+	mapping = NULL;
+	mappingLength = 0;
+	samples = NULL;
+	sampleCount = 0;
+	index = NULL;
+	indexCount = 0;
+	runs = NULL;
+	cycleOffsets = NULL;
+	pcMasks = NULL;
+	fetchBlockBegin = NULL;
+	fetchBlocks = NULL;
+}
+
+bool MappedBusTrace6502::isOpen() const
+{
+	return mapping != NULL;
+}
+
+bool MappedBusTrace6502::hasPcIndex() const
+{
+	return pcMasks != NULL;
+}
+
+const uint64_t* MappedBusTrace6502::getPcMask(size_t block) const
+{
+	return pcMasks != NULL ? pcMasks + block * BusTrace6502::PC_MASK_WORDS : NULL;
+}
+
+size_t MappedBusTrace6502::getSampleCount() const
+{
+	return sampleCount;
+}
+
+const BusTrace6502::Sample* MappedBusTrace6502::getSamples() const
+{
+	return samples;
+}
+
+uint64_t MappedBusTrace6502::cycleOfSample(size_t sample) const
+{
+	const size_t block = sample / BusTrace6502::BLOCK_SAMPLES;
+	const BusTrace6502::IndexEntry& entry = index[block];
+	const uint64_t blockStart = static_cast<uint64_t>(block) * BusTrace6502::BLOCK_SAMPLES;
+
+	if (entry.runCount == BusTrace6502::DENSE_RUNS) {
+		return entry.cycle + cycleOffsets[entry.gapOffset + (sample - blockStart)];
+	}
+
+	const BusTrace6502::Run* first = runs + entry.gapOffset;
+	const BusTrace6502::Run* next = std::upper_bound(first, first + entry.runCount, static_cast<uint64_t>(sample), compareRunSample);
+
+	return next == first ? entry.cycle + (sample - blockStart) : next[-1].cycle + (sample - next[-1].sample);
+}
+
+uint64_t MappedBusTrace6502::seekInBlock(size_t block, uint64_t cycle) const
+{
+	const BusTrace6502::IndexEntry& entry = index[block];
+	const uint64_t blockStart = static_cast<uint64_t>(block) * BusTrace6502::BLOCK_SAMPLES;
+	const uint64_t blockEnd = std::min(blockStart + BusTrace6502::BLOCK_SAMPLES, static_cast<uint64_t>(sampleCount));
+
+	if (entry.runCount == BusTrace6502::DENSE_RUNS) {
+		if (cycle - entry.cycle > 0xFFFFFFFF) {
+			return blockEnd;
+		}
+
+		const uint32_t* offsets = cycleOffsets + entry.gapOffset;
+		return blockStart + (std::lower_bound(offsets, offsets + (blockEnd - blockStart), static_cast<uint32_t>(cycle - entry.cycle)) - offsets);
+	}
+
+	const BusTrace6502::Run* first = runs + entry.gapOffset;
+	const BusTrace6502::Run* next = std::upper_bound(first, first + entry.runCount, cycle, compareRunCycle);
+	const uint64_t runCycle = next == first ? entry.cycle : next[-1].cycle;
+	const uint64_t runSample = next == first ? blockStart : next[-1].sample;
+	const uint64_t runEnd = next < first + entry.runCount ? next->sample : blockEnd;
+
+	// cycle falls into a gap when it is past the run, the next recorded cycle follows it
+	return cycle - runCycle < runEnd - runSample ? runSample + (cycle - runCycle) : runEnd;
+}
+
+uint64_t MappedBusTrace6502::seekCycle(uint64_t cycle) const
+{
+	if (indexCount == 0) {
+		return BusTrace6502::NO_SAMPLE;
+	}
+
+	const size_t next = static_cast<size_t>(std::upper_bound(index, index + indexCount, cycle, compareEntryCycle) - index);
+	if (next == 0) {
+		return 0;
+	}
+
+	const uint64_t sample = seekInBlock(next - 1, cycle);
+
+	return sample < sampleCount ? sample : BusTrace6502::NO_SAMPLE;
+}
+
+uint64_t MappedBusTrace6502::resyncPoint(uint64_t cycle) const
+{
+	const uint64_t start = seekCycle(cycle);
+	if (start == BusTrace6502::NO_SAMPLE) {
+		return start;
+	}
+
+	const size_t block = static_cast<size_t>(start / BusTrace6502::BLOCK_SAMPLES);
+	if (index[block].syncSample >= start) {
+		return index[block].syncSample;
+	}
+
+	const uint64_t end = std::min(static_cast<uint64_t>(block + 1) * BusTrace6502::BLOCK_SAMPLES, static_cast<uint64_t>(sampleCount));
+	for (uint64_t i = start; i < end; i++) {
+		if ((samples[i].flags & BusTrace6502::SYNC_FLAG) != 0) {
+			return i;
+		}
+	}
+
+	return block + 1 < indexCount ? index[block + 1].syncSample : BusTrace6502::NO_SAMPLE;
+}
+
+uint64_t MappedBusTrace6502::findFetch(uint16_t address, uint64_t cycle) const
+{
+	uint64_t sample = seekCycle(cycle);
+	if (sample == BusTrace6502::NO_SAMPLE) {
+		return sample;
+	}
+
+	const size_t bucket = address >> BusTrace6502::PC_BUCKET_SHIFT;
+
+	if (pcMasks == NULL) {
+		for (; sample < sampleCount; sample++) {
+			if (samples[sample].address == address && (samples[sample].flags & BusTrace6502::SYNC_FLAG) != 0) {
+				return sample;
+			}
+		}
+
+		return BusTrace6502::NO_SAMPLE;
+	}
+
+	// every listed block fetched from the bucket; only the other addresses of the bucket make a scan come up empty
+	const uint32_t* last = fetchBlocks + fetchBlockBegin[bucket + 1];
+	const uint32_t* block = std::lower_bound(fetchBlocks + fetchBlockBegin[bucket], last, static_cast<uint32_t>(sample / BusTrace6502::BLOCK_SAMPLES));
+
+	for (; block != last; ++block) {
+		const uint64_t blockStart = static_cast<uint64_t>(*block) * BusTrace6502::BLOCK_SAMPLES;
+		const uint64_t blockEnd = std::min(blockStart + BusTrace6502::BLOCK_SAMPLES, static_cast<uint64_t>(sampleCount));
+
+		for (sample = std::max(sample, blockStart); sample < blockEnd; sample++) {
+			if (samples[sample].address == address && (samples[sample].flags & BusTrace6502::SYNC_FLAG) != 0) {
+				return sample;
+			}
+		}
+	}
+
+	return BusTrace6502::NO_SAMPLE;
+}
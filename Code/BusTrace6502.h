@@ -0,0 +1,196 @@
+#ifndef BUS_TRACE_6502_H
+#define BUS_TRACE_6502_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Seekable container for per-cycle bus samples.
+// Samples are stored as captured, 4 Bytes each, followed by an index with one entry per block of BLOCK_SAMPLES samples.
+// A block whose cycle numbers skip also lists where each run of consecutive cycles starts; past DENSE_RUN_COUNT runs
+// it keeps one 32 bit cycle offset per sample instead, so a block's index stays within the size of its samples.
+// Any cycle is found with a binary search over the blocks and one within the block.
+// Every entry also records the first SYNC at or after its block start, where a decoder can start. The optional PC
+// index keeps, per block, one bit per PC_BUCKET_SIZE addresses fetched on SYNC, and per bucket the sorted list of blocks
+// with that bit set, so a fetch search is a binary search plus a scan of the blocks that fetched from the same bucket.
+class BusTrace6502
+{
+public:
+
+	enum SampleFlag {
+		SYNC_FLAG = 0x01,
+		READ_FLAG = 0x02
+	};
+
+	struct Sample {
+		uint16_t address;
+		uint8_t data;
+		uint8_t flags;
+	};
+
+	struct IndexEntry {
+		// Cycle of the first sample of the block
+		uint64_t cycle;
+		// First SYNC sample at or after the block start, NO_SAMPLE when there is none
+		uint64_t syncSample;
+		// First run, or first cycle offset when runCount is DENSE_RUNS, of the block
+		uint64_t gapOffset;
+		// Runs after the one the block starts with
+		uint64_t runCount;
+	};
+
+	struct Run {
+		uint64_t cycle;
+		uint64_t sample;
+	};
+
+	static const size_t BLOCK_SAMPLES = 4096;
+	static const unsigned PC_BUCKET_SHIFT = 6;
+	static const size_t PC_BUCKET_SIZE = 1 << PC_BUCKET_SHIFT;
+	static const size_t PC_BUCKET_COUNT = 0x10000 / PC_BUCKET_SIZE;
+	static const size_t PC_MASK_WORDS = PC_BUCKET_COUNT / 64;
+	static const uint64_t NO_SAMPLE = ~static_cast<uint64_t>(0);
+	// Runs take more room than cycle offsets past this; a block spanning 2^32 cycles or more has to keep its runs
+	static const size_t DENSE_RUN_COUNT = BLOCK_SAMPLES * sizeof(uint32_t) / sizeof(Run);
+	static const uint64_t DENSE_RUNS = ~static_cast<uint64_t>(0);
+};
+
+class BusTraceWriter6502
+{
+private:
+
+	FILE* file;
+	bool pcIndex;
+	bool failed;
+	uint64_t sampleCount;
+	uint64_t nextCycle;
+	size_t pendingSyncEntries;
+	std::vector<BusTrace6502::Sample> buffer;
+	std::vector<BusTrace6502::IndexEntry> index;
+	std::vector<BusTrace6502::Run> blockRuns;
+	std::vector<BusTrace6502::Run> runs;
+	std::vector<uint32_t> cycleOffsets;
+	std::vector<uint64_t> pcMasks;
+	// Blocks per PC bucket, in block order
+	std::vector<std::vector<uint32_t> > fetchBlocks;
+
+	void flush();
+
+	void startBlock(uint64_t cycle);
+
+	void addRun(uint64_t cycle);
+
+	void finishBlock();
+
+	void resolveSyncEntries();
+
+public:
+
+	BusTraceWriter6502();
+	~BusTraceWriter6502();
+
+	BusTraceWriter6502(const BusTraceWriter6502&) = delete;
+	BusTraceWriter6502& operator=(const BusTraceWriter6502&) = delete;
+
+	bool open(const char* path, bool pcIndex = true);
+
+	// Cycles must increase from sample to sample; they do not have to be consecutive
+	void add(uint64_t cycle, uint16_t address, uint8_t data, uint8_t flags)
+	{
+		if (sampleCount % BusTrace6502::BLOCK_SAMPLES == 0) {
+			startBlock(cycle);
+		}
+		else if (cycle != nextCycle) {
+			addRun(cycle);
+		}
+
+		if ((flags & BusTrace6502::SYNC_FLAG) != 0) {
+			if (pendingSyncEntries != 0) {
+				resolveSyncEntries();
+			}
+
+			if (pcIndex) {
+				const size_t bucket = address >> BusTrace6502::PC_BUCKET_SHIFT;
+				pcMasks[pcMasks.size() - BusTrace6502::PC_MASK_WORDS + bucket / 64] |= static_cast<uint64_t>(1) << (bucket % 64);
+			}
+		}
+
+		const BusTrace6502::Sample sample = { address, data, flags };
+		buffer.push_back(sample);
+		sampleCount++;
+		nextCycle = cycle + 1;
+
+		if (buffer.size() == BusTrace6502::BLOCK_SAMPLES) {
+			flush();
+		}
+	}
+
+	// Writes the index and the header; returns false when any write failed
+	bool close();
+
+	uint64_t getSampleCount() const;
+};
+
+// Read-only trace backed by a file written with BusTraceWriter6502
+class MappedBusTrace6502
+{
+private:
+
+	void* mapping;
+	size_t mappingLength;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+	const BusTrace6502::Sample* samples;
+	size_t sampleCount;
+	const BusTrace6502::IndexEntry* index;
+	size_t indexCount;
+	const BusTrace6502::Run* runs;
+	const uint32_t* cycleOffsets;
+	const uint64_t* pcMasks;
+	// PC_BUCKET_COUNT + 1 starts into fetchBlocks, one sorted block list per bucket
+	const uint64_t* fetchBlockBegin;
+	const uint32_t* fetchBlocks;
+
+	// First sample of block at or after cycle, the block end when there is none
+	uint64_t seekInBlock(size_t block, uint64_t cycle) const;
+
+public:
+
+	MappedBusTrace6502();
+	~MappedBusTrace6502();
+
+	MappedBusTrace6502(const MappedBusTrace6502&) = delete;
+	MappedBusTrace6502& operator=(const MappedBusTrace6502&) = delete;
+
+	bool open(const char* path);
+
+	void close();
+
+	bool isOpen() const;
+
+	bool hasPcIndex() const;
+
+	// PC_MASK_WORDS words with one bit per PC bucket fetched in block, NULL without a PC index
+	const uint64_t* getPcMask(size_t block) const;
+
+	size_t getSampleCount() const;
+
+	const BusTrace6502::Sample* getSamples() const;
+
+	uint64_t cycleOfSample(size_t sample) const;
+
+	// First sample at or after cycle, NO_SAMPLE past the end of the trace
+	uint64_t seekCycle(uint64_t cycle) const;
+
+	// First SYNC sample at or after cycle, where decoding can resume
+	uint64_t resyncPoint(uint64_t cycle) const;
+
+	// First SYNC sample at or after cycle fetching address. With a PC index this searches the blocks of address's bucket
+	// from the block of cycle on, otherwise every sample from cycle on
+	uint64_t findFetch(uint16_t address, uint64_t cycle) const;
+};
+
+#endif
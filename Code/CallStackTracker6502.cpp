@@ -0,0 +1,303 @@
+#include "CallStackTracker6502.h"
+#include "DecodeCore6502.h"
+#include "Disassembler6502.h"
+
+#include <cstring>
+
+namespace {
+
+	const uint32_t NO_NODE = 0xFFFFFFFF;
+
+	enum ControlEffect {
+		SEQUENTIAL_EFFECT,
+		CALL_EFFECT,
+		BREAK_EFFECT,
+		RETURN_EFFECT,
+		RETURN_FROM_INTERRUPT_EFFECT,
+		ABSOLUTE_JUMP_EFFECT,
+		INDIRECT_JUMP_EFFECT,
+		BRANCH_EFFECT
+	};
+
+	ControlEffect effectFromOpcode(const Disassembler6502::Opcode opcode, const Disassembler6502::AddressingMode addressingMode)
+	{
+		switch (opcode)
+		{
+		case Disassembler6502::JSR_INSTR:
+			return CALL_EFFECT;
+		case Disassembler6502::BRK_INSTR:
+			return BREAK_EFFECT;
+		case Disassembler6502::RTS_INSTR:
+			return RETURN_EFFECT;
+		case Disassembler6502::RTI_INSTR:
+			return RETURN_FROM_INTERRUPT_EFFECT;
+		case Disassembler6502::JMP_INSTR:
+			return addressingMode == Disassembler6502::ABSOLUTE_AM ? ABSOLUTE_JUMP_EFFECT : INDIRECT_JUMP_EFFECT;
+		default:
+			return addressingMode == Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM ? BRANCH_EFFECT : SEQUENTIAL_EFFECT;
+		}
+	}
+
+	struct EffectTable {
+		uint8_t effects[256];
+
+		EffectTable()
+		{
+			for (size_t i = 0; i < 256; i++) {
+				const DecodeCore6502::Descriptor& descriptor = DecodeCore6502::TABLE.entries[i];
+
+				effects[i] = static_cast<uint8_t>(descriptor.opcode != DecodeCore6502::INVALID_OPCODE ?
+					effectFromOpcode(static_cast<Disassembler6502::Opcode>(descriptor.opcode), static_cast<Disassembler6502::AddressingMode>(descriptor.addressingMode)) :
+					SEQUENTIAL_EFFECT);
+			}
+		}
+	};
+
+	const uint8_t* effectTable()
+	{
+		static const EffectTable table;
+		return table.effects;
+	}
+
+}
+
+CallStackTracker6502::CallStackTracker6502(size_t maxNodes) :
+	routines(0x10000),
+	activeFrames(0x10000, 0),
+	maxNodes(maxNodes > 0 ? maxNodes : 1),
+	depth(0),
+	totalCycles(0),
+	unmatchedReturns(0),
+	droppedFrames(0),
+	hasPrevious(false),
+	previousAddress(0),
+	previousOpcode(0),
+	previousOperand(0)
+{
+	nodes.push_back({ NO_NODE, NO_NODE, NO_NODE, 0, 0 });
+}
+
+uint32_t CallStackTracker6502::childNode(uint32_t parent, uint16_t routine)
+{
+	for (uint32_t child = nodes[parent].firstChild; child != NO_NODE; child = nodes[child].nextSibling) {
+		if (nodes[child].routine == routine) {
+			return child;
+		}
+	}
+
+	// out of nodes: new paths are folded into their caller
+	if (nodes.size() >= maxNodes) {
+		return parent;
+	}
+
+	const uint32_t child = static_cast<uint32_t>(nodes.size());
+	nodes.push_back({ parent, NO_NODE, nodes[parent].firstChild, routine, 0 });
+	nodes[parent].firstChild = child;
+
+	return child;
+}
+
+void CallStackTracker6502::pushFrame(uint16_t routine, uint16_t returnAddress, bool interrupt, uint16_t alternateReturnAddress, uint8_t deferredReturn)
+{
+	const uint32_t parentNode = depth > 0 ? frames[depth - 1].node : 0;
+
+	if (depth == MAX_DEPTH) {
+		// runaway recursion or a stack reset we could not see: forget the outermost frame
+		closeFrame(frames[0]);
+		memmove(frames, frames + 1, sizeof(Frame) * (MAX_DEPTH - 1));
+		depth--;
+		droppedFrames++;
+	}
+
+	frames[depth] = { childNode(parentNode, routine), routine, returnAddress, alternateReturnAddress, totalCycles, interrupt, deferredReturn };
+	depth++;
+	routines[routine].calls++;
+	activeFrames[routine]++;
+}
+
+void CallStackTracker6502::closeFrame(const Frame& frame)
+{
+	if (--activeFrames[frame.routine] == 0) {
+		routines[frame.routine].inclusiveCycles += totalCycles - frame.entryCycles;
+	}
+}
+
+void CallStackTracker6502::popFrames(size_t newDepth)
+{
+	while (depth > newDepth) {
+		closeFrame(frames[--depth]);
+	}
+}
+
+bool CallStackTracker6502::returnTo(uint16_t address, bool interrupt)
+{
+	// RTS lands one past the address JSR pushed, RTI lands on the pushed address itself
+	const uint16_t offset = interrupt ? 0 : 1;
+
+	for (size_t i = depth; i-- > 1;) {
+		const Frame& frame = frames[i];
+
+		if (frame.interrupt != interrupt || frame.deferredReturn != NO_DEFERRED_RETURN) {
+			continue;
+		}
+
+		if (static_cast<uint16_t>(frame.returnAddress + offset) == address || static_cast<uint16_t>(frame.alternateReturnAddress + offset) == address) {
+			popFrames(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void CallStackTracker6502::handleReturn(uint16_t address, bool interrupt)
+{
+	if (returnTo(address, interrupt)) {
+		return;
+	}
+
+	if (interrupt) {
+		// the handler of an interrupt taken right after a return: close it and redo that return
+		for (size_t i = depth; i-- > 1;) {
+			if (frames[i].deferredReturn == NO_DEFERRED_RETURN) {
+				continue;
+			}
+
+			const bool deferredInterrupt = frames[i].deferredReturn == DEFERRED_RTI;
+			popFrames(i);
+
+			if (returnTo(address, deferredInterrupt)) {
+				unmatchedReturns--;
+			}
+			return;
+		}
+	}
+
+	unmatchedReturns++;
+
+	// a jump through RTS replaces the frame the previous one opened, so dispatch loops do not pile up frames
+	if (!interrupt && depth > 1 && frames[depth - 1].deferredReturn == DEFERRED_RTS) {
+		popFrames(depth - 1);
+	}
+
+	pushFrame(address, address, true, address, interrupt ? DEFERRED_RTI : DEFERRED_RTS);
+}
+
+void CallStackTracker6502::transition(uint16_t address, uint8_t opcodeData, uint16_t operand, uint16_t nextAddress)
+{
+	const DecodeCore6502::Descriptor descriptor = DecodeCore6502::descriptor(opcodeData);
+	const uint16_t fallThrough = static_cast<uint16_t>(address + 1 + descriptor.operandLength);
+
+	switch (effectTable()[opcodeData])
+	{
+	case CALL_EFFECT:
+		pushFrame(operand, static_cast<uint16_t>(address + 2), false, static_cast<uint16_t>(address + 2));
+		if (nextAddress != operand) {
+			// interrupted before the first instruction of the subroutine
+			pushFrame(nextAddress, operand, true, operand);
+		}
+		break;
+	case BREAK_EFFECT:
+		pushFrame(nextAddress, static_cast<uint16_t>(address + 2), true, static_cast<uint16_t>(address + 2));
+		break;
+	case RETURN_EFFECT:
+		handleReturn(nextAddress, false);
+		break;
+	case RETURN_FROM_INTERRUPT_EFFECT:
+		handleReturn(nextAddress, true);
+		break;
+	case ABSOLUTE_JUMP_EFFECT:
+		if (nextAddress != operand) {
+			pushFrame(nextAddress, operand, true, operand);
+		}
+		break;
+	case BRANCH_EFFECT: {
+		const uint16_t target = DecodeCore6502::operandValue(descriptor, operand, address);
+		if (nextAddress != target && nextAddress != fallThrough) {
+			// either way the branch went, the handler returns there
+			pushFrame(nextAddress, fallThrough, true, target);
+		}
+		break;
+	}
+	case INDIRECT_JUMP_EFFECT:
+		break;
+	default:
+		if (nextAddress != fallThrough) {
+			pushFrame(nextAddress, fallThrough, true, fallThrough);
+		}
+		break;
+	}
+}
+
+void CallStackTracker6502::addInstruction(uint16_t address, uint8_t opcodeData, uint16_t operand, uint32_t cycles)
+{
+	if (hasPrevious) {
+		transition(previousAddress, previousOpcode, previousOperand, address);
+	}
+	else if (depth == 0) {
+		nodes[0].routine = address;
+		frames[0] = { 0, address, 0, 0, totalCycles, false, NO_DEFERRED_RETURN };
+		depth = 1;
+		routines[address].calls++;
+		activeFrames[address]++;
+	}
+
+	const Frame& top = frames[depth - 1];
+
+	totalCycles += cycles;
+	routines[top.routine].exclusiveCycles += cycles;
+	nodes[top.node].selfCycles += cycles;
+
+	hasPrevious = true;
+	previousAddress = address;
+	previousOpcode = opcodeData;
+	previousOperand = operand;
+}
+
+void CallStackTracker6502::finish()
+{
+	popFrames(0);
+	hasPrevious = false;
+}
+
+const CallStackTracker6502::RoutineStats& CallStackTracker6502::routine(uint16_t address) const
+{
+	return routines[address];
+}
+
+size_t CallStackTracker6502::getDepth() const
+{
+	return depth;
+}
+
+uint64_t CallStackTracker6502::getUnmatchedReturns() const
+{
+	return unmatchedReturns;
+}
+
+uint64_t CallStackTracker6502::getDroppedFrames() const
+{
+	return droppedFrames;
+}
+
+void CallStackTracker6502::writeFolded(FILE* file) const
+{
+	std::vector<uint16_t> path;
+
+	for (size_t i = 0; i < nodes.size(); i++) {
+		if (nodes[i].selfCycles == 0) {
+			continue;
+		}
+
+		path.clear();
+		for (uint32_t node = static_cast<uint32_t>(i); node != NO_NODE; node = nodes[node].parent) {
+			path.push_back(nodes[node].routine);
+		}
+
+		for (size_t j = path.size(); j-- > 0;) {
+			fprintf(file, j > 0 ? "$%04X;" : "$%04X", path[j]);
+		}
+
+		fprintf(file, " %llu\n", static_cast<unsigned long long>(nodes[i].selfCycles));
+	}
+}
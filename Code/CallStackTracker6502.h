@@ -0,0 +1,113 @@
+#ifndef CALL_STACK_TRACKER_6502_H
+#define CALL_STACK_TRACKER_6502_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Rebuilds the call stack from an executed instruction trace in one pass.
+// JSR and BRK push a frame, and RTS/RTI pop back to the frame whose return address they land on; one that lands below
+// the top (PLA PLA before RTS) drops the frames above it.
+// An instruction followed by an address it cannot reach on its own is an interrupt entry: anything but the fall-through
+// after sequential code, anything but the target or fall-through after a branch, anything but the operand after JSR or JMP absolute.
+// An RTS or RTI that lands on no frame's return address is either used as a jump or was followed right away by an interrupt.
+// It opens a frame for where it landed; an RTI landing nowhere else closes that frame and redoes the return,
+// otherwise it stays until a return to an outer frame, or the next such jump, replaces it.
+// Memory is bounded by MAX_DEPTH frames, one slot per routine address and maxNodes distinct call paths.
+class CallStackTracker6502
+{
+public:
+
+	static const size_t MAX_DEPTH = 256;
+	static const size_t DEFAULT_MAX_NODES = 1 << 20;
+
+	struct RoutineStats {
+		uint64_t calls;
+		// Counted from the outermost active frame only, so recursion does not count the same cycles twice
+		uint64_t inclusiveCycles;
+		uint64_t exclusiveCycles;
+	};
+
+private:
+
+	enum DeferredReturn {
+		NO_DEFERRED_RETURN,
+		DEFERRED_RTS,
+		DEFERRED_RTI
+	};
+
+	struct Frame {
+		uint32_t node;
+		uint16_t routine;
+		uint16_t returnAddress;
+		// The other address an interrupt after a branch may return to, returnAddress otherwise
+		uint16_t alternateReturnAddress;
+		uint64_t entryCycles;
+		bool interrupt;
+		// The return that opened this frame by landing on no other frame's return address
+		uint8_t deferredReturn;
+	};
+
+	// Call tree node; the path from the root is one folded stack line
+	struct Node {
+		uint32_t parent;
+		uint32_t firstChild;
+		uint32_t nextSibling;
+		uint16_t routine;
+		uint64_t selfCycles;
+	};
+
+	std::vector<RoutineStats> routines;
+	// Frames of each routine on the stack
+	std::vector<uint32_t> activeFrames;
+	std::vector<Node> nodes;
+	size_t maxNodes;
+	Frame frames[MAX_DEPTH];
+	size_t depth;
+	uint64_t totalCycles;
+	uint64_t unmatchedReturns;
+	uint64_t droppedFrames;
+
+	bool hasPrevious;
+	uint16_t previousAddress;
+	uint8_t previousOpcode;
+	uint16_t previousOperand;
+
+	uint32_t childNode(uint32_t parent, uint16_t routine);
+
+	void pushFrame(uint16_t routine, uint16_t returnAddress, bool interrupt, uint16_t alternateReturnAddress, uint8_t deferredReturn = NO_DEFERRED_RETURN);
+
+	void closeFrame(const Frame& frame);
+
+	void popFrames(size_t newDepth);
+
+	bool returnTo(uint16_t address, bool interrupt);
+
+	void handleReturn(uint16_t address, bool interrupt);
+
+	void transition(uint16_t address, uint8_t opcodeData, uint16_t operand, uint16_t nextAddress);
+
+public:
+
+	explicit CallStackTracker6502(size_t maxNodes = DEFAULT_MAX_NODES);
+
+	// operand is the instruction's operand as decoded, it is checked against where JSR, JMP absolute and branches go
+	void addInstruction(uint16_t address, uint8_t opcodeData, uint16_t operand, uint32_t cycles);
+
+	// Closes the frames still open at the end of the trace so their inclusive cycles are counted
+	void finish();
+
+	const RoutineStats& routine(uint16_t address) const;
+
+	size_t getDepth() const;
+
+	uint64_t getUnmatchedReturns() const;
+
+	uint64_t getDroppedFrames() const;
+
+	// One "outer;inner;innermost cycles" line per call path, the input format of flamegraph.pl
+	void writeFolded(FILE* file) const;
+};
+
+#endif
@@ -0,0 +1,299 @@
+#include "CodeDataClassifier6502.h"
+#include "BoundaryResolver6502.h"
+#include "DecodeCore6502.h"
+#include "Disassembler6502.h"
+
+namespace {
+
+	enum OpcodeClass {
+		LOAD_CLASS,
+		STORE_CLASS,
+		ARITHMETIC_CLASS,
+		COMPARE_CLASS,
+		REGISTER_CLASS,
+		BRANCH_CLASS,
+		JUMP_CLASS,
+		STACK_CLASS,
+		FLAG_CLASS,
+		RARE_CLASS,
+		INVALID_CLASS,
+		OPCODE_CLASS_COUNT
+	};
+
+	OpcodeClass classFromOpcode(Disassembler6502::Opcode opcode)
+	{
+		switch (opcode)
+		{
+		case Disassembler6502::LDA_INSTR:
+		case Disassembler6502::LDX_INSTR:
+		case Disassembler6502::LDY_INSTR:
+			return LOAD_CLASS;
+		case Disassembler6502::STA_INSTR:
+		case Disassembler6502::STX_INSTR:
+		case Disassembler6502::STY_INSTR:
+		case Disassembler6502::STZ_INSTR:
+			return STORE_CLASS;
+		case Disassembler6502::ADC_INSTR:
+		case Disassembler6502::SBC_INSTR:
+		case Disassembler6502::AND_INSTR:
+		case Disassembler6502::ORA_INSTR:
+		case Disassembler6502::EOR_INSTR:
+		case Disassembler6502::ASL_INSTR:
+		case Disassembler6502::LSR_INSTR:
+		case Disassembler6502::ROL_INSTR:
+		case Disassembler6502::ROR_INSTR:
+		case Disassembler6502::INC_INSTR:
+		case Disassembler6502::DEC_INSTR:
+		case Disassembler6502::BIT_INSTR:
+		case Disassembler6502::TRB_INSTR:
+		case Disassembler6502::TSB_INSTR:
+			return ARITHMETIC_CLASS;
+		case Disassembler6502::CMP_INSTR:
+		case Disassembler6502::CPX_INSTR:
+		case Disassembler6502::CPY_INSTR:
+			return COMPARE_CLASS;
+		case Disassembler6502::INX_INSTR:
+		case Disassembler6502::INY_INSTR:
+		case Disassembler6502::DEX_INSTR:
+		case Disassembler6502::DEY_INSTR:
+		case Disassembler6502::TAX_INSTR:
+		case Disassembler6502::TAY_INSTR:
+		case Disassembler6502::TXA_INSTR:
+		case Disassembler6502::TYA_INSTR:
+		case Disassembler6502::TSX_INSTR:
+		case Disassembler6502::TXS_INSTR:
+			return REGISTER_CLASS;
+		case Disassembler6502::BCC_INSTR:
+		case Disassembler6502::BCS_INSTR:
+		case Disassembler6502::BEQ_INSTR:
+		case Disassembler6502::BMI_INSTR:
+		case Disassembler6502::BNE_INSTR:
+		case Disassembler6502::BPL_INSTR:
+		case Disassembler6502::BVC_INSTR:
+		case Disassembler6502::BVS_INSTR:
+			return BRANCH_CLASS;
+		case Disassembler6502::BRA_INSTR:
+		case Disassembler6502::JMP_INSTR:
+		case Disassembler6502::JSR_INSTR:
+		case Disassembler6502::RTS_INSTR:
+		case Disassembler6502::RTI_INSTR:
+			return JUMP_CLASS;
+		case Disassembler6502::PHA_INSTR:
+		case Disassembler6502::PHP_INSTR:
+		case Disassembler6502::PHX_INSTR:
+		case Disassembler6502::PHY_INSTR:
+		case Disassembler6502::PLA_INSTR:
+		case Disassembler6502::PLP_INSTR:
+		case Disassembler6502::PLX_INSTR:
+		case Disassembler6502::PLY_INSTR:
+			return STACK_CLASS;
+		case Disassembler6502::CLC_INSTR:
+		case Disassembler6502::CLD_INSTR:
+		case Disassembler6502::CLI_INSTR:
+		case Disassembler6502::CLV_INSTR:
+		case Disassembler6502::SEC_INSTR:
+		case Disassembler6502::SED_INSTR:
+		case Disassembler6502::SEI_INSTR:
+		case Disassembler6502::NOP_INSTR:
+			return FLAG_CLASS;
+		default:
+			// BRK, STP, WAI and the 65C02 bit instructions are rare in real code but common in padding and graphics
+			return RARE_CLASS;
+		}
+	}
+
+	const int32_t CLASS_SCORE[OPCODE_CLASS_COUNT] = {
+		4,   // LOAD_CLASS
+		4,   // STORE_CLASS
+		2,   // ARITHMETIC_CLASS
+		2,   // COMPARE_CLASS
+		2,   // REGISTER_CLASS
+		2,   // BRANCH_CLASS
+		3,   // JUMP_CLASS
+		1,   // STACK_CLASS
+		1,   // FLAG_CLASS
+		-6,  // RARE_CLASS
+		-16  // INVALID_CLASS
+	};
+
+	int32_t pairScore(OpcodeClass previous, OpcodeClass current)
+	{
+		if (current == BRANCH_CLASS) {
+			switch (previous)
+			{
+			case COMPARE_CLASS:
+				return 4;
+			case REGISTER_CLASS:
+				return 3;
+			case LOAD_CLASS:
+			case ARITHMETIC_CLASS:
+				return 2;
+			default:
+				return 0;
+			}
+		}
+
+		if (previous == LOAD_CLASS && current == STORE_CLASS) {
+			return 2;
+		}
+
+		if ((previous == LOAD_CLASS || previous == FLAG_CLASS) && current == ARITHMETIC_CLASS) {
+			return 1;
+		}
+
+		if (previous == ARITHMETIC_CLASS && current == STORE_CLASS) {
+			return 1;
+		}
+
+		if (previous == RARE_CLASS && current == RARE_CLASS) {
+			return -4;
+		}
+
+		return 0;
+	}
+
+	const int32_t TARGET_ON_INSTRUCTION_SCORE = 3;
+	const int32_t TARGET_INSIDE_INSTRUCTION_SCORE = -4;
+	const int32_t RELATIVE_TARGET_OUTSIDE_SCORE = -2;
+	const int32_t ABSOLUTE_ZERO_PAGE_OPERAND_SCORE = -3;
+
+	const int32_t WINDOW_SCORE_SCALE = 16;
+
+	struct OpcodeFeatures {
+		uint8_t opcodeClasses[256];
+
+		OpcodeFeatures()
+		{
+			for (size_t i = 0; i < 256; i++) {
+				const uint8_t opcode = DecodeCore6502::TABLE.entries[i].opcode;
+
+				opcodeClasses[i] = static_cast<uint8_t>(opcode != DecodeCore6502::INVALID_OPCODE ? classFromOpcode(static_cast<Disassembler6502::Opcode>(opcode)) : INVALID_CLASS);
+			}
+		}
+	};
+
+	const OpcodeFeatures& opcodeFeatures()
+	{
+		static const OpcodeFeatures features;
+		return features;
+	}
+
+	int32_t targetScore(const uint8_t* instructionStarts, size_t length, long target)
+	{
+		if (target < 0 || static_cast<size_t>(target) >= length) {
+			return 0;
+		}
+
+		return instructionStarts[target] ? TARGET_ON_INSTRUCTION_SCORE : TARGET_INSIDE_INSTRUCTION_SCORE;
+	}
+
+}
+
+CodeDataClassifier6502::Options::Options() :
+	windowLength(64),
+	step(16),
+	threshold(0),
+	baseAddress(0),
+	threadCount(0)
+{
+}
+
+void CodeDataClassifier6502::scoreInstructions(const uint8_t* data, size_t length, const uint8_t* instructionStarts, uint16_t baseAddress, int32_t* scores)
+{
+	const OpcodeFeatures& features = opcodeFeatures();
+
+	// unigram score for every byte, masked down to opcode positions
+	for (size_t i = 0; i < length; i++) {
+		scores[i] = CLASS_SCORE[features.opcodeClasses[data[i]]] * instructionStarts[i];
+	}
+
+	OpcodeClass previous = INVALID_CLASS;
+
+	for (size_t i = 0; i < length; i++) {
+		if (!instructionStarts[i]) {
+			continue;
+		}
+
+		const uint8_t opcodeByte = data[i];
+		const OpcodeClass current = static_cast<OpcodeClass>(features.opcodeClasses[opcodeByte]);
+		const DecodeCore6502::Descriptor& descriptor = DecodeCore6502::TABLE.entries[opcodeByte];
+		const size_t operandLength = descriptor.operandLength;
+
+		scores[i] += pairScore(previous, current);
+		previous = current;
+
+		if (current == INVALID_CLASS || i + operandLength >= length) {
+			continue;
+		}
+
+		if (descriptor.addressingMode == Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM) {
+			const long target = static_cast<long>(i) + 2 + static_cast<int8_t>(data[i + 1]);
+			const int32_t score = targetScore(instructionStarts, length, target);
+
+			scores[i] += score != 0 ? score : RELATIVE_TARGET_OUTSIDE_SCORE;
+		}
+		else if (operandLength == 2) {
+			const uint16_t operand = static_cast<uint16_t>(data[i + 1] | (data[i + 2] << 8));
+
+			if (current == JUMP_CLASS && descriptor.addressingMode == Disassembler6502::ABSOLUTE_AM) {
+				scores[i] += targetScore(instructionStarts, length, static_cast<long>(static_cast<uint16_t>(operand - baseAddress)));
+			}
+			else if (operand < 0x100 && current != JUMP_CLASS) {
+				// an assembler would have picked the zero page form
+				scores[i] += ABSOLUTE_ZERO_PAGE_OPERAND_SCORE;
+			}
+		}
+	}
+}
+
+std::vector<CodeDataClassifier6502::Region> CodeDataClassifier6502::classify(const uint8_t* data, size_t length, const Options& options)
+{
+	std::vector<Region> regions;
+
+	if (length == 0 || options.step == 0) {
+		return regions;
+	}
+
+	std::vector<uint8_t> instructionStarts(length);
+	BoundaryResolver6502::resolve(data, length, 0, instructionStarts.data(), options.threadCount);
+
+	std::vector<int32_t> scores(length);
+	scoreInstructions(data, length, instructionStarts.data(), options.baseAddress, scores.data());
+
+	std::vector<int64_t> scoreSums(length + 1);
+	std::vector<uint32_t> instructionCounts(length + 1);
+	scoreSums[0] = 0;
+	instructionCounts[0] = 0;
+
+	for (size_t i = 0; i < length; i++) {
+		scoreSums[i + 1] = scoreSums[i] + scores[i];
+		instructionCounts[i + 1] = instructionCounts[i] + instructionStarts[i];
+	}
+
+	const size_t halfWindow = options.windowLength / 2;
+
+	for (size_t begin = 0; begin < length; begin += options.step) {
+		const size_t end = begin + options.step < length ? begin + options.step : length;
+		const size_t center = begin + (end - begin) / 2;
+		const size_t windowBegin = center > halfWindow ? center - halfWindow : 0;
+		const size_t windowEnd = center + halfWindow < length ? center + halfWindow : length;
+
+		const int64_t sum = scoreSums[windowEnd] - scoreSums[windowBegin];
+		const uint32_t count = instructionCounts[windowEnd] - instructionCounts[windowBegin];
+		const int32_t score = static_cast<int32_t>(sum * WINDOW_SCORE_SCALE / (count > 0 ? count : 1));
+		const bool isCode = score >= options.threshold * WINDOW_SCORE_SCALE;
+
+		if (!regions.empty() && regions.back().isCode == isCode) {
+			Region& region = regions.back();
+			const size_t steps = (region.end - region.begin + options.step - 1) / options.step;
+
+			region.score = static_cast<int32_t>((static_cast<int64_t>(region.score) * static_cast<int64_t>(steps) + score) / static_cast<int64_t>(steps + 1));
+			region.end = end;
+		}
+		else {
+			regions.push_back({ begin, end, isCode, score });
+		}
+	}
+
+	return regions;
+}
@@ -0,0 +1,40 @@
+#ifndef CODE_DATA_CLASSIFIER_6502_H
+#define CODE_DATA_CLASSIFIER_6502_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Scores a raw image for code-likeness before it is disassembled.
+// The image is swept once, every decoded instruction gets a score from its opcode class,
+// the class of the instruction before it, where its branch or jump lands and what its absolute operand looks like,
+// and windows sliding over the image are labeled code when their average score reaches the threshold.
+class CodeDataClassifier6502
+{
+public:
+
+	struct Options {
+		size_t windowLength;
+		size_t step;
+		int32_t threshold;
+		uint16_t baseAddress;
+		unsigned threadCount;
+
+		Options();
+	};
+
+	struct Region {
+		size_t begin;
+		size_t end;
+		bool isCode;
+		// Average window score over the region, 16 per point of instruction score
+		int32_t score;
+	};
+
+	// Writes one score per byte, non-zero only on the opcodes marked in instructionStarts
+	static void scoreInstructions(const uint8_t* data, size_t length, const uint8_t* instructionStarts, uint16_t baseAddress, int32_t* scores);
+
+	static std::vector<Region> classify(const uint8_t* data, size_t length, const Options& options = Options());
+};
+
+#endif
@@ -0,0 +1,225 @@
+#include "CycleTable6502.h"
+#include "DecodeCore6502.h"
+
+namespace {
+
+	bool isReadModifyWrite(const Disassembler6502::Opcode opcode)
+	{
+		switch (opcode)
+		{
+		case Disassembler6502::ASL_INSTR:
+		case Disassembler6502::LSR_INSTR:
+		case Disassembler6502::ROL_INSTR:
+		case Disassembler6502::ROR_INSTR:
+		case Disassembler6502::INC_INSTR:
+		case Disassembler6502::DEC_INSTR:
+		case Disassembler6502::TRB_INSTR:
+		case Disassembler6502::TSB_INSTR:
+		case Disassembler6502::RMB0_INSTR:
+		case Disassembler6502::RMB1_INSTR:
+		case Disassembler6502::RMB2_INSTR:
+		case Disassembler6502::RMB3_INSTR:
+		case Disassembler6502::RMB4_INSTR:
+		case Disassembler6502::RMB5_INSTR:
+		case Disassembler6502::RMB6_INSTR:
+		case Disassembler6502::RMB7_INSTR:
+		case Disassembler6502::SMB0_INSTR:
+		case Disassembler6502::SMB1_INSTR:
+		case Disassembler6502::SMB2_INSTR:
+		case Disassembler6502::SMB3_INSTR:
+		case Disassembler6502::SMB4_INSTR:
+		case Disassembler6502::SMB5_INSTR:
+		case Disassembler6502::SMB6_INSTR:
+		case Disassembler6502::SMB7_INSTR:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool isStore(const Disassembler6502::Opcode opcode)
+	{
+		return opcode == Disassembler6502::STA_INSTR ||
+			opcode == Disassembler6502::STX_INSTR ||
+			opcode == Disassembler6502::STY_INSTR ||
+			opcode == Disassembler6502::STZ_INSTR;
+	}
+
+	uint8_t costFlagsFromInstruction(const Disassembler6502::Opcode opcode, const Disassembler6502::AddressingMode addressingMode)
+	{
+		uint8_t flags = 0;
+
+		if (opcode == Disassembler6502::ADC_INSTR || opcode == Disassembler6502::SBC_INSTR) {
+			flags |= CycleTable6502::DECIMAL_COST;
+		}
+
+		switch (addressingMode)
+		{
+		case Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM:
+			flags |= CycleTable6502::PAGE_CROSS_COST;
+			// BRA is always taken, so the taken cycle is part of its base cost
+			if (opcode != Disassembler6502::BRA_INSTR) {
+				flags |= CycleTable6502::BRANCH_COST;
+			}
+			break;
+		case Disassembler6502::ABSOLUTE_INDEXED_WITH_X_AM:
+			// the 65C02 shifts still take the page crossing cycle, INC and DEC always pay it
+			if (!isStore(opcode) && opcode != Disassembler6502::INC_INSTR && opcode != Disassembler6502::DEC_INSTR) {
+				flags |= CycleTable6502::PAGE_CROSS_COST;
+			}
+			break;
+		case Disassembler6502::ABSOLUTE_INDEXED_WITH_Y_AM:
+		case Disassembler6502::ZERO_PAGE_INDIRECT_INDEXED_WITH_Y_AM:
+			if (!isStore(opcode)) {
+				flags |= CycleTable6502::PAGE_CROSS_COST;
+			}
+			break;
+		default:
+			break;
+		}
+
+		return flags;
+	}
+
+	// The undefined opcodes are NOPs on the 65C02; most take one cycle, the ones below read operand bytes first
+	uint8_t undefinedOpcodeCycles(uint8_t opcodeData)
+	{
+		switch (opcodeData)
+		{
+		case 0x02:
+		case 0x22:
+		case 0x42:
+		case 0x62:
+		case 0x82:
+		case 0xC2:
+		case 0xE2:
+			return 2;
+		case 0x44:
+			return 3;
+		case 0x54:
+		case 0xD4:
+		case 0xF4:
+		case 0xDC:
+		case 0xFC:
+			return 4;
+		case 0x5C:
+			return 8;
+		default:
+			return 1;
+		}
+	}
+
+	struct CostTable {
+		CycleTable6502::Cost costs[256];
+
+		CostTable()
+		{
+			for (size_t i = 0; i < 256; i++) {
+				const DecodeCore6502::Descriptor& descriptor = DecodeCore6502::TABLE.entries[i];
+				const Disassembler6502::Opcode opcode = static_cast<Disassembler6502::Opcode>(descriptor.opcode);
+				const Disassembler6502::AddressingMode addressingMode = static_cast<Disassembler6502::AddressingMode>(descriptor.addressingMode);
+
+				if (descriptor.opcode == DecodeCore6502::INVALID_OPCODE) {
+					costs[i] = { undefinedOpcodeCycles(static_cast<uint8_t>(i)), 0 };
+					continue;
+				}
+
+				costs[i] = {
+					CycleTable6502::baseCyclesFromInstruction(opcode, addressingMode),
+					costFlagsFromInstruction(opcode, addressingMode)
+				};
+			}
+		}
+	};
+
+	const CostTable& costTable()
+	{
+		static const CostTable table;
+		return table;
+	}
+
+}
+
+uint8_t CycleTable6502::baseCyclesFromInstruction(const Disassembler6502::Opcode opcode, const Disassembler6502::AddressingMode addressingMode)
+{
+	switch (addressingMode)
+	{
+	case Disassembler6502::ABSOLUTE_AM:
+		if (opcode == Disassembler6502::JMP_INSTR) {
+			return 3;
+		}
+		if (opcode == Disassembler6502::JSR_INSTR || isReadModifyWrite(opcode)) {
+			return 6;
+		}
+		return 4;
+	case Disassembler6502::ABSOLUTE_INDEXED_INDIRECT_AM:
+	case Disassembler6502::ABSOLUTE_INDIRECT_AM:
+		return 6;
+	case Disassembler6502::ABSOLUTE_INDEXED_WITH_X_AM:
+		if (opcode == Disassembler6502::INC_INSTR || opcode == Disassembler6502::DEC_INSTR) {
+			return 7;
+		}
+		if (isReadModifyWrite(opcode)) {
+			return 6;
+		}
+		return isStore(opcode) ? 5 : 4;
+	case Disassembler6502::ABSOLUTE_INDEXED_WITH_Y_AM:
+		return isStore(opcode) ? 5 : 4;
+	case Disassembler6502::ACCUMULATOR_AM:
+	case Disassembler6502::IMMEDIATE_ADDRESSING_AM:
+		return 2;
+	case Disassembler6502::IMPLIED_AM:
+		return opcode == Disassembler6502::STP_INSTR || opcode == Disassembler6502::WAI_INSTR ? 3 : 2;
+	case Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM:
+		if (opcode == Disassembler6502::BRA_INSTR) {
+			return 3;
+		}
+		// BBRx and BBSx test a zero page bit before branching
+		return opcode >= Disassembler6502::BBR0_INSTR && opcode <= Disassembler6502::BBS7_INSTR ? 5 : 2;
+	case Disassembler6502::STACK_AM:
+		switch (opcode)
+		{
+		case Disassembler6502::BRK_INSTR:
+			return 7;
+		case Disassembler6502::RTI_INSTR:
+		case Disassembler6502::RTS_INSTR:
+			return 6;
+		case Disassembler6502::PHA_INSTR:
+		case Disassembler6502::PHP_INSTR:
+		case Disassembler6502::PHX_INSTR:
+		case Disassembler6502::PHY_INSTR:
+			return 3;
+		default:
+			return 4;
+		}
+	case Disassembler6502::ZERO_PAGE_AM:
+		return isReadModifyWrite(opcode) ? 5 : 3;
+	case Disassembler6502::ZERO_PAGE_INDEXED_INDIRECT_AM:
+		return 6;
+	case Disassembler6502::ZERO_PAGE_INDEXED_WITH_X_AM:
+		return isReadModifyWrite(opcode) ? 6 : 4;
+	case Disassembler6502::ZERO_PAGE_INDEXED_WITH_Y_AM:
+		return 4;
+	case Disassembler6502::ZERO_PAGE_INDIRECT_AM:
+		return 5;
+	case Disassembler6502::ZERO_PAGE_INDIRECT_INDEXED_WITH_Y_AM:
+		return isStore(opcode) ? 6 : 5;
+	}
+
+	return 2;
+}
+
+const CycleTable6502::Cost* CycleTable6502::table()
+{
+	return costTable().costs;
+}
+
+uint8_t CycleTable6502::cycles(uint8_t opcodeData, unsigned penalties)
+{
+	const Cost& cost = costTable().costs[opcodeData];
+
+	return static_cast<uint8_t>(cost.baseCycles +
+		((cost.costFlags & PAGE_CROSS_COST) && (penalties & PAGE_CROSSED)) +
+		((cost.costFlags & BRANCH_COST) && (penalties & BRANCH_TAKEN)) +
+		((cost.costFlags & DECIMAL_COST) && (penalties & DECIMAL_MODE)));
+}
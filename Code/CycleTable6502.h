@@ -0,0 +1,46 @@
+#ifndef CYCLE_TABLE_6502_H
+#define CYCLE_TABLE_6502_H
+
+#include "Disassembler6502.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Per opcode cycle costs of the WDC 65C02.
+// The base cost is fixed; the penalties passed to cycles() add the data dependent extras.
+// Undefined opcodes cost what the 65C02 spends on them as NOPs, even though the decoders step over them as one Byte.
+class CycleTable6502
+{
+public:
+
+	enum Penalty {
+		NO_PENALTY = 0,
+		PAGE_CROSSED = 1 << 0,   // indexed read crossed a page, or a taken branch landed on another page
+		BRANCH_TAKEN = 1 << 1,
+		DECIMAL_MODE = 1 << 2    // D flag set while executing ADC or SBC
+	};
+
+	enum CostFlag {
+		PAGE_CROSS_COST = 1 << 0,
+		BRANCH_COST = 1 << 1,
+		DECIMAL_COST = 1 << 2
+	};
+
+	struct Cost {
+		uint8_t baseCycles;
+		uint8_t costFlags;
+	};
+
+	static uint8_t baseCyclesFromInstruction(const Disassembler6502::Opcode opcode, const Disassembler6502::AddressingMode addressingMode);
+
+	static const Cost* table();
+
+	static uint8_t cycles(uint8_t opcodeData, unsigned penalties = NO_PENALTY);
+
+	static bool pageCrossed(uint16_t base, uint16_t effective)
+	{
+		return ((base ^ effective) & 0xFF00) != 0;
+	}
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include "DataAccessHeatmap6502.h"
+#include "DecodeCore6502.h"
+
+#include <algorithm>
+
+namespace {
+
+	struct AccessKindTable {
+		uint8_t kinds[256];
+
+		AccessKindTable()
+		{
+			for (size_t i = 0; i < 256; i++) {
+				const DecodeCore6502::Descriptor& descriptor = DecodeCore6502::TABLE.entries[i];
+
+				kinds[i] = static_cast<uint8_t>(descriptor.opcode != DecodeCore6502::INVALID_OPCODE ?
+					DataAccessHeatmap6502::accessKindFromInstruction(static_cast<Disassembler6502::Opcode>(descriptor.opcode), static_cast<Disassembler6502::AddressingMode>(descriptor.addressingMode)) :
+					DataAccessHeatmap6502::NO_ACCESS);
+			}
+		}
+	};
+
+	const AccessKindTable& accessKindTable()
+	{
+		static const AccessKindTable table;
+		return table;
+	}
+
+}
+
+DataAccessHeatmap6502::DataAccessHeatmap6502(size_t bankCount) :
+	counters(((bankCount > 0 ? bankCount : 1) + 1) * (ACCESS_KIND_COUNT - 1) * ADDRESS_COUNT),
+	bankCount(bankCount > 0 ? bankCount : 1)
+{
+}
+
+uint32_t* DataAccessHeatmap6502::kindCounters(uint16_t bank, AccessKind kind)
+{
+	return counters.data() + (bankSlot(bank) * (ACCESS_KIND_COUNT - 1) + (kind - 1)) * ADDRESS_COUNT;
+}
+
+const uint32_t* DataAccessHeatmap6502::kindCounters(uint16_t bank, AccessKind kind) const
+{
+	return counters.data() + (bankSlot(bank) * (ACCESS_KIND_COUNT - 1) + (kind - 1)) * ADDRESS_COUNT;
+}
+
+DataAccessHeatmap6502::AccessKind DataAccessHeatmap6502::accessKindFromInstruction(const Disassembler6502::Opcode opcode, const Disassembler6502::AddressingMode addressingMode)
+{
+	switch (addressingMode)
+	{
+	case Disassembler6502::ACCUMULATOR_AM:
+	case Disassembler6502::IMMEDIATE_ADDRESSING_AM:
+	case Disassembler6502::IMPLIED_AM:
+	case Disassembler6502::STACK_AM:
+		return NO_ACCESS;
+	default:
+		break;
+	}
+
+	switch (opcode)
+	{
+	case Disassembler6502::ADC_INSTR:
+	case Disassembler6502::AND_INSTR:
+	case Disassembler6502::BIT_INSTR:
+	case Disassembler6502::CMP_INSTR:
+	case Disassembler6502::CPX_INSTR:
+	case Disassembler6502::CPY_INSTR:
+	case Disassembler6502::EOR_INSTR:
+	case Disassembler6502::LDA_INSTR:
+	case Disassembler6502::LDX_INSTR:
+	case Disassembler6502::LDY_INSTR:
+	case Disassembler6502::ORA_INSTR:
+	case Disassembler6502::SBC_INSTR:
+	// BBRx and BBSx read the zero page byte they test
+	case Disassembler6502::BBR0_INSTR:
+	case Disassembler6502::BBR1_INSTR:
+	case Disassembler6502::BBR2_INSTR:
+	case Disassembler6502::BBR3_INSTR:
+	case Disassembler6502::BBR4_INSTR:
+	case Disassembler6502::BBR5_INSTR:
+	case Disassembler6502::BBR6_INSTR:
+	case Disassembler6502::BBR7_INSTR:
+	case Disassembler6502::BBS0_INSTR:
+	case Disassembler6502::BBS1_INSTR:
+	case Disassembler6502::BBS2_INSTR:
+	case Disassembler6502::BBS3_INSTR:
+	case Disassembler6502::BBS4_INSTR:
+	case Disassembler6502::BBS5_INSTR:
+	case Disassembler6502::BBS6_INSTR:
+	case Disassembler6502::BBS7_INSTR:
+		return READ_ACCESS;
+	case Disassembler6502::STA_INSTR:
+	case Disassembler6502::STX_INSTR:
+	case Disassembler6502::STY_INSTR:
+	case Disassembler6502::STZ_INSTR:
+		return WRITE_ACCESS;
+	case Disassembler6502::ASL_INSTR:
+	case Disassembler6502::DEC_INSTR:
+	case Disassembler6502::INC_INSTR:
+	case Disassembler6502::LSR_INSTR:
+	case Disassembler6502::ROL_INSTR:
+	case Disassembler6502::ROR_INSTR:
+	case Disassembler6502::TRB_INSTR:
+	case Disassembler6502::TSB_INSTR:
+	case Disassembler6502::RMB0_INSTR:
+	case Disassembler6502::RMB1_INSTR:
+	case Disassembler6502::RMB2_INSTR:
+	case Disassembler6502::RMB3_INSTR:
+	case Disassembler6502::RMB4_INSTR:
+	case Disassembler6502::RMB5_INSTR:
+	case Disassembler6502::RMB6_INSTR:
+	case Disassembler6502::RMB7_INSTR:
+	case Disassembler6502::SMB0_INSTR:
+	case Disassembler6502::SMB1_INSTR:
+	case Disassembler6502::SMB2_INSTR:
+	case Disassembler6502::SMB3_INSTR:
+	case Disassembler6502::SMB4_INSTR:
+	case Disassembler6502::SMB5_INSTR:
+	case Disassembler6502::SMB6_INSTR:
+	case Disassembler6502::SMB7_INSTR:
+		return READ_MODIFY_WRITE_ACCESS;
+	default:
+		// branches and jumps only change the program counter
+		return NO_ACCESS;
+	}
+}
+
+DataAccessHeatmap6502::AccessKind DataAccessHeatmap6502::accessKind(uint8_t opcodeData)
+{
+	return static_cast<AccessKind>(accessKindTable().kinds[opcodeData]);
+}
+
+void DataAccessHeatmap6502::addTrace(const uint8_t* opcodeData, const uint16_t* effectiveAddresses, size_t count, uint16_t bank)
+{
+	const uint8_t* kinds = accessKindTable().kinds;
+	uint32_t* kindBase = kindCounters(bank, READ_ACCESS);
+
+	for (size_t i = 0; i < count; i++) {
+		const uint8_t kind = kinds[opcodeData[i]];
+
+		if (kind != NO_ACCESS) {
+			uint32_t& counter = kindBase[(kind - 1) * ADDRESS_COUNT + effectiveAddresses[i]];
+			counter += counter != UINT32_MAX;
+		}
+	}
+}
+
+bool DataAccessHeatmap6502::merge(const DataAccessHeatmap6502& other)
+{
+	if (other.bankCount != bankCount) {
+		return false;
+	}
+
+	uint32_t* target = counters.data();
+	const uint32_t* source = other.counters.data();
+
+	for (size_t i = 0; i < counters.size(); i++) {
+		const uint32_t sum = target[i] + source[i];
+		target[i] = sum < source[i] ? UINT32_MAX : sum;
+	}
+
+	return true;
+}
+
+void DataAccessHeatmap6502::clear()
+{
+	std::fill(counters.begin(), counters.end(), 0);
+}
+
+size_t DataAccessHeatmap6502::getBankCount() const
+{
+	return bankCount;
+}
+
+uint32_t DataAccessHeatmap6502::count(AccessKind kind, uint16_t address, uint16_t bank) const
+{
+	return kind == NO_ACCESS ? 0 : kindCounters(bank, kind)[address];
+}
+
+DataAccessHeatmap6502::Summary DataAccessHeatmap6502::summarize(uint16_t first, uint16_t last, uint16_t bank) const
+{
+	const uint32_t* reads = kindCounters(bank, READ_ACCESS);
+	const uint32_t* writes = kindCounters(bank, WRITE_ACCESS);
+	const uint32_t* readModifyWrites = kindCounters(bank, READ_MODIFY_WRITE_ACCESS);
+	Summary summary = { 0, 0, 0, 0 };
+
+	for (size_t address = first; address <= last; address++) {
+		summary.reads += reads[address];
+		summary.writes += writes[address];
+		summary.readModifyWrites += readModifyWrites[address];
+		summary.touchedAddresses += (reads[address] | writes[address] | readModifyWrites[address]) != 0;
+	}
+
+	return summary;
+}
+
+DataAccessHeatmap6502::Summary DataAccessHeatmap6502::zeroPageSummary(uint16_t bank) const
+{
+	return summarize(0x0000, 0x00FF, bank);
+}
+
+void DataAccessHeatmap6502::writeCsv(FILE* file) const
+{
+	fprintf(file, "bank,address,reads,writes,rmw\n");
+
+	for (size_t slot = 0; slot <= bankCount; slot++) {
+		const uint16_t bank = slot < bankCount ? static_cast<uint16_t>(slot) : 0xFFFF;
+		const uint32_t* reads = kindCounters(bank, READ_ACCESS);
+		const uint32_t* writes = kindCounters(bank, WRITE_ACCESS);
+		const uint32_t* readModifyWrites = kindCounters(bank, READ_MODIFY_WRITE_ACCESS);
+
+		for (size_t address = 0; address < ADDRESS_COUNT; address++) {
+			if ((reads[address] | writes[address] | readModifyWrites[address]) == 0) {
+				continue;
+			}
+
+			fprintf(file, "%u,$%04zX,%u,%u,%u\n", bank, address, reads[address], writes[address], readModifyWrites[address]);
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#ifndef DATA_ACCESS_HEATMAP_6502_H
+#define DATA_ACCESS_HEATMAP_6502_H
+
+#include "Disassembler6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Read, write and read-modify-write counts per data address, kept apart from instruction fetches.
+// The kind of access comes from the opcode, the address from the bus trace's effective address.
+// Counters are 32 bit, stick at UINT32_MAX instead of wrapping, and are stored as one contiguous array per bank and kind,
+// so merging heatmaps with the same bank count is a flat add.
+// Banks from bankCount up, like MemoryMap6502::FIXED_BANK and NO_BANK, share one extra slot that any of them reads back.
+class DataAccessHeatmap6502
+{
+public:
+
+	static const size_t ADDRESS_COUNT = 0x10000;
+
+	enum AccessKind {
+		NO_ACCESS,
+		READ_ACCESS,
+		WRITE_ACCESS,
+		READ_MODIFY_WRITE_ACCESS,
+		ACCESS_KIND_COUNT
+	};
+
+	struct Summary {
+		uint64_t reads;
+		uint64_t writes;
+		uint64_t readModifyWrites;
+		uint32_t touchedAddresses;
+	};
+
+private:
+
+	std::vector<uint32_t> counters;
+	size_t bankCount;
+
+	size_t bankSlot(uint16_t bank) const
+	{
+		return bank < bankCount ? bank : bankCount;
+	}
+
+	uint32_t* kindCounters(uint16_t bank, AccessKind kind);
+	const uint32_t* kindCounters(uint16_t bank, AccessKind kind) const;
+
+public:
+
+	explicit DataAccessHeatmap6502(size_t bankCount = 1);
+
+	static AccessKind accessKindFromInstruction(const Disassembler6502::Opcode opcode, const Disassembler6502::AddressingMode addressingMode);
+
+	static AccessKind accessKind(uint8_t opcodeData);
+
+	void addAccess(AccessKind kind, uint16_t address, uint16_t bank = 0)
+	{
+		if (kind != NO_ACCESS) {
+			uint32_t& counter = kindCounters(bank, kind)[address];
+			counter += counter != UINT32_MAX;
+		}
+	}
+
+	void addInstruction(uint8_t opcodeData, uint16_t effectiveAddress, uint16_t bank = 0)
+	{
+		addAccess(accessKind(opcodeData), effectiveAddress, bank);
+	}
+
+	// One effective address per executed instruction; it is ignored for instructions without a data access
+	void addTrace(const uint8_t* opcodeData, const uint16_t* effectiveAddresses, size_t count, uint16_t bank = 0);
+
+	// Adds the counts of other; returns false and merges nothing when the bank counts differ,
+	// since the shared slot of one heatmap would land on a real bank of the other
+	bool merge(const DataAccessHeatmap6502& other);
+
+	void clear();
+
+	size_t getBankCount() const;
+
+	uint32_t count(AccessKind kind, uint16_t address, uint16_t bank = 0) const;
+
+	Summary summarize(uint16_t first, uint16_t last, uint16_t bank = 0) const;
+
+	Summary zeroPageSummary(uint16_t bank = 0) const;
+
+	// One "bank,address,reads,writes,rmw" line per touched address; the shared slot is written as bank 65535
+	void writeCsv(FILE* file) const;
+};
+
+#endif
@@ -0,0 +1,516 @@
+#include "Dataflow6502.h"
+#include "DecodeCore6502.h"
+
+#include <cstring>
+
+namespace {
+
+	const uint32_t NO_ROW = 0xFFFFFFFF;
+	const size_t ADDRESS_COUNT = 0x10000;
+	// Registers and flags, the locations with definitions
+	const size_t DEFINED_LOCATION_COUNT = InstructionSemantics6502::LOCATION_COUNT - 1;
+	const uint16_t DEFINED_LOCATIONS = InstructionSemantics6502::REGISTER_LOCATIONS | InstructionSemantics6502::FLAG_LOCATIONS;
+
+	enum Flow {
+		FALL_FLOW,
+		BRANCH_FLOW,
+		JUMP_FLOW,
+		CALL_FLOW,
+		EXIT_FLOW,
+		STOP_FLOW
+	};
+
+	Flow flowOf(const InstructionColumns6502::View& view, size_t row, uint16_t& target)
+	{
+		const uint8_t opcode = view.opcodes[row];
+		if (opcode == InstructionColumns6502::INVALID_OPCODE) {
+			return FALL_FLOW;
+		}
+
+		if (view.addressingModes[row] == Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM) {
+			const DecodeCore6502::Descriptor descriptor = { opcode, view.addressingModes[row], view.operandLengths[row] };
+			target = DecodeCore6502::operandValue(descriptor, view.operands[row], view.addresses[row]);
+			return opcode == Disassembler6502::BRA_INSTR ? JUMP_FLOW : BRANCH_FLOW;
+		}
+
+		switch (opcode)
+		{
+		case Disassembler6502::JMP_INSTR:
+			if (view.addressingModes[row] != Disassembler6502::ABSOLUTE_AM) {
+				return EXIT_FLOW;
+			}
+			target = view.operands[row];
+			return JUMP_FLOW;
+		case Disassembler6502::JSR_INSTR:
+			target = view.operands[row];
+			return CALL_FLOW;
+		case Disassembler6502::RTS_INSTR:
+		case Disassembler6502::RTI_INSTR:
+		case Disassembler6502::BRK_INSTR:
+			return EXIT_FLOW;
+		case Disassembler6502::STP_INSTR:
+			return STOP_FLOW;
+		}
+
+		return FALL_FLOW;
+	}
+
+	void clearRange(uint64_t* bits, size_t begin, size_t end)
+	{
+		for (size_t bit = begin; bit < end; ) {
+			const size_t word = bit / 64;
+			const size_t shift = bit % 64;
+			const size_t count = end - bit < 64 - shift ? end - bit : 64 - shift;
+			const uint64_t mask = count == 64 ? ~0ULL : ((1ULL << count) - 1) << shift;
+
+			bits[word] &= ~mask;
+			bit += count;
+		}
+	}
+
+	// Iterates to the fixed point: update(block) recomputes the result row of block and returns whether it changed,
+	// in which case dependents(block, push) queues the blocks that read it. Every block is queued at most once at a time,
+	// the first round in layout order for forward problems and in reverse for backward ones.
+	template <typename Update, typename Dependents>
+	size_t runWorklist(size_t blockCount, bool forward, Update update, Dependents dependents)
+	{
+		if (blockCount == 0) {
+			return 0;
+		}
+
+		std::vector<uint32_t> queue(blockCount);
+		std::vector<uint8_t> queued(blockCount, 1);
+
+		for (size_t i = 0; i < blockCount; i++) {
+			queue[i] = static_cast<uint32_t>(forward ? i : blockCount - 1 - i);
+		}
+
+		size_t head = 0;
+		size_t queuedCount = blockCount;
+		size_t visits = 0;
+
+		auto push = [&](uint32_t block) {
+			if (block == Dataflow6502::NO_BLOCK || queued[block]) {
+				return;
+			}
+			queued[block] = 1;
+			queue[(head + queuedCount) % blockCount] = block;
+			queuedCount++;
+		};
+
+		while (queuedCount > 0) {
+			const uint32_t block = queue[head];
+			head = (head + 1) % blockCount;
+			queuedCount--;
+			queued[block] = 0;
+			visits++;
+
+			if (update(block)) {
+				dependents(block, push);
+			}
+		}
+
+		return visits;
+	}
+
+}
+
+const uint32_t Dataflow6502::NO_BLOCK;
+
+void Dataflow6502::BitMatrix::assign(size_t rows, size_t rowWords)
+{
+	words = rowWords;
+	bits.assign(rows * rowWords, 0);
+}
+
+Dataflow6502::Dataflow6502(const InstructionColumns6502::View& view) :
+	columns(view),
+	livenessSolved(false),
+	locationBegin()
+{
+	liveInSets.assign(0, 1);
+	reachingOutSets.assign(0, 1);
+
+	buildBlocks();
+}
+
+void Dataflow6502::buildBlocks()
+{
+	const size_t count = columns.count;
+
+	std::vector<uint32_t> rowAt(ADDRESS_COUNT, NO_ROW);
+	for (size_t row = 0; row < count; row++) {
+		rowAt[columns.addresses[row]] = static_cast<uint32_t>(row);
+	}
+
+	std::vector<uint8_t> leaders(count + 1, 0);
+	leaders[0] = 1;
+
+	for (size_t row = 0; row < count; row++) {
+		uint16_t target = 0;
+		const Flow flow = flowOf(columns, row, target);
+
+		if (flow == FALL_FLOW) {
+			continue;
+		}
+
+		leaders[row + 1] = 1;
+		if (flow == CALL_FLOW) {
+			leaders[row] = 1;
+		}
+		if ((flow == BRANCH_FLOW || flow == JUMP_FLOW || flow == CALL_FLOW) && rowAt[target] != NO_ROW) {
+			leaders[rowAt[target]] = 1;
+		}
+	}
+
+	blocks.clear();
+	rowBlocks.assign(count, NO_BLOCK);
+
+	for (size_t row = 0; row < count; row++) {
+		if (leaders[row]) {
+			const Block block = { static_cast<uint32_t>(row), static_cast<uint32_t>(row), { NO_BLOCK, NO_BLOCK }, false };
+			blocks.push_back(block);
+		}
+		blocks.back().endRow = static_cast<uint32_t>(row + 1);
+		rowBlocks[row] = static_cast<uint32_t>(blocks.size() - 1);
+	}
+
+	blockUses.assign(blocks.size(), 0);
+	blockKills.assign(blocks.size(), 0);
+	std::vector<uint32_t> predecessorCounts(blocks.size() + 1, 0);
+
+	for (size_t index = 0; index < blocks.size(); index++) {
+		Block& block = blocks[index];
+		const size_t last = block.endRow - 1;
+		const uint32_t next = block.endRow < count ? rowBlocks[block.endRow] : NO_BLOCK;
+
+		uint16_t target = 0;
+		const Flow flow = flowOf(columns, last, target);
+		const uint32_t targetBlock = (flow == BRANCH_FLOW || flow == JUMP_FLOW) && rowAt[target] != NO_ROW ? rowBlocks[rowAt[target]] : NO_BLOCK;
+
+		switch (flow)
+		{
+		case FALL_FLOW:
+		case CALL_FLOW:
+			block.successors[0] = next;
+			block.exits = next == NO_BLOCK;
+			break;
+		case BRANCH_FLOW:
+			block.successors[0] = targetBlock;
+			block.successors[1] = next != targetBlock ? next : NO_BLOCK;
+			block.exits = targetBlock == NO_BLOCK || next == NO_BLOCK;
+			break;
+		case JUMP_FLOW:
+			block.successors[0] = targetBlock;
+			block.exits = targetBlock == NO_BLOCK;
+			break;
+		case EXIT_FLOW:
+			block.exits = true;
+			break;
+		case STOP_FLOW:
+			break;
+		}
+
+		if (block.successors[0] == NO_BLOCK && block.successors[1] != NO_BLOCK) {
+			block.successors[0] = block.successors[1];
+			block.successors[1] = NO_BLOCK;
+		}
+
+		for (uint32_t successor : block.successors) {
+			if (successor != NO_BLOCK) {
+				predecessorCounts[successor + 1]++;
+			}
+		}
+
+		if (flow == CALL_FLOW) {
+			// the subroutine may read and write anything, but nothing is sure to be written
+			blockUses[index] = InstructionSemantics6502::ALL_LOCATIONS;
+			continue;
+		}
+
+		uint16_t uses = 0;
+		uint16_t kills = 0;
+		for (size_t row = block.beginRow; row < block.endRow; row++) {
+			const InstructionSemantics6502::Effects effects = InstructionSemantics6502::effects(columns.opcodeData[row]);
+			uses |= effects.uses & ~kills;
+			kills |= effects.defs & DEFINED_LOCATIONS;
+		}
+		blockUses[index] = uses;
+		blockKills[index] = kills;
+	}
+
+	predecessorBegin.assign(blocks.size() + 1, 0);
+	for (size_t index = 0; index < blocks.size(); index++) {
+		predecessorBegin[index + 1] = predecessorBegin[index] + predecessorCounts[index + 1];
+	}
+
+	predecessors.assign(predecessorBegin.back(), 0);
+	std::vector<uint32_t> filled(predecessorBegin.begin(), predecessorBegin.end() - 1);
+	for (size_t index = 0; index < blocks.size(); index++) {
+		for (uint32_t successor : blocks[index].successors) {
+			if (successor != NO_BLOCK) {
+				predecessors[filled[successor]++] = static_cast<uint32_t>(index);
+			}
+		}
+	}
+}
+
+void Dataflow6502::buildDefinitions()
+{
+	const size_t blockCount = blocks.size();
+
+	// last row of each block writing each location, NO_ROW where the block does not
+	std::vector<uint32_t> writers(blockCount * DEFINED_LOCATION_COUNT, NO_ROW);
+
+	for (size_t index = 0; index < blockCount; index++) {
+		const Block& block = blocks[index];
+		uint32_t* blockWriters = writers.data() + index * DEFINED_LOCATION_COUNT;
+
+		const bool isCall = columns.opcodes[block.beginRow] == Disassembler6502::JSR_INSTR;
+
+		for (uint32_t row = block.beginRow; row < block.endRow; row++) {
+			const uint16_t defs = isCall ? DEFINED_LOCATIONS : InstructionSemantics6502::effects(columns.opcodeData[row]).defs;
+
+			for (size_t location = 0; location < DEFINED_LOCATION_COUNT; location++) {
+				if (defs & (1 << location)) {
+					blockWriters[location] = row;
+				}
+			}
+		}
+	}
+
+	definitions.clear();
+	std::vector<uint32_t> genCounts(blockCount + 1, 0);
+
+	// a write that is dead at the end of its block reaches no read, so it gets no id
+	std::vector<uint16_t> liveOuts(blockCount);
+	for (size_t index = 0; index < blockCount; index++) {
+		liveOuts[index] = liveOut(static_cast<uint32_t>(index));
+	}
+
+	for (size_t location = 0; location < DEFINED_LOCATION_COUNT; location++) {
+		locationBegin[location] = static_cast<uint32_t>(definitions.size());
+
+		for (size_t index = 0; index < blockCount; index++) {
+			const uint32_t row = writers[index * DEFINED_LOCATION_COUNT + location];
+			if (row != NO_ROW && (liveOuts[index] & (1 << location))) {
+				const Definition definition = { row, static_cast<uint16_t>(1 << location) };
+				definitions.push_back(definition);
+				genCounts[index + 1]++;
+			}
+		}
+	}
+	for (size_t location = DEFINED_LOCATION_COUNT; location <= InstructionSemantics6502::LOCATION_COUNT; location++) {
+		locationBegin[location] = static_cast<uint32_t>(definitions.size());
+	}
+
+	genBegin.assign(blockCount + 1, 0);
+	for (size_t index = 0; index < blockCount; index++) {
+		genBegin[index + 1] = genBegin[index] + genCounts[index + 1];
+	}
+
+	gens.assign(genBegin.back(), 0);
+	std::vector<uint32_t> filled(genBegin.begin(), genBegin.end() - 1);
+	for (uint32_t id = 0; id < definitions.size(); id++) {
+		gens[filled[rowBlocks[definitions[id].row]]++] = id;
+	}
+}
+
+const std::vector<Dataflow6502::Block>& Dataflow6502::getBlocks() const
+{
+	return blocks;
+}
+
+uint32_t Dataflow6502::blockOfRow(uint32_t row) const
+{
+	return row < rowBlocks.size() ? rowBlocks[row] : NO_BLOCK;
+}
+
+void Dataflow6502::gatherLiveOut(uint32_t block, uint64_t* out) const
+{
+	out[0] = blocks[block].exits ? InstructionSemantics6502::ALL_LOCATIONS : 0;
+
+	for (uint32_t successor : blocks[block].successors) {
+		if (successor != NO_BLOCK) {
+			out[0] |= liveInSets.row(successor)[0];
+		}
+	}
+}
+
+void Dataflow6502::gatherReachingIn(uint32_t block, uint64_t* in) const
+{
+	const size_t words = reachingOutSets.words;
+	memset(in, 0, words * sizeof(uint64_t));
+
+	for (uint32_t i = predecessorBegin[block]; i < predecessorBegin[block + 1]; i++) {
+		const uint64_t* out = reachingOutSets.row(predecessors[i]);
+		for (size_t word = 0; word < words; word++) {
+			in[word] |= out[word];
+		}
+	}
+}
+
+size_t Dataflow6502::solveLiveness()
+{
+	liveInSets.assign(blocks.size(), 1);
+	livenessSolved = true;
+
+	return runWorklist(blocks.size(), false,
+		[this](uint32_t block) {
+			uint64_t out = 0;
+			gatherLiveOut(block, &out);
+
+			const uint64_t in = blockUses[block] | (out & ~static_cast<uint64_t>(blockKills[block]));
+			uint64_t& stored = liveInSets.row(block)[0];
+			if (in == stored) {
+				return false;
+			}
+			stored = in;
+			return true;
+		},
+		[this](uint32_t block, auto& push) {
+			for (uint32_t i = predecessorBegin[block]; i < predecessorBegin[block + 1]; i++) {
+				push(predecessors[i]);
+			}
+		});
+}
+
+size_t Dataflow6502::solveReachingDefinitions()
+{
+	size_t visits = 0;
+	if (!livenessSolved) {
+		visits += solveLiveness();
+	}
+
+	buildDefinitions();
+
+	const size_t words = (definitions.size() + 63) / 64;
+	reachingOutSets.assign(blocks.size(), words > 0 ? words : 1);
+
+	std::vector<uint64_t> out(reachingOutSets.words);
+
+	return visits + runWorklist(blocks.size(), true,
+		[this, &out](uint32_t block) {
+			gatherReachingIn(block, out.data());
+
+			const uint16_t kills = blockKills[block];
+			for (size_t location = 0; location < DEFINED_LOCATION_COUNT; location++) {
+				if (kills & (1 << location)) {
+					clearRange(out.data(), locationBegin[location], locationBegin[location + 1]);
+				}
+			}
+			for (uint32_t i = genBegin[block]; i < genBegin[block + 1]; i++) {
+				out[gens[i] / 64] |= 1ULL << (gens[i] % 64);
+			}
+
+			uint64_t* stored = reachingOutSets.row(block);
+			if (memcmp(stored, out.data(), out.size() * sizeof(uint64_t)) == 0) {
+				return false;
+			}
+			memcpy(stored, out.data(), out.size() * sizeof(uint64_t));
+			return true;
+		},
+		[this](uint32_t block, auto& push) {
+			for (uint32_t successor : blocks[block].successors) {
+				push(successor);
+			}
+		});
+}
+
+uint16_t Dataflow6502::liveIn(uint32_t block) const
+{
+	return static_cast<uint16_t>(liveInSets.row(block)[0]);
+}
+
+uint16_t Dataflow6502::liveOut(uint32_t block) const
+{
+	uint64_t out = 0;
+	gatherLiveOut(block, &out);
+	return static_cast<uint16_t>(out);
+}
+
+uint16_t Dataflow6502::liveAfter(uint32_t row) const
+{
+	const uint32_t block = rowBlocks[row];
+	uint16_t live = liveOut(block);
+
+	for (uint32_t i = blocks[block].endRow - 1; i > row; i--) {
+		const InstructionSemantics6502::Effects effects = InstructionSemantics6502::effects(columns.opcodeData[i]);
+		live = static_cast<uint16_t>(effects.uses | (live & ~(effects.defs & DEFINED_LOCATIONS)));
+	}
+
+	return live;
+}
+
+size_t Dataflow6502::collectDeadRows(std::vector<uint32_t>& rows) const
+{
+	const size_t first = rows.size();
+
+	for (uint32_t index = 0; index < blocks.size(); index++) {
+		const Block& block = blocks[index];
+		if (columns.opcodes[block.beginRow] == Disassembler6502::JSR_INSTR) {
+			continue;
+		}
+
+		const size_t blockFirst = rows.size();
+		uint16_t live = liveOut(index);
+
+		for (uint32_t row = block.endRow; row-- > block.beginRow; ) {
+			const InstructionSemantics6502::Effects effects = InstructionSemantics6502::effects(columns.opcodeData[row]);
+
+			// a memory read stays even when its value is dead: reading an I/O register can acknowledge an interrupt or hit a strobe
+			if (effects.defs != 0 && (effects.defs & ~DEFINED_LOCATIONS) == 0 && (effects.defs & live) == 0 &&
+				(effects.uses & InstructionSemantics6502::MEMORY_LOCATION) == 0) {
+				rows.push_back(row);
+			}
+
+			live = static_cast<uint16_t>(effects.uses | (live & ~effects.defs));
+		}
+
+		// collected backwards within the block
+		for (size_t i = blockFirst, j = rows.size(); i + 1 < j; i++, j--) {
+			const uint32_t swap = rows[i];
+			rows[i] = rows[j - 1];
+			rows[j - 1] = swap;
+		}
+	}
+
+	return rows.size() - first;
+}
+
+size_t Dataflow6502::collectReachingDefinitions(uint32_t row, uint16_t location, std::vector<uint32_t>& rows) const
+{
+	const uint32_t block = rowBlocks[row];
+
+	for (uint32_t i = row; i-- > blocks[block].beginRow; ) {
+		if (InstructionSemantics6502::effects(columns.opcodeData[i]).defs & location) {
+			rows.push_back(i);
+			return 1;
+		}
+	}
+
+	size_t index = 0;
+	while (index < DEFINED_LOCATION_COUNT && (1 << index) != location) {
+		index++;
+	}
+	if (index == DEFINED_LOCATION_COUNT) {
+		return 0;
+	}
+
+	std::vector<uint64_t> in(reachingOutSets.words);
+	gatherReachingIn(block, in.data());
+
+	const size_t first = rows.size();
+	for (uint32_t id = locationBegin[index]; id < locationBegin[index + 1]; id++) {
+		if (in[id / 64] & (1ULL << (id % 64))) {
+			rows.push_back(definitions[id].row);
+		}
+	}
+
+	return rows.size() - first;
+}
+
+const std::vector<Dataflow6502::Definition>& Dataflow6502::getDefinitions() const
+{
+	return definitions;
+}
@@ -0,0 +1,118 @@
+#ifndef DATAFLOW_6502_H
+#define DATAFLOW_6502_H
+
+#include "InstructionColumns6502.h"
+#include "InstructionSemantics6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Basic blocks of a linear sweep and the classic dataflow problems over them, solved by one worklist engine on dense bit vectors.
+// Liveness and reaching definitions track A, X, Y, S and each flag; memory takes part in liveness as one location that is
+// never killed, and has no definitions of its own.
+// Control flow follows branches and JMP absolute to instruction starts inside the image. Anything leaving the image,
+// landing between instruction starts, RTS, RTI, BRK and indirect jumps is an exit where every location is live.
+// A JSR is a block of its own that may read and write every location; callers are not linked to the subroutine,
+// so no definition reaches the entry of a subroutine.
+class Dataflow6502
+{
+public:
+
+	static const uint32_t NO_BLOCK = 0xFFFFFFFF;
+
+	struct Block {
+		uint32_t beginRow;
+		uint32_t endRow;
+		// NO_BLOCK where there is no successor
+		uint32_t successors[2];
+		bool exits;
+	};
+
+	struct Definition {
+		uint32_t row;
+		uint16_t location;
+	};
+
+private:
+
+	// rows x words of 64 bits, one row per block
+	struct BitMatrix {
+		size_t words;
+		std::vector<uint64_t> bits;
+
+		void assign(size_t rows, size_t words);
+
+		uint64_t* row(size_t index)
+		{
+			return bits.data() + index * words;
+		}
+
+		const uint64_t* row(size_t index) const
+		{
+			return bits.data() + index * words;
+		}
+	};
+
+	InstructionColumns6502::View columns;
+	std::vector<Block> blocks;
+	std::vector<uint32_t> rowBlocks;
+	std::vector<uint32_t> predecessorBegin;
+	std::vector<uint32_t> predecessors;
+
+	// Upward exposed uses and killed locations per block
+	std::vector<uint16_t> blockUses;
+	std::vector<uint16_t> blockKills;
+	BitMatrix liveInSets;
+	bool livenessSolved;
+
+	// Definition ids are grouped by location, so killing a location clears one id range
+	std::vector<Definition> definitions;
+	uint32_t locationBegin[InstructionSemantics6502::LOCATION_COUNT + 1];
+	std::vector<uint32_t> genBegin;
+	std::vector<uint32_t> gens;
+	BitMatrix reachingOutSets;
+
+	void buildBlocks();
+
+	void buildDefinitions();
+
+	void gatherLiveOut(uint32_t block, uint64_t* out) const;
+
+	void gatherReachingIn(uint32_t block, uint64_t* in) const;
+
+public:
+
+	// Blocks are built right away; the view must stay valid while this object is used
+	explicit Dataflow6502(const InstructionColumns6502::View& view);
+
+	const std::vector<Block>& getBlocks() const;
+
+	uint32_t blockOfRow(uint32_t row) const;
+
+	// Both return how many times a block was visited until the sets settled
+	size_t solveLiveness();
+
+	// Writes dead at the end of their block reach no read and get no definition; solves liveness first when needed
+	size_t solveReachingDefinitions();
+
+	// Liveness results, valid after solveLiveness()
+	uint16_t liveIn(uint32_t block) const;
+
+	uint16_t liveOut(uint32_t block) const;
+
+	// Locations live right after row executes
+	uint16_t liveAfter(uint32_t row) const;
+
+	// Rows that write only registers and flags, none of them live afterwards, and read no memory.
+	// Loads of dead values are kept because the read itself can be an effect, like acknowledging a timer interrupt
+	size_t collectDeadRows(std::vector<uint32_t>& rows) const;
+
+	// Reaching definitions results, valid after solveReachingDefinitions().
+	// Rows whose write of location may be the value row reads; location is a single register or flag bit row uses
+	size_t collectReachingDefinitions(uint32_t row, uint16_t location, std::vector<uint32_t>& rows) const;
+
+	const std::vector<Definition>& getDefinitions() const;
+};
+
+#endif
@@ -0,0 +1,1013 @@
+#ifndef DECODE_CORE_6502_H
+#define DECODE_CORE_6502_H
+
+#include "Disassembler6502.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Header-only decode primitives for callers that decode on every opcode fetch, like the dispatch loop of an emulator.
+// Everything is inline and constexpr and works on plain bytes, so calls inline into the caller and results can be
+// checked at compile time; descriptor() is a single table load. Disassembler6502 and the record decoders are built on it.
+class DecodeCore6502
+{
+public:
+
+	static constexpr uint8_t INVALID_OPCODE = 0xFF;
+	static constexpr uint8_t INVALID_ADDRESSING_MODE = 0xFF;
+	static constexpr size_t MAX_TEXT_LEN = Disassembler6502::MAX_INSTRUCTION_LEN;
+
+	struct Descriptor {
+		// Disassembler6502::Opcode, INVALID_OPCODE for bytes that do not decode; the other fields are 0 then
+		uint8_t opcode;
+		uint8_t addressingMode;
+		uint8_t operandLength;
+	};
+
+	struct DescriptorTable {
+		Descriptor entries[256];
+
+		constexpr DescriptorTable();
+	};
+
+	static const DescriptorTable TABLE;
+
+	// Disassembler6502::Opcode of data, INVALID_OPCODE when it does not decode
+	static constexpr uint8_t opcodeFromData(uint8_t data)
+	{
+		switch (data)
+		{
+		case 0x6D:
+		case 0x7D:
+		case 0x79:
+		case 0x69:
+		case 0x65:
+		case 0x61:
+		case 0x75:
+		case 0x72:
+		case 0x71:
+			return Disassembler6502::ADC_INSTR;
+		case 0x2D:
+		case 0x3D:
+		case 0x39:
+		case 0x29:
+		case 0x25:
+		case 0x21:
+		case 0x35:
+		case 0x32:
+		case 0x31:
+			return Disassembler6502::AND_INSTR;
+		case 0x0E:
+		case 0x1E:
+		case 0x0A:
+		case 0x06:
+		case 0x16:
+			return Disassembler6502::ASL_INSTR;
+		case 0x0F:
+			return Disassembler6502::BBR0_INSTR;
+		case 0x1F:
+			return Disassembler6502::BBR1_INSTR;
+		case 0x2F:
+			return Disassembler6502::BBR2_INSTR;
+		case 0x3F:
+			return Disassembler6502::BBR3_INSTR;
+		case 0x4F:
+			return Disassembler6502::BBR4_INSTR;
+		case 0x5F:
+			return Disassembler6502::BBR5_INSTR;
+		case 0x6F:
+			return Disassembler6502::BBR6_INSTR;
+		case 0x7F:
+			return Disassembler6502::BBR7_INSTR;
+		case 0x8F:
+			return Disassembler6502::BBS0_INSTR;
+		case 0x9F:
+			return Disassembler6502::BBS1_INSTR;
+		case 0xAF:
+			return Disassembler6502::BBS2_INSTR;
+		case 0xBF:
+			return Disassembler6502::BBS3_INSTR;
+		case 0xCF:
+			return Disassembler6502::BBS4_INSTR;
+		case 0xDF:
+			return Disassembler6502::BBS5_INSTR;
+		case 0xEF:
+			return Disassembler6502::BBS6_INSTR;
+		case 0xFF:
+			return Disassembler6502::BBS7_INSTR;
+		case 0x90:
+			return Disassembler6502::BCC_INSTR;
+		case 0xB0:
+			return Disassembler6502::BCS_INSTR;
+		case 0xF0:
+			return Disassembler6502::BEQ_INSTR;
+		case 0x2C:
+		case 0x3C:
+		case 0x89:
+		case 0x24:
+		case 0x34:
+			return Disassembler6502::BIT_INSTR;
+		case 0x30:
+			return Disassembler6502::BMI_INSTR;
+		case 0xD0:
+			return Disassembler6502::BNE_INSTR;
+		case 0x10:
+			return Disassembler6502::BPL_INSTR;
+		case 0x80:
+			return Disassembler6502::BRA_INSTR;
+		case 0x00:
+			return Disassembler6502::BRK_INSTR;
+		case 0x50:
+			return Disassembler6502::BVC_INSTR;
+		case 0x70:
+			return Disassembler6502::BVS_INSTR;
+		case 0x18:
+			return Disassembler6502::CLC_INSTR;
+		case 0xD8:
+			return Disassembler6502::CLD_INSTR;
+		case 0x58:
+			return Disassembler6502::CLI_INSTR;
+		case 0xB8:
+			return Disassembler6502::CLV_INSTR;
+		case 0xCD:
+		case 0xDD:
+		case 0xD9:
+		case 0xC9:
+		case 0xC5:
+		case 0xC1:
+		case 0xD5:
+		case 0xD2:
+		case 0xD1:
+			return Disassembler6502::CMP_INSTR;
+		case 0xEC:
+		case 0xE0:
+		case 0xE4:
+			return Disassembler6502::CPX_INSTR;
+		case 0xCC:
+		case 0xC0:
+		case 0xC4:
+			return Disassembler6502::CPY_INSTR;
+		case 0xCE:
+		case 0xDE:
+		case 0x3A:
+		case 0xC6:
+		case 0xD6:
+			return Disassembler6502::DEC_INSTR;
+		case 0xCA:
+			return Disassembler6502::DEX_INSTR;
+		case 0x88:
+			return Disassembler6502::DEY_INSTR;
+		case 0x4D:
+		case 0x5D:
+		case 0x59:
+		case 0x49:
+		case 0x45:
+		case 0x41:
+		case 0x55:
+		case 0x52:
+		case 0x51:
+			return Disassembler6502::EOR_INSTR;
+		case 0xEE:
+		case 0xFE:
+		case 0x1A:
+		case 0xE6:
+		case 0xF6:
+			return Disassembler6502::INC_INSTR;
+		case 0xE8:
+			return Disassembler6502::INX_INSTR;
+		case 0xC8:
+			return Disassembler6502::INY_INSTR;
+		case 0x4C:
+		case 0x7C:
+		case 0x6C:
+			return Disassembler6502::JMP_INSTR;
+		case 0x20:
+			return Disassembler6502::JSR_INSTR;
+		case 0xAD:
+		case 0xBD:
+		case 0xB9:
+		case 0xA9:
+		case 0xA5:
+		case 0xA1:
+		case 0xB5:
+		case 0xB2:
+		case 0xB1:
+			return Disassembler6502::LDA_INSTR;
+		case 0xAE:
+		case 0xBE:
+		case 0xA2:
+		case 0xA6:
+		case 0xB6:
+			return Disassembler6502::LDX_INSTR;
+		case 0xAC:
+		case 0xBC:
+		case 0xA0:
+		case 0xA4:
+		case 0xB4:
+			return Disassembler6502::LDY_INSTR;
+		case 0x4E:
+		case 0x5E:
+		case 0x4A:
+		case 0x46:
+		case 0x56:
+			return Disassembler6502::LSR_INSTR;
+		case 0xEA:
+			return Disassembler6502::NOP_INSTR;
+		case 0x0D:
+		case 0x1D:
+		case 0x19:
+		case 0x09:
+		case 0x05:
+		case 0x01:
+		case 0x15:
+		case 0x12:
+		case 0x11:
+			return Disassembler6502::ORA_INSTR;
+		case 0x48:
+			return Disassembler6502::PHA_INSTR;
+		case 0x08:
+			return Disassembler6502::PHP_INSTR;
+		case 0xDA:
+			return Disassembler6502::PHX_INSTR;
+		case 0x5A:
+			return Disassembler6502::PHY_INSTR;
+		case 0x68:
+			return Disassembler6502::PLA_INSTR;
+		case 0x28:
+			return Disassembler6502::PLP_INSTR;
+		case 0xFA:
+			return Disassembler6502::PLX_INSTR;
+		case 0x7A:
+			return Disassembler6502::PLY_INSTR;
+		case 0x07:
+			return Disassembler6502::RMB0_INSTR;
+		case 0x17:
+			return Disassembler6502::RMB1_INSTR;
+		case 0x27:
+			return Disassembler6502::RMB2_INSTR;
+		case 0x37:
+			return Disassembler6502::RMB3_INSTR;
+		case 0x47:
+			return Disassembler6502::RMB4_INSTR;
+		case 0x57:
+			return Disassembler6502::RMB5_INSTR;
+		case 0x67:
+			return Disassembler6502::RMB6_INSTR;
+		case 0x77:
+			return Disassembler6502::RMB7_INSTR;
+		case 0x2E:
+		case 0x3E:
+		case 0x2A:
+		case 0x26:
+		case 0x36:
+			return Disassembler6502::ROL_INSTR;
+		case 0x6E:
+		case 0x7E:
+		case 0x6A:
+		case 0x66:
+		case 0x76:
+			return Disassembler6502::ROR_INSTR;
+		case 0x40:
+			return Disassembler6502::RTI_INSTR;
+		case 0x60:
+			return Disassembler6502::RTS_INSTR;
+		case 0xED:
+		case 0xFD:
+		case 0xF9:
+		case 0xE9:
+		case 0xE5:
+		case 0xE1:
+		case 0xF5:
+		case 0xF2:
+		case 0xF1:
+			return Disassembler6502::SBC_INSTR;
+		case 0x38:
+			return Disassembler6502::SEC_INSTR;
+		case 0xF8:
+			return Disassembler6502::SED_INSTR;
+		case 0x78:
+			return Disassembler6502::SEI_INSTR;
+		case 0x87:
+			return Disassembler6502::SMB0_INSTR;
+		case 0x97:
+			return Disassembler6502::SMB1_INSTR;
+		case 0xA7:
+			return Disassembler6502::SMB2_INSTR;
+		case 0xB7:
+			return Disassembler6502::SMB3_INSTR;
+		case 0xC7:
+			return Disassembler6502::SMB4_INSTR;
+		case 0xD7:
+			return Disassembler6502::SMB5_INSTR;
+		case 0xE7:
+			return Disassembler6502::SMB6_INSTR;
+		case 0xF7:
+			return Disassembler6502::SMB7_INSTR;
+		case 0x8D:
+		case 0x9D:
+		case 0x99:
+		case 0x85:
+		case 0x81:
+		case 0x95:
+		case 0x92:
+		case 0x91:
+			return Disassembler6502::STA_INSTR;
+		case 0xDB:
+			return Disassembler6502::STP_INSTR;
+		case 0x8E:
+		case 0x86:
+		case 0x96:
+			return Disassembler6502::STX_INSTR;
+		case 0x8C:
+		case 0x84:
+		case 0x94:
+			return Disassembler6502::STY_INSTR;
+		case 0x9C:
+		case 0x9E:
+		case 0x64:
+		case 0x74:
+			return Disassembler6502::STZ_INSTR;
+		case 0xAA:
+			return Disassembler6502::TAX_INSTR;
+		case 0xA8:
+			return Disassembler6502::TAY_INSTR;
+		case 0x1C:
+		case 0x14:
+			return Disassembler6502::TRB_INSTR;
+		case 0x0C:
+		case 0x04:
+			return Disassembler6502::TSB_INSTR;
+		case 0xBA:
+			return Disassembler6502::TSX_INSTR;
+		case 0x8A:
+			return Disassembler6502::TXA_INSTR;
+		case 0x9A:
+			return Disassembler6502::TXS_INSTR;
+		case 0x98:
+			return Disassembler6502::TYA_INSTR;
+		case 0xCB:
+			return Disassembler6502::WAI_INSTR;
+		}
+
+		return INVALID_OPCODE;
+	}
+
+	// Disassembler6502::AddressingMode of data, INVALID_ADDRESSING_MODE when it does not decode
+	static constexpr uint8_t addressingModeFromData(uint8_t data)
+	{
+		switch (data)
+		{
+		case 0x6D:
+		case 0x2D:
+		case 0x0E:
+		case 0x2C:
+		case 0xCD:
+		case 0xEC:
+		case 0xCC:
+		case 0xCE:
+		case 0x4D:
+		case 0xEE:
+		case 0x4C:
+		case 0x20:
+		case 0xAD:
+		case 0xAE:
+		case 0xAC:
+		case 0x4E:
+		case 0x0D:
+		case 0x2E:
+		case 0x6E:
+		case 0xED:
+		case 0x8D:
+		case 0x8E:
+		case 0x8C:
+		case 0x9C:
+		case 0x1C:
+		case 0x0C:
+			return Disassembler6502::ABSOLUTE_AM;
+		case 0x7C:
+			return Disassembler6502::ABSOLUTE_INDEXED_INDIRECT_AM;
+		case 0x7D:
+		case 0x3D:
+		case 0x1E:
+		case 0x3C:
+		case 0xDD:
+		case 0xDE:
+		case 0x5D:
+		case 0xFE:
+		case 0xBD:
+		case 0xBC:
+		case 0x5E:
+		case 0x1D:
+		case 0x3E:
+		case 0x7E:
+		case 0xFD:
+		case 0x9D:
+		case 0x9E:
+			return Disassembler6502::ABSOLUTE_INDEXED_WITH_X_AM;
+		case 0x79:
+		case 0x39:
+		case 0xD9:
+		case 0x59:
+		case 0xB9:
+		case 0xBE:
+		case 0x19:
+		case 0xF9:
+		case 0x99:
+			return Disassembler6502::ABSOLUTE_INDEXED_WITH_Y_AM;
+		case 0x6C:
+			return Disassembler6502::ABSOLUTE_INDIRECT_AM;
+		case 0x0A:
+		case 0x3A:
+		case 0x1A:
+		case 0x4A:
+		case 0x2A:
+		case 0x6A:
+			return Disassembler6502::ACCUMULATOR_AM;
+		case 0x69:
+		case 0x29:
+		case 0x89:
+		case 0xC9:
+		case 0xE0:
+		case 0xC0:
+		case 0x49:
+		case 0xA9:
+		case 0xA2:
+		case 0xA0:
+		case 0x09:
+		case 0xE9:
+			return Disassembler6502::IMMEDIATE_ADDRESSING_AM;
+		case 0x18:
+		case 0xD8:
+		case 0x58:
+		case 0xB8:
+		case 0xCA:
+		case 0x88:
+		case 0xE8:
+		case 0xC8:
+		case 0xEA:
+		case 0x38:
+		case 0xF8:
+		case 0x78:
+		case 0xDB:
+		case 0xAA:
+		case 0xA8:
+		case 0xBA:
+		case 0x8A:
+		case 0x9A:
+		case 0x98:
+		case 0xCB:
+			return Disassembler6502::IMPLIED_AM;
+		case 0x0F:
+		case 0x1F:
+		case 0x2F:
+		case 0x3F:
+		case 0x4F:
+		case 0x5F:
+		case 0x6F:
+		case 0x7F:
+		case 0x8F:
+		case 0x9F:
+		case 0xAF:
+		case 0xBF:
+		case 0xCF:
+		case 0xDF:
+		case 0xEF:
+		case 0xFF:
+		case 0x90:
+		case 0xB0:
+		case 0xF0:
+		case 0x30:
+		case 0xD0:
+		case 0x10:
+		case 0x80:
+		case 0x50:
+		case 0x70:
+			return Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM;
+		case 0x00:
+		case 0x48:
+		case 0x08:
+		case 0xDA:
+		case 0x5A:
+		case 0x68:
+		case 0x28:
+		case 0xFA:
+		case 0x7A:
+		case 0x40:
+		case 0x60:
+			return Disassembler6502::STACK_AM;
+		case 0x65:
+		case 0x25:
+		case 0x06:
+		case 0x24:
+		case 0xC5:
+		case 0xE4:
+		case 0xC4:
+		case 0xC6:
+		case 0x45:
+		case 0xE6:
+		case 0xA5:
+		case 0xA6:
+		case 0xA4:
+		case 0x46:
+		case 0x05:
+		case 0x07:
+		case 0x17:
+		case 0x27:
+		case 0x37:
+		case 0x47:
+		case 0x57:
+		case 0x67:
+		case 0x77:
+		case 0x26:
+		case 0x66:
+		case 0xE5:
+		case 0x87:
+		case 0x97:
+		case 0xA7:
+		case 0xB7:
+		case 0xC7:
+		case 0xD7:
+		case 0xE7:
+		case 0xF7:
+		case 0x85:
+		case 0x86:
+		case 0x84:
+		case 0x64:
+		case 0x14:
+		case 0x04:
+			return Disassembler6502::ZERO_PAGE_AM;
+		case 0x61:
+		case 0x21:
+		case 0xC1:
+		case 0x41:
+		case 0xA1:
+		case 0x01:
+		case 0xE1:
+		case 0x81:
+			return Disassembler6502::ZERO_PAGE_INDEXED_INDIRECT_AM;
+		case 0x75:
+		case 0x35:
+		case 0x16:
+		case 0x34:
+		case 0xD5:
+		case 0xD6:
+		case 0x55:
+		case 0xF6:
+		case 0xB5:
+		case 0xB4:
+		case 0x56:
+		case 0x15:
+		case 0x36:
+		case 0x76:
+		case 0xF5:
+		case 0x95:
+		case 0x94:
+		case 0x74:
+			return Disassembler6502::ZERO_PAGE_INDEXED_WITH_X_AM;
+		case 0xB6:
+		case 0x96:
+			return Disassembler6502::ZERO_PAGE_INDEXED_WITH_Y_AM;
+		case 0x72:
+		case 0x32:
+		case 0xD2:
+		case 0x52:
+		case 0xB2:
+		case 0x12:
+		case 0xF2:
+		case 0x92:
+			return Disassembler6502::ZERO_PAGE_INDIRECT_AM;
+		case 0x71:
+		case 0x31:
+		case 0xD1:
+		case 0x51:
+		case 0xB1:
+		case 0x11:
+		case 0xF1:
+		case 0x91:
+			return Disassembler6502::ZERO_PAGE_INDIRECT_INDEXED_WITH_Y_AM;
+		}
+
+		return INVALID_ADDRESSING_MODE;
+	}
+
+	static constexpr const char* mnemonic(Disassembler6502::Opcode opcode)
+	{
+		switch (opcode)
+		{
+		case Disassembler6502::ADC_INSTR:
+			return "ADC";
+		case Disassembler6502::AND_INSTR:
+			return "AND";
+		case Disassembler6502::ASL_INSTR:
+			return "ASL";
+		case Disassembler6502::BBR0_INSTR:
+			return "BBR0";
+		case Disassembler6502::BBR1_INSTR:
+			return "BBR1";
+		case Disassembler6502::BBR2_INSTR:
+			return "BBR2";
+		case Disassembler6502::BBR3_INSTR:
+			return "BBR3";
+		case Disassembler6502::BBR4_INSTR:
+			return "BBR4";
+		case Disassembler6502::BBR5_INSTR:
+			return "BBR5";
+		case Disassembler6502::BBR6_INSTR:
+			return "BBR6";
+		case Disassembler6502::BBR7_INSTR:
+			return "BBR7";
+		case Disassembler6502::BBS0_INSTR:
+			return "BBS0";
+		case Disassembler6502::BBS1_INSTR:
+			return "BBS1";
+		case Disassembler6502::BBS2_INSTR:
+			return "BBS2";
+		case Disassembler6502::BBS3_INSTR:
+			return "BBS3";
+		case Disassembler6502::BBS4_INSTR:
+			return "BBS4";
+		case Disassembler6502::BBS5_INSTR:
+			return "BBS5";
+		case Disassembler6502::BBS6_INSTR:
+			return "BBS6";
+		case Disassembler6502::BBS7_INSTR:
+			return "BBS7";
+		case Disassembler6502::BCC_INSTR:
+			return "BCC";
+		case Disassembler6502::BCS_INSTR:
+			return "BCS";
+		case Disassembler6502::BEQ_INSTR:
+			return "BEQ";
+		case Disassembler6502::BIT_INSTR:
+			return "BIT";
+		case Disassembler6502::BMI_INSTR:
+			return "BMI";
+		case Disassembler6502::BNE_INSTR:
+			return "BNE";
+		case Disassembler6502::BPL_INSTR:
+			return "BPL";
+		case Disassembler6502::BRA_INSTR:
+			return "BRA";
+		case Disassembler6502::BRK_INSTR:
+			return "BRK";
+		case Disassembler6502::BVC_INSTR:
+			return "BVC";
+		case Disassembler6502::BVS_INSTR:
+			return "BVS";
+		case Disassembler6502::CLC_INSTR:
+			return "CLC";
+		case Disassembler6502::CLD_INSTR:
+			return "CLD";
+		case Disassembler6502::CLI_INSTR:
+			return "CLI";
+		case Disassembler6502::CLV_INSTR:
+			return "CLV";
+		case Disassembler6502::CMP_INSTR:
+			return "CMP";
+		case Disassembler6502::CPX_INSTR:
+			return "CPX";
+		case Disassembler6502::CPY_INSTR:
+			return "CPY";
+		case Disassembler6502::DEC_INSTR:
+			return "DEC";
+		case Disassembler6502::DEX_INSTR:
+			return "DEX";
+		case Disassembler6502::DEY_INSTR:
+			return "DEY";
+		case Disassembler6502::EOR_INSTR:
+			return "EOR";
+		case Disassembler6502::INC_INSTR:
+			return "INC";
+		case Disassembler6502::INX_INSTR:
+			return "INX";
+		case Disassembler6502::INY_INSTR:
+			return "INY";
+		case Disassembler6502::JMP_INSTR:
+			return "JMP";
+		case Disassembler6502::JSR_INSTR:
+			return "JSR";
+		case Disassembler6502::LDA_INSTR:
+			return "LDA";
+		case Disassembler6502::LDX_INSTR:
+			return "LDX";
+		case Disassembler6502::LDY_INSTR:
+			return "LDY";
+		case Disassembler6502::LSR_INSTR:
+			return "LSR";
+		case Disassembler6502::NOP_INSTR:
+			return "NOP";
+		case Disassembler6502::ORA_INSTR:
+			return "ORA";
+		case Disassembler6502::PHA_INSTR:
+			return "PHA";
+		case Disassembler6502::PHP_INSTR:
+			return "PHP";
+		case Disassembler6502::PHX_INSTR:
+			return "PHX";
+		case Disassembler6502::PHY_INSTR:
+			return "PHY";
+		case Disassembler6502::PLA_INSTR:
+			return "PLA";
+		case Disassembler6502::PLP_INSTR:
+			return "PLP";
+		case Disassembler6502::PLX_INSTR:
+			return "PLX";
+		case Disassembler6502::PLY_INSTR:
+			return "PLY";
+		case Disassembler6502::RMB0_INSTR:
+			return "RMB0";
+		case Disassembler6502::RMB1_INSTR:
+			return "RMB1";
+		case Disassembler6502::RMB2_INSTR:
+			return "RMB2";
+		case Disassembler6502::RMB3_INSTR:
+			return "RMB3";
+		case Disassembler6502::RMB4_INSTR:
+			return "RMB4";
+		case Disassembler6502::RMB5_INSTR:
+			return "RMB5";
+		case Disassembler6502::RMB6_INSTR:
+			return "RMB6";
+		case Disassembler6502::RMB7_INSTR:
+			return "RMB7";
+		case Disassembler6502::ROL_INSTR:
+			return "ROL";
+		case Disassembler6502::ROR_INSTR:
+			return "ROR";
+		case Disassembler6502::RTI_INSTR:
+			return "RTI";
+		case Disassembler6502::RTS_INSTR:
+			return "RTS";
+		case Disassembler6502::SBC_INSTR:
+			return "SBC";
+		case Disassembler6502::SEC_INSTR:
+			return "SEC";
+		case Disassembler6502::SED_INSTR:
+			return "SED";
+		case Disassembler6502::SEI_INSTR:
+			return "SEI";
+		case Disassembler6502::SMB0_INSTR:
+			return "SMB0";
+		case Disassembler6502::SMB1_INSTR:
+			return "SMB1";
+		case Disassembler6502::SMB2_INSTR:
+			return "SMB2";
+		case Disassembler6502::SMB3_INSTR:
+			return "SMB3";
+		case Disassembler6502::SMB4_INSTR:
+			return "SMB4";
+		case Disassembler6502::SMB5_INSTR:
+			return "SMB5";
+		case Disassembler6502::SMB6_INSTR:
+			return "SMB6";
+		case Disassembler6502::SMB7_INSTR:
+			return "SMB7";
+		case Disassembler6502::STA_INSTR:
+			return "STA";
+		case Disassembler6502::STP_INSTR:
+			return "STP";
+		case Disassembler6502::STX_INSTR:
+			return "STX";
+		case Disassembler6502::STY_INSTR:
+			return "STY";
+		case Disassembler6502::STZ_INSTR:
+			return "STZ";
+		case Disassembler6502::TAX_INSTR:
+			return "TAX";
+		case Disassembler6502::TAY_INSTR:
+			return "TAY";
+		case Disassembler6502::TRB_INSTR:
+			return "TRB";
+		case Disassembler6502::TSB_INSTR:
+			return "TSB";
+		case Disassembler6502::TSX_INSTR:
+			return "TSX";
+		case Disassembler6502::TXA_INSTR:
+			return "TXA";
+		case Disassembler6502::TXS_INSTR:
+			return "TXS";
+		case Disassembler6502::TYA_INSTR:
+			return "TYA";
+		case Disassembler6502::WAI_INSTR:
+			return "WAI";
+		}
+
+		return NULL;
+	}
+
+	static constexpr uint8_t operandLength(Disassembler6502::AddressingMode addressingMode)
+	{
+		switch (addressingMode)
+		{
+		case Disassembler6502::ABSOLUTE_AM:
+		case Disassembler6502::ABSOLUTE_INDEXED_INDIRECT_AM:
+		case Disassembler6502::ABSOLUTE_INDEXED_WITH_X_AM:
+		case Disassembler6502::ABSOLUTE_INDEXED_WITH_Y_AM:
+		case Disassembler6502::ABSOLUTE_INDIRECT_AM:
+			return 2;
+		case Disassembler6502::IMMEDIATE_ADDRESSING_AM:
+		case Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM:
+		case Disassembler6502::ZERO_PAGE_AM:
+		case Disassembler6502::ZERO_PAGE_INDEXED_INDIRECT_AM:
+		case Disassembler6502::ZERO_PAGE_INDEXED_WITH_X_AM:
+		case Disassembler6502::ZERO_PAGE_INDEXED_WITH_Y_AM:
+		case Disassembler6502::ZERO_PAGE_INDIRECT_AM:
+		case Disassembler6502::ZERO_PAGE_INDIRECT_INDEXED_WITH_Y_AM:
+			return 1;
+		case Disassembler6502::ACCUMULATOR_AM:
+		case Disassembler6502::IMPLIED_AM:
+		case Disassembler6502::STACK_AM:
+		default:
+			return 0;
+		}
+	}
+
+	static constexpr const char* operandPrefix(Disassembler6502::AddressingMode addressingMode)
+	{
+		switch (addressingMode)
+		{
+		case Disassembler6502::ABSOLUTE_INDEXED_INDIRECT_AM:
+		case Disassembler6502::ZERO_PAGE_INDEXED_INDIRECT_AM:
+		case Disassembler6502::ABSOLUTE_INDIRECT_AM:
+		case Disassembler6502::ZERO_PAGE_INDIRECT_AM:
+		case Disassembler6502::ZERO_PAGE_INDIRECT_INDEXED_WITH_Y_AM:
+			return "(";
+		case Disassembler6502::IMMEDIATE_ADDRESSING_AM:
+			return "#";
+		default:
+			return "";
+		}
+	}
+
+	static constexpr const char* operandSuffix(Disassembler6502::AddressingMode addressingMode)
+	{
+		switch (addressingMode)
+		{
+		case Disassembler6502::ABSOLUTE_INDEXED_INDIRECT_AM:
+		case Disassembler6502::ZERO_PAGE_INDEXED_INDIRECT_AM:
+			return ", X)";
+		case Disassembler6502::ABSOLUTE_INDEXED_WITH_X_AM:
+		case Disassembler6502::ZERO_PAGE_INDEXED_WITH_X_AM:
+			return ", X";
+		case Disassembler6502::ABSOLUTE_INDEXED_WITH_Y_AM:
+		case Disassembler6502::ZERO_PAGE_INDEXED_WITH_Y_AM:
+			return ", Y";
+		case Disassembler6502::ABSOLUTE_INDIRECT_AM:
+		case Disassembler6502::ZERO_PAGE_INDIRECT_AM:
+			return ")";
+		case Disassembler6502::ACCUMULATOR_AM:
+			return " A";
+		case Disassembler6502::ZERO_PAGE_INDIRECT_INDEXED_WITH_Y_AM:
+			return "), Y";
+		default:
+			return "";
+		}
+	}
+
+	static constexpr Descriptor descriptor(uint8_t data);
+
+	static constexpr bool isValid(uint8_t data);
+
+	// Opcode byte included
+	static constexpr uint8_t instructionLength(uint8_t data);
+
+	// The branch target for relative operands of the instruction at address, the operand itself otherwise
+	static constexpr uint16_t operandValue(const Descriptor& descriptor, uint16_t operand, uint16_t address);
+
+	// Same text as StreamingDisassembler6502::format(): "LDA #$02", or "???" for bytes that do not decode.
+	// Returns the text length; the buffer is always NUL terminated when capacity > 0
+	static constexpr size_t format(uint8_t opcodeData, uint16_t operand, uint16_t address, char* buffer, size_t capacity);
+
+	static constexpr size_t format(const Descriptor& descriptor, uint16_t operand, uint16_t address, char* buffer, size_t capacity);
+
+	// What format() returns, without writing the text
+	static constexpr size_t formatLength(const Descriptor& descriptor, uint16_t operand, uint16_t address);
+
+private:
+
+	static constexpr size_t textLength(const char* text)
+	{
+		size_t length = 0;
+		while (text[length] != '\0') {
+			length++;
+		}
+		return length;
+	}
+
+	static constexpr size_t append(const char* text, char* buffer, size_t capacity, size_t length)
+	{
+		for (; *text != '\0'; text++) {
+			if (length + 1 < capacity) {
+				buffer[length] = *text;
+			}
+			length++;
+		}
+
+		return length;
+	}
+};
+
+constexpr DecodeCore6502::DescriptorTable::DescriptorTable() :
+	entries()
+{
+	for (size_t i = 0; i < 256; i++) {
+		const uint8_t opcode = opcodeFromData(static_cast<uint8_t>(i));
+		const uint8_t addressingMode = addressingModeFromData(static_cast<uint8_t>(i));
+
+		if (opcode == INVALID_OPCODE || addressingMode == INVALID_ADDRESSING_MODE) {
+			entries[i] = { INVALID_OPCODE, 0, 0 };
+			continue;
+		}
+
+		entries[i] = { opcode, addressingMode, operandLength(static_cast<Disassembler6502::AddressingMode>(addressingMode)) };
+	}
+}
+
+inline constexpr DecodeCore6502::DescriptorTable DecodeCore6502::TABLE;
+
+constexpr DecodeCore6502::Descriptor DecodeCore6502::descriptor(uint8_t data)
+{
+	return TABLE.entries[data];
+}
+
+constexpr bool DecodeCore6502::isValid(uint8_t data)
+{
+	return TABLE.entries[data].opcode != INVALID_OPCODE;
+}
+
+constexpr uint8_t DecodeCore6502::instructionLength(uint8_t data)
+{
+	return static_cast<uint8_t>(1 + TABLE.entries[data].operandLength);
+}
+
+constexpr uint16_t DecodeCore6502::operandValue(const Descriptor& descriptor, uint16_t operand, uint16_t address)
+{
+	if (descriptor.addressingMode == Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM) {
+		return static_cast<uint16_t>(address + 1 + descriptor.operandLength + static_cast<int8_t>(operand));
+	}
+
+	return operand;
+}
+
+constexpr size_t DecodeCore6502::format(uint8_t opcodeData, uint16_t operand, uint16_t address, char* buffer, size_t capacity)
+{
+	return format(TABLE.entries[opcodeData], operand, address, buffer, capacity);
+}
+
+constexpr size_t DecodeCore6502::format(const Descriptor& entry, uint16_t operand, uint16_t address, char* buffer, size_t capacity)
+{
+	size_t length = 0;
+
+	if (entry.opcode == INVALID_OPCODE) {
+		length = append("???", buffer, capacity, length);
+	}
+	else {
+		const Disassembler6502::AddressingMode addressingMode = static_cast<Disassembler6502::AddressingMode>(entry.addressingMode);
+
+		length = append(mnemonic(static_cast<Disassembler6502::Opcode>(entry.opcode)), buffer, capacity, length);
+		length = append(" ", buffer, capacity, length);
+		length = append(operandPrefix(addressingMode), buffer, capacity, length);
+
+		if (entry.operandLength > 0) {
+			// one Byte values are printed with two digits, wider ones with four
+			const uint16_t value = operandValue(entry, operand, address);
+			const size_t digits = value > 0xFF ? 4 : 2;
+			char hex[6] = { '$', 0, 0, 0, 0, 0 };
+
+			for (size_t i = 0; i < digits; i++) {
+				hex[1 + i] = "0123456789ABCDEF"[(value >> (4 * (digits - 1 - i))) & 0xF];
+			}
+
+			length = append(hex, buffer, capacity, length);
+		}
+
+		length = append(operandSuffix(addressingMode), buffer, capacity, length);
+	}
+
+	if (capacity > 0) {
+		buffer[length < capacity ? length : capacity - 1] = '\0';
+	}
+
+	return length;
+}
+
+constexpr size_t DecodeCore6502::formatLength(const Descriptor& entry, uint16_t operand, uint16_t address)
+{
+	if (entry.opcode == INVALID_OPCODE) {
+		return 3;
+	}
+
+	const Disassembler6502::AddressingMode addressingMode = static_cast<Disassembler6502::AddressingMode>(entry.addressingMode);
+	size_t length =
+		textLength(mnemonic(static_cast<Disassembler6502::Opcode>(entry.opcode))) + 1 +
+		textLength(operandPrefix(addressingMode)) +
+		textLength(operandSuffix(addressingMode));
+
+	if (entry.operandLength > 0) {
+		length += operandValue(entry, operand, address) > 0xFF ? 5 : 3;
+	}
+
+	return length;
+}
+
+#endif
@@ -157,17 +157,28 @@ public:
 		1 + // hex symbol
 		4;  // max hex length
 
+	// Longest symbol to_string(SymbolLookup, const void*) prints; longer ones are printed as the number
+	// when the string has a fixed capacity
+	static const size_t MAX_SYMBOL_LEN = 64;
+
+	static const size_t MAX_SYMBOL_INSTRUCTION_LEN = MAX_INSTRUCTION_LEN - 1 - 4 + MAX_SYMBOL_LEN;
+
 #if ETL_NOT_USING_STL
 	typedef etl::string<MAX_INSTRUCTION_LEN> string;
+	typedef etl::string<MAX_SYMBOL_INSTRUCTION_LEN> symbolString;
 	typedef etl::string<MAX_OPCODE_LEN + 1> opcodeString;
 #else
 	typedef std::string string;
+	typedef std::string symbolString;
 	typedef std::string opcodeString;
 #endif
 
 	typedef ETL_OR_STD::bitset<ADDR_LEN> AddrBitset;
 	typedef ETL_OR_STD::bitset<DATA_LEN> DataBitset;
 
+	// Returns the name of address, or NULL to print it as a number
+	typedef const char* (*SymbolLookup)(const void* context, uint16_t address);
+
 	struct InstructionStruct {
 		const DataBitset data;
 		const opcodeString instructionString;
@@ -188,8 +199,15 @@ private:
 	size_t argumentNumberCount;
 	size_t currentDataOffset;
 
+	template <typename String>
+	ETL_OR_STD::optional<String> operandString(SymbolLookup lookup, const void* context) const;
+
 protected:
 
+	static ETL_OR_STD::optional<const Disassembler6502::InstructionStruct> instructionFromData(const Disassembler6502::DataBitset data);
+
+public:
+
 	static ETL_OR_STD::optional<Opcode> opcodeFromData(const DataBitset& data);
 
 	static const char* stringFromOpcode(const Opcode instruction);
@@ -198,9 +216,7 @@ protected:
 
 	static uint8_t argumentNumberFromAddressingMode(const Disassembler6502::AddressingMode addressingMode);
 
-	static ETL_OR_STD::optional<const Disassembler6502::InstructionStruct> instructionFromData(const Disassembler6502::DataBitset data);
-
-public:
+	static void affixesFromAddressingMode(const Disassembler6502::AddressingMode addressingMode, const char*& prefix, const char*& suffix);
 
 	Disassembler6502();
 
@@ -208,6 +224,9 @@ public:
 
 	ETL_OR_STD::optional<string> to_string() const;
 
+	// Operands that are addresses, not immediate values, are printed as their symbol when lookup knows one
+	ETL_OR_STD::optional<symbolString> to_string(SymbolLookup lookup, const void* context) const;
+
 	InstructionStatus getInstructionStatus() const;
 
 	ETL_OR_STD::optional<const InstructionStruct> getInstruction() const;
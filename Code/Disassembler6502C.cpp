@@ -0,0 +1,186 @@
+#include "Disassembler6502C.h"
+#include "DecodeCore6502.h"
+#include "Disassembler6502.h"
+#include "InstructionLengthKernel6502.h"
+#include "StreamingDisassembler6502.h"
+
+#include <new>
+
+namespace {
+
+	const uint32_t CONTEXT_MAGIC = 0x36353032;
+
+	bool is65C02Only(const Disassembler6502::Opcode opcode, const Disassembler6502::AddressingMode addressingMode)
+	{
+		if (opcode >= Disassembler6502::BBR0_INSTR && opcode <= Disassembler6502::BBS7_INSTR) {
+			return true;
+		}
+
+		if ((opcode >= Disassembler6502::RMB0_INSTR && opcode <= Disassembler6502::RMB7_INSTR) ||
+			(opcode >= Disassembler6502::SMB0_INSTR && opcode <= Disassembler6502::SMB7_INSTR)) {
+			return true;
+		}
+
+		switch (opcode)
+		{
+		case Disassembler6502::BRA_INSTR:
+		case Disassembler6502::PHX_INSTR:
+		case Disassembler6502::PHY_INSTR:
+		case Disassembler6502::PLX_INSTR:
+		case Disassembler6502::PLY_INSTR:
+		case Disassembler6502::STP_INSTR:
+		case Disassembler6502::STZ_INSTR:
+		case Disassembler6502::TRB_INSTR:
+		case Disassembler6502::TSB_INSTR:
+		case Disassembler6502::WAI_INSTR:
+			return true;
+		case Disassembler6502::BIT_INSTR:
+			return addressingMode != Disassembler6502::ABSOLUTE_AM && addressingMode != Disassembler6502::ZERO_PAGE_AM;
+		case Disassembler6502::INC_INSTR:
+		case Disassembler6502::DEC_INSTR:
+			return addressingMode == Disassembler6502::ACCUMULATOR_AM;
+		default:
+			break;
+		}
+
+		return addressingMode == Disassembler6502::ZERO_PAGE_INDIRECT_AM ||
+			addressingMode == Disassembler6502::ABSOLUTE_INDEXED_INDIRECT_AM;
+	}
+
+	typedef DecodeCore6502::Descriptor RecordTemplate;
+
+	// The 65C02 records are DecodeCore6502::TABLE itself; the 6502 ones drop what only the 65C02 decodes
+	struct RecordTables {
+		RecordTemplate nmos[256];
+
+		RecordTables()
+		{
+			for (size_t i = 0; i < 256; i++) {
+				const RecordTemplate& entry = DecodeCore6502::TABLE.entries[i];
+				const RecordTemplate invalid = { DASM6502_INVALID_OPCODE, 0, 0 };
+
+				nmos[i] = entry.opcode != DecodeCore6502::INVALID_OPCODE &&
+					is65C02Only(static_cast<Disassembler6502::Opcode>(entry.opcode), static_cast<Disassembler6502::AddressingMode>(entry.addressingMode)) ?
+					invalid :
+					entry;
+			}
+		}
+	};
+
+	const RecordTables& recordTables()
+	{
+		static const RecordTables tables;
+		return tables;
+	}
+
+}
+
+struct dasm6502_context {
+	uint32_t magic;
+	uint16_t address;
+	const RecordTemplate* templates;
+};
+
+uint32_t dasm6502_abi_version(void)
+{
+	return DASM6502_ABI_VERSION;
+}
+
+size_t dasm6502_context_size(void)
+{
+	return sizeof(dasm6502_context);
+}
+
+dasm6502_context* dasm6502_context_init(void* memory, size_t memory_size, const dasm6502_options* options)
+{
+	if (memory == NULL || options == NULL ||
+		memory_size < sizeof(dasm6502_context) ||
+		reinterpret_cast<uintptr_t>(memory) % alignof(dasm6502_context) != 0 ||
+		options->struct_size < sizeof(dasm6502_options) ||
+		(options->cpu != DASM6502_CPU_65C02 && options->cpu != DASM6502_CPU_6502)) {
+		return NULL;
+	}
+
+	dasm6502_context* context = new (memory) dasm6502_context();
+	context->magic = CONTEXT_MAGIC;
+	context->address = options->base_address;
+	context->templates = options->cpu == DASM6502_CPU_6502 ? recordTables().nmos : DecodeCore6502::TABLE.entries;
+
+	return context;
+}
+
+size_t dasm6502_decode(dasm6502_context* context, const uint8_t* input, size_t input_length,
+	dasm6502_record* records, size_t record_capacity, size_t* consumed)
+{
+	size_t offset = 0;
+	size_t count = 0;
+
+	if (context != NULL && context->magic == CONTEXT_MAGIC && (input != NULL || input_length == 0) && (records != NULL || record_capacity == 0)) {
+		const RecordTemplate* templates = context->templates;
+
+		while (offset < input_length && count < record_capacity) {
+			const RecordTemplate& entry = templates[input[offset]];
+
+			if (offset + 1 + entry.operandLength > input_length) {
+				break;
+			}
+
+			dasm6502_record& record = records[count++];
+			record.address = static_cast<uint16_t>(context->address + offset);
+			record.opcode_data = input[offset];
+			record.opcode = entry.opcode;
+			record.addressing_mode = entry.addressingMode;
+			record.operand_length = entry.operandLength;
+			record.operand = entry.operandLength == 0 ? 0 :
+				entry.operandLength == 1 ? input[offset + 1] :
+				static_cast<uint16_t>(input[offset + 1] | (input[offset + 2] << 8));
+
+			offset += 1 + entry.operandLength;
+		}
+
+		context->address = static_cast<uint16_t>(context->address + offset);
+	}
+
+	if (consumed != NULL) {
+		*consumed = offset;
+	}
+
+	return count;
+}
+
+size_t dasm6502_format(const dasm6502_record* records, size_t record_count, char* text, size_t text_capacity, size_t* text_length)
+{
+	size_t length = 0;
+	size_t count = 0;
+
+	if ((records != NULL || record_count == 0) && (text != NULL || text_capacity == 0)) {
+		char line[StreamingDisassembler6502::MAX_TEXT_LEN + 1];
+
+		for (; count < record_count; count++) {
+			const dasm6502_record& record = records[count];
+			const StreamingDisassembler6502::Record streamRecord = {
+				record.address,
+				record.operand,
+				record.opcode_data,
+				record.opcode == DASM6502_INVALID_OPCODE ? static_cast<uint8_t>(0) : InstructionLengthKernel6502::classify(record.opcode_data)
+			};
+
+			const size_t lineLength = StreamingDisassembler6502::format(streamRecord, line, sizeof(line));
+
+			if (length + lineLength + 1 > text_capacity) {
+				break;
+			}
+
+			for (size_t i = 0; i < lineLength; i++) {
+				text[length++] = line[i];
+			}
+			text[length++] = '\n';
+		}
+	}
+
+	if (text_length != NULL) {
+		*text_length = length;
+	}
+
+	return count;
+}
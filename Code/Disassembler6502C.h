@@ -0,0 +1,73 @@
+#ifndef DISASSEMBLER_6502_C_H
+#define DISASSEMBLER_6502_C_H
+
+/*
+ * Stable C interface for decoding whole buffers at once.
+ * Nothing is allocated behind the caller's back: the context lives in caller memory of
+ * dasm6502_context_size() bytes and all output goes to caller owned arrays.
+ * Contexts are independent, so threads can decode in parallel with one context each.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DASM6502_ABI_VERSION 1
+
+/* opcode value of records for bytes that do not decode */
+#define DASM6502_INVALID_OPCODE 0xFF
+
+typedef enum {
+	DASM6502_CPU_65C02 = 0,
+	/* NMOS 6502: the 65C02 additions (BRA, STZ, PHX, BBRx, (zp) addressing...) decode as invalid */
+	DASM6502_CPU_6502 = 1
+} dasm6502_cpu;
+
+typedef struct {
+	uint32_t struct_size; /* sizeof(dasm6502_options), for forward compatibility */
+	uint16_t base_address;
+	uint8_t cpu;          /* dasm6502_cpu */
+	uint8_t reserved;
+} dasm6502_options;
+
+typedef struct {
+	uint16_t address;
+	uint16_t operand;
+	uint8_t opcode_data;
+	uint8_t opcode;          /* Disassembler6502::Opcode, or DASM6502_INVALID_OPCODE */
+	uint8_t addressing_mode; /* Disassembler6502::AddressingMode */
+	uint8_t operand_length;
+} dasm6502_record;
+
+typedef struct dasm6502_context dasm6502_context;
+
+uint32_t dasm6502_abi_version(void);
+
+size_t dasm6502_context_size(void);
+
+/* Returns NULL when memory is too small or misaligned, or options are invalid */
+dasm6502_context* dasm6502_context_init(void* memory, size_t memory_size, const dasm6502_options* options);
+
+/*
+ * Decodes input into up to record_capacity records and returns how many were written.
+ * *consumed receives the bytes used; decoding stops before an instruction that does not fit in
+ * the records or whose operand runs past the end of input, so the remaining bytes can be passed again
+ * with more data. Addresses continue from call to call.
+ */
+size_t dasm6502_decode(dasm6502_context* context, const uint8_t* input, size_t input_length,
+	dasm6502_record* records, size_t record_capacity, size_t* consumed);
+
+/*
+ * Writes one "TEXT\n" line per record into text and returns how many records were written.
+ * *text_length receives the bytes used. Stops at the first record whose line does not fit.
+ */
+size_t dasm6502_format(const dasm6502_record* records, size_t record_count, char* text, size_t text_capacity, size_t* text_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
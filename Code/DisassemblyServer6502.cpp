@@ -0,0 +1,479 @@
+#include "DisassemblyServer6502.h"
+#include "ListingLine6502.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+
+	const std::chrono::milliseconds ACCEPT_BACKOFF(100);
+
+	void putUint16(std::vector<uint8_t>& buffer, uint16_t value)
+	{
+		buffer.push_back(static_cast<uint8_t>(value));
+		buffer.push_back(static_cast<uint8_t>(value >> 8));
+	}
+
+	void putUint32(std::vector<uint8_t>& buffer, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++) {
+			buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+		}
+	}
+
+	void putUint64(std::vector<uint8_t>& buffer, uint64_t value)
+	{
+		for (int i = 0; i < 8; i++) {
+			buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+		}
+	}
+
+	uint16_t getUint16(const uint8_t* data)
+	{
+		return static_cast<uint16_t>(data[0] | (data[1] << 8));
+	}
+
+	uint32_t getUint32(const uint8_t* data)
+	{
+		return static_cast<uint32_t>(data[0]) |
+			(static_cast<uint32_t>(data[1]) << 8) |
+			(static_cast<uint32_t>(data[2]) << 16) |
+			(static_cast<uint32_t>(data[3]) << 24);
+	}
+
+	uint64_t getUint64(const uint8_t* data)
+	{
+		return static_cast<uint64_t>(getUint32(data)) | (static_cast<uint64_t>(getUint32(data + 4)) << 32);
+	}
+
+	bool readFully(int socket, uint8_t* data, size_t length)
+	{
+		while (length > 0) {
+			const ssize_t received = recv(socket, data, length, 0);
+			if (received <= 0) {
+				return false;
+			}
+
+			data += received;
+			length -= static_cast<size_t>(received);
+		}
+
+		return true;
+	}
+
+	bool writeFully(int socket, const uint8_t* data, size_t length)
+	{
+		while (length > 0) {
+			const ssize_t sent = send(socket, data, length, MSG_NOSIGNAL);
+			if (sent <= 0) {
+				return false;
+			}
+
+			data += sent;
+			length -= static_cast<size_t>(sent);
+		}
+
+		return true;
+	}
+
+	bool writeMessage(int socket, uint8_t type, const uint8_t* payload, size_t length)
+	{
+		std::vector<uint8_t> header;
+		putUint32(header, static_cast<uint32_t>(length));
+		header.push_back(type);
+
+		return writeFully(socket, header.data(), header.size()) && writeFully(socket, payload, length);
+	}
+
+	bool readMessage(int socket, uint8_t& type, std::vector<uint8_t>& payload)
+	{
+		uint8_t header[DisassemblyServer6502::HEADER_LEN];
+
+		if (!readFully(socket, header, sizeof(header))) {
+			return false;
+		}
+
+		const uint32_t length = getUint32(header);
+		if (length > DisassemblyServer6502::MAX_PAYLOAD_LEN) {
+			return false;
+		}
+
+		type = header[4];
+		payload.resize(length);
+
+		return readFully(socket, payload.data(), length);
+	}
+
+	bool socketAddress(const char* path, sockaddr_un& address)
+	{
+		if (strlen(path) >= sizeof(address.sun_path)) {
+			return false;
+		}
+
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		strcpy(address.sun_path, path);
+
+		return true;
+	}
+
+}
+
+DisassemblyServer6502::DisassemblyServer6502(size_t memoryBudget) :
+	cache(memoryBudget),
+	listenSocket(-1),
+	running(false)
+{
+}
+
+DisassemblyServer6502::~DisassemblyServer6502()
+{
+	stop();
+}
+
+bool DisassemblyServer6502::listen(const char* path)
+{
+	sockaddr_un address;
+	if (listenSocket >= 0 || !socketAddress(path, address)) {
+		return false;
+	}
+
+	const int newSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (newSocket < 0) {
+		return false;
+	}
+
+	unlink(path);
+
+	if (bind(newSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(newSocket, SOMAXCONN) != 0) {
+		::close(newSocket);
+		return false;
+	}
+
+	listenSocket = newSocket;
+	socketPath = path;
+	running = true;
+
+	return true;
+}
+
+void DisassemblyServer6502::run()
+{
+	while (running) {
+		const int clientSocket = accept(listenSocket, NULL, NULL);
+		const int acceptError = errno;
+
+		reapClients();
+
+		if (clientSocket < 0) {
+			if (acceptError == EINTR || acceptError == ECONNABORTED) {
+				continue;
+			}
+
+			if (acceptError == EMFILE || acceptError == ENFILE || acceptError == ENOBUFS || acceptError == ENOMEM) {
+				// finished clients give back descriptors, so waiting can help
+				std::this_thread::sleep_for(ACCEPT_BACKOFF);
+				continue;
+			}
+
+			break;
+		}
+
+		std::lock_guard<std::mutex> lock(clientMutex);
+
+		if (!running) {
+			::close(clientSocket);
+			break;
+		}
+
+		clients.emplace_back();
+		Client& client = clients.back();
+		client.socket = clientSocket;
+		client.done = false;
+		client.thread = std::thread(&DisassemblyServer6502::serveClient, this, &client);
+	}
+}
+
+void DisassemblyServer6502::reapClients()
+{
+	std::list<Client> finished;
+	{
+		std::lock_guard<std::mutex> lock(clientMutex);
+
+		for (std::list<Client>::iterator client = clients.begin(); client != clients.end(); ) {
+			const std::list<Client>::iterator current = client++;
+			if (current->done) {
+				finished.splice(finished.end(), clients, current);
+			}
+		}
+	}
+
+	for (Client& client : finished) {
+		client.thread.join();
+	}
+}
+
+void DisassemblyServer6502::stop()
+{
+	if (listenSocket < 0) {
+		return;
+	}
+
+	running = false;
+	shutdown(listenSocket, SHUT_RDWR);
+
+	std::list<Client> stopped;
+	{
+		std::lock_guard<std::mutex> lock(clientMutex);
+
+		for (Client& client : clients) {
+			if (!client.done) {
+				shutdown(client.socket, SHUT_RDWR);
+			}
+		}
+
+		stopped.swap(clients);
+	}
+
+	for (Client& client : stopped) {
+		client.thread.join();
+	}
+
+	::close(listenSocket);
+	listenSocket = -1;
+	unlink(socketPath.c_str());
+}
+
+void DisassemblyServer6502::serveClient(Client* client)
+{
+	const int clientSocket = client->socket;
+	uint8_t type;
+	std::vector<uint8_t> request;
+	std::vector<uint8_t> response;
+
+	while (running && readMessage(clientSocket, type, request)) {
+		response.clear();
+		const Status status = handle(type, request.data(), request.size(), response);
+
+		if (!writeMessage(clientSocket, static_cast<uint8_t>(status), response.data(), response.size())) {
+			break;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(clientMutex);
+	::close(clientSocket);
+	client->done = true;
+}
+
+DisassemblyServer6502::Status DisassemblyServer6502::handle(uint8_t type, const uint8_t* request, size_t requestLength, std::vector<uint8_t>& response)
+{
+	if (type == LOAD_IMAGE_REQUEST) {
+		if (requestLength < 2) {
+			return BAD_REQUEST_STATUS;
+		}
+
+		const std::shared_ptr<const ImageCache6502::Image> image = cache.load(request + 2, requestLength - 2, getUint16(request));
+		putUint64(response, image->id);
+
+		return OK_STATUS;
+	}
+
+	if (requestLength != 8 + 2 + (type == DISASSEMBLE_RANGE_REQUEST ? 2 : 0)) {
+		return BAD_REQUEST_STATUS;
+	}
+
+	const std::shared_ptr<const ImageCache6502::Image> image = cache.find(getUint64(request));
+	if (!image) {
+		return UNKNOWN_IMAGE_STATUS;
+	}
+
+	const InstructionColumns6502::View view = image->columns.view();
+	const uint16_t address = getUint16(request + 8);
+	char line[ListingLine6502::MAX_LEN + 1];
+
+	switch (type)
+	{
+	case DISASSEMBLE_RANGE_REQUEST: {
+		const uint16_t last = getUint16(request + 10);
+		size_t row = image->rowContaining(address);
+
+		if (row == view.count) {
+			return NOT_FOUND_STATUS;
+		}
+
+		const size_t lastOffset = static_cast<uint16_t>(last - image->baseAddress);
+
+		for (; row < view.count && static_cast<uint16_t>(view.addresses[row] - image->baseAddress) <= lastOffset; row++) {
+			char* text = ListingLine6502::formatPrefix(view.addresses[row], line);
+			text += ListingLine6502::formatText(view, row, NULL, text, sizeof(line) - (text - line));
+			*text++ = '\n';
+
+			response.insert(response.end(), line, text);
+		}
+
+		return OK_STATUS;
+	}
+	case LOOKUP_ADDRESS_REQUEST: {
+		const size_t row = image->rowContaining(address);
+
+		if (row == view.count) {
+			return NOT_FOUND_STATUS;
+		}
+
+		const size_t textLength = ListingLine6502::formatText(view, row, NULL, line, sizeof(line));
+
+		putUint16(response, view.addresses[row]);
+		response.push_back(view.opcodeData[row]);
+		response.push_back(view.operandLengths[row]);
+		putUint16(response, view.operands[row]);
+		response.insert(response.end(), line, line + textLength);
+
+		return OK_STATUS;
+	}
+	case CROSS_REFERENCES_REQUEST: {
+		const std::vector<uint16_t>& targets = image->referenceTargets;
+		const std::pair<std::vector<uint16_t>::const_iterator, std::vector<uint16_t>::const_iterator> range =
+			std::equal_range(targets.begin(), targets.end(), address);
+
+		putUint32(response, static_cast<uint32_t>(range.second - range.first));
+
+		for (size_t i = range.first - targets.begin(); i < static_cast<size_t>(range.second - targets.begin()); i++) {
+			putUint16(response, view.addresses[image->referenceRows[i]]);
+		}
+
+		return OK_STATUS;
+	}
+	default:
+		return BAD_REQUEST_STATUS;
+	}
+}
+
+ImageCache6502& DisassemblyServer6502::getCache()
+{
+	return cache;
+}
+
+DisassemblyClient6502::DisassemblyClient6502() : clientSocket(-1) {}
+
+DisassemblyClient6502::~DisassemblyClient6502()
+{
+	close();
+}
+
+bool DisassemblyClient6502::connect(const char* path)
+{
+	sockaddr_un address;
+	if (!socketAddress(path, address)) {
+		return false;
+	}
+
+	close();
+
+	clientSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (clientSocket < 0) {
+		return false;
+	}
+
+	if (::connect(clientSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void DisassemblyClient6502::close()
+{
+	if (clientSocket >= 0) {
+		::close(clientSocket);
+		clientSocket = -1;
+	}
+}
+
+bool DisassemblyClient6502::request(uint8_t type, const std::vector<uint8_t>& payload, uint8_t& status, std::vector<uint8_t>& response)
+{
+	return clientSocket >= 0 &&
+		writeMessage(clientSocket, type, payload.data(), payload.size()) &&
+		readMessage(clientSocket, status, response);
+}
+
+bool DisassemblyClient6502::loadImage(const uint8_t* data, size_t length, uint16_t baseAddress, uint64_t& id)
+{
+	std::vector<uint8_t> payload;
+	payload.reserve(2 + length);
+	putUint16(payload, baseAddress);
+	payload.insert(payload.end(), data, data + length);
+
+	uint8_t status;
+	std::vector<uint8_t> response;
+
+	if (!request(DisassemblyServer6502::LOAD_IMAGE_REQUEST, payload, status, response) ||
+		status != DisassemblyServer6502::OK_STATUS ||
+		response.size() != 8) {
+		return false;
+	}
+
+	id = getUint64(response.data());
+	return true;
+}
+
+bool DisassemblyClient6502::disassembleRange(uint64_t id, uint16_t first, uint16_t last, std::string& listing)
+{
+	std::vector<uint8_t> payload;
+	putUint64(payload, id);
+	putUint16(payload, first);
+	putUint16(payload, last);
+
+	uint8_t status;
+	std::vector<uint8_t> response;
+
+	if (!request(DisassemblyServer6502::DISASSEMBLE_RANGE_REQUEST, payload, status, response) ||
+		status != DisassemblyServer6502::OK_STATUS) {
+		return false;
+	}
+
+	listing.assign(response.begin(), response.end());
+	return true;
+}
+
+bool DisassemblyClient6502::crossReferences(uint64_t id, uint16_t target, std::vector<uint16_t>& sources)
+{
+	std::vector<uint8_t> payload;
+	putUint64(payload, id);
+	putUint16(payload, target);
+
+	uint8_t status;
+	std::vector<uint8_t> response;
+
+	if (!request(DisassemblyServer6502::CROSS_REFERENCES_REQUEST, payload, status, response) ||
+		status != DisassemblyServer6502::OK_STATUS ||
+		response.size() < 4) {
+		return false;
+	}
+
+	const uint32_t count = getUint32(response.data());
+	if (response.size() != 4 + 2 * static_cast<size_t>(count)) {
+		return false;
+	}
+
+	sources.clear();
+	for (uint32_t i = 0; i < count; i++) {
+		sources.push_back(getUint16(response.data() + 4 + 2 * i));
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef DISASSEMBLY_SERVER_6502_H
+#define DISASSEMBLY_SERVER_6502_H
+
+#include "ImageCache6502.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Local query daemon over a Unix domain socket, serving images kept resident in an ImageCache6502. POSIX only.
+//
+// Every message is a little endian uint32 payload length, one type (request) or status (response) Byte and the payload:
+//   LOAD_IMAGE_REQUEST          uint16 base address, image bytes      -> uint64 image id
+//   DISASSEMBLE_RANGE_REQUEST   uint64 id, uint16 first, uint16 last  -> listing text, one "$XXXX\tTEXT\n" line per instruction
+//   LOOKUP_ADDRESS_REQUEST      uint64 id, uint16 address             -> uint16 address, uint8 opcode, uint8 operand length, uint16 operand, text
+//   CROSS_REFERENCES_REQUEST    uint64 id, uint16 target              -> uint32 count, count uint16 source addresses
+class DisassemblyServer6502
+{
+public:
+
+	enum RequestType {
+		LOAD_IMAGE_REQUEST = 1,
+		DISASSEMBLE_RANGE_REQUEST,
+		LOOKUP_ADDRESS_REQUEST,
+		CROSS_REFERENCES_REQUEST
+	};
+
+	enum Status {
+		OK_STATUS,
+		UNKNOWN_IMAGE_STATUS,
+		BAD_REQUEST_STATUS,
+		NOT_FOUND_STATUS
+	};
+
+	static const size_t HEADER_LEN = 5;
+	static const size_t MAX_PAYLOAD_LEN = 64 * 1024 * 1024;
+
+private:
+
+	ImageCache6502 cache;
+	std::string socketPath;
+	int listenSocket;
+	std::atomic<bool> running;
+
+	// A client is marked done by its own thread and joined by run() on the next accept, or by stop()
+	struct Client {
+		int socket;
+		bool done;
+		std::thread thread;
+	};
+
+	std::mutex clientMutex;
+	std::list<Client> clients;
+
+	void serveClient(Client* client);
+
+	void reapClients();
+
+public:
+
+	explicit DisassemblyServer6502(size_t memoryBudget);
+	~DisassemblyServer6502();
+
+	DisassemblyServer6502(const DisassemblyServer6502&) = delete;
+	DisassemblyServer6502& operator=(const DisassemblyServer6502&) = delete;
+
+	// Binds and listens on socketPath, replacing a stale socket file
+	bool listen(const char* socketPath);
+
+	// Accepts clients until stop() is called or accepting fails for good; each client is served on its own thread.
+	// Interrupted and aborted accepts are retried, running out of descriptors or memory backs off and retries
+	void run();
+
+	void stop();
+
+	// Answers one request; used by the socket loop and usable in process
+	Status handle(uint8_t type, const uint8_t* request, size_t requestLength, std::vector<uint8_t>& response);
+
+	ImageCache6502& getCache();
+};
+
+class DisassemblyClient6502
+{
+private:
+
+	int clientSocket;
+
+public:
+
+	DisassemblyClient6502();
+	~DisassemblyClient6502();
+
+	DisassemblyClient6502(const DisassemblyClient6502&) = delete;
+	DisassemblyClient6502& operator=(const DisassemblyClient6502&) = delete;
+
+	bool connect(const char* socketPath);
+
+	void close();
+
+	// Returns false when the connection failed; status holds the server's answer otherwise
+	bool request(uint8_t type, const std::vector<uint8_t>& payload, uint8_t& status, std::vector<uint8_t>& response);
+
+	bool loadImage(const uint8_t* data, size_t length, uint16_t baseAddress, uint64_t& id);
+
+	bool disassembleRange(uint64_t id, uint16_t first, uint16_t last, std::string& listing);
+
+	bool crossReferences(uint64_t id, uint16_t target, std::vector<uint16_t>& sources);
+};
+
+#endif
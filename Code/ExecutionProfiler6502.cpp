@@ -0,0 +1,127 @@
+#include "ExecutionProfiler6502.h"
+#include "CycleTable6502.h"
+#include "InstructionLengthKernel6502.h"
+
+#include <algorithm>
+
+ExecutionProfiler6502::ExecutionProfiler6502() :
+	counters(ADDRESS_COUNT),
+	totalCycles(0),
+	totalExecutions(0)
+{
+}
+
+void ExecutionProfiler6502::addInstruction(uint16_t address, uint8_t opcodeData, unsigned penalties)
+{
+	addInstruction(address, CycleTable6502::cycles(opcodeData, penalties));
+}
+
+void ExecutionProfiler6502::addSyncTrace(const uint16_t* syncAddresses, const uint64_t* syncCycles, size_t count)
+{
+	if (count == 0) {
+		return;
+	}
+
+	for (size_t i = 0; i + 1 < count; i++) {
+		addInstruction(syncAddresses[i], static_cast<uint32_t>(syncCycles[i + 1] - syncCycles[i]));
+	}
+
+	addInstruction(syncAddresses[count - 1], 0);
+}
+
+void ExecutionProfiler6502::addInstructionTrace(const uint16_t* addresses, const uint8_t* opcodeData, size_t count)
+{
+	const uint8_t* classTable = InstructionLengthKernel6502::table();
+	const CycleTable6502::Cost* costTable = CycleTable6502::table();
+
+	for (size_t i = 0; i < count; i++) {
+		unsigned penalties = CycleTable6502::NO_PENALTY;
+
+		if ((costTable[opcodeData[i]].costFlags & CycleTable6502::BRANCH_COST) && i + 1 < count) {
+			const uint16_t fallThrough = static_cast<uint16_t>(addresses[i] + InstructionLengthKernel6502::instructionLength(classTable[opcodeData[i]]));
+
+			if (addresses[i + 1] != fallThrough) {
+				penalties |= CycleTable6502::BRANCH_TAKEN;
+
+				if (CycleTable6502::pageCrossed(fallThrough, addresses[i + 1])) {
+					penalties |= CycleTable6502::PAGE_CROSSED;
+				}
+			}
+		}
+
+		addInstruction(addresses[i], opcodeData[i], penalties);
+	}
+}
+
+void ExecutionProfiler6502::merge(const ExecutionProfiler6502& other)
+{
+	for (size_t i = 0; i < ADDRESS_COUNT; i++) {
+		counters[i].executions += other.counters[i].executions;
+		counters[i].cycles += other.counters[i].cycles;
+	}
+
+	totalExecutions += other.totalExecutions;
+	totalCycles += other.totalCycles;
+}
+
+void ExecutionProfiler6502::clear()
+{
+	std::fill(counters.begin(), counters.end(), Counter());
+	totalExecutions = 0;
+	totalCycles = 0;
+}
+
+const ExecutionProfiler6502::Counter& ExecutionProfiler6502::counter(uint16_t address) const
+{
+	return counters[address];
+}
+
+uint64_t ExecutionProfiler6502::getTotalCycles() const
+{
+	return totalCycles;
+}
+
+uint64_t ExecutionProfiler6502::getTotalExecutions() const
+{
+	return totalExecutions;
+}
+
+std::vector<ExecutionProfiler6502::HotSpot> ExecutionProfiler6502::hotSpots(size_t limit) const
+{
+	std::vector<HotSpot> spots;
+
+	for (size_t i = 0; i < ADDRESS_COUNT; i++) {
+		if (counters[i].executions != 0) {
+			spots.push_back({ static_cast<uint16_t>(i), counters[i].executions, counters[i].cycles });
+		}
+	}
+
+	const auto moreCycles = [](const HotSpot& left, const HotSpot& right) {
+		return left.cycles != right.cycles ? left.cycles > right.cycles : left.address < right.address;
+	};
+
+	if (limit < spots.size()) {
+		std::partial_sort(spots.begin(), spots.begin() + limit, spots.end(), moreCycles);
+		spots.resize(limit);
+	}
+	else {
+		std::sort(spots.begin(), spots.end(), moreCycles);
+	}
+
+	return spots;
+}
+
+void ExecutionProfiler6502::writeReport(FILE* file, size_t limit) const
+{
+	fprintf(file, "address\texecutions\tcycles\tpercent\n");
+
+	for (const HotSpot& spot : hotSpots(limit)) {
+		const double percent = totalCycles != 0 ? 100.0 * static_cast<double>(spot.cycles) / static_cast<double>(totalCycles) : 0.0;
+
+		fprintf(file, "$%04X\t%llu\t%llu\t%.2f\n",
+			spot.address,
+			static_cast<unsigned long long>(spot.executions),
+			static_cast<unsigned long long>(spot.cycles),
+			percent);
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef EXECUTION_PROFILER_6502_H
+#define EXECUTION_PROFILER_6502_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Per address execution counts and cycle totals over the 64 KiB address space.
+// Count and cycles of one address share a 16 Byte slot, so recording an instruction touches one cache line;
+// the slots are allocated once and nothing is allocated while recording.
+class ExecutionProfiler6502
+{
+public:
+
+	static const size_t ADDRESS_COUNT = 0x10000;
+
+	struct Counter {
+		uint64_t executions;
+		uint64_t cycles;
+	};
+
+	struct HotSpot {
+		uint16_t address;
+		uint64_t executions;
+		uint64_t cycles;
+	};
+
+private:
+
+	std::vector<Counter> counters;
+	uint64_t totalCycles;
+	uint64_t totalExecutions;
+
+public:
+
+	ExecutionProfiler6502();
+
+	void addInstruction(uint16_t address, uint32_t cycles)
+	{
+		Counter& counter = counters[address];
+		counter.executions++;
+		counter.cycles += cycles;
+		totalExecutions++;
+		totalCycles += cycles;
+	}
+
+	// Cycles from CycleTable6502, penalties is a CycleTable6502::Penalty mask
+	void addInstruction(uint16_t address, uint8_t opcodeData, unsigned penalties);
+
+	// Bus trace form: the address and cycle number of every SYNC (opcode fetch).
+	// Each instruction costs the cycles up to the next SYNC, so the last one is only counted as executed.
+	void addSyncTrace(const uint16_t* syncAddresses, const uint64_t* syncCycles, size_t count);
+
+	// Instruction trace form: executed addresses and opcodes in order. Branch taken and branch
+	// page crossing are inferred from the next address; indexed page crossings need effective addresses and are ignored
+	void addInstructionTrace(const uint16_t* addresses, const uint8_t* opcodeData, size_t count);
+
+	void merge(const ExecutionProfiler6502& other);
+
+	void clear();
+
+	const Counter& counter(uint16_t address) const;
+
+	uint64_t getTotalCycles() const;
+
+	uint64_t getTotalExecutions() const;
+
+	// The limit addresses with the most cycles, most expensive first
+	std::vector<HotSpot> hotSpots(size_t limit) const;
+
+	void writeReport(FILE* file, size_t limit) const;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef HASH_MIX_6502_H
+#define HASH_MIX_6502_H
+
+#include <cstdint>
+
+// The 64 bit mixing step shared by the token, shingle and band hashes
+class HashMix6502
+{
+public:
+
+	// splitmix64 finalizer
+	static constexpr uint64_t mix(uint64_t value)
+	{
+		value ^= value >> 30;
+		value *= 0xBF58476D1CE4E5B9ULL;
+		value ^= value >> 27;
+		value *= 0x94D049BB133111EBULL;
+		value ^= value >> 31;
+		return value;
+	}
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "ImageCache6502.h"
+#include "BankedDisassembly6502.h"
+
+#include <algorithm>
+
+size_t ImageCache6502::Image::memoryUsage() const
+{
+	return sizeof(Image) +
+		bytes.capacity() +
+		columns.addresses.capacity() * sizeof(uint16_t) +
+		columns.opcodeData.capacity() +
+		columns.opcodes.capacity() +
+		columns.addressingModes.capacity() +
+		columns.operandLengths.capacity() +
+		columns.operands.capacity() * sizeof(uint16_t) +
+		referenceTargets.capacity() * sizeof(uint16_t) +
+		referenceRows.capacity() * sizeof(uint32_t);
+}
+
+size_t ImageCache6502::Image::rowContaining(uint16_t address) const
+{
+	const std::pmr::vector<uint16_t>& addresses = columns.addresses;
+	const size_t offset = static_cast<uint16_t>(address - baseAddress);
+
+	if (offset >= bytes.size() || addresses.empty()) {
+		return columns.size();
+	}
+
+	// rows are in address order, the covering row is the last one starting at or before address
+	const size_t row = std::upper_bound(addresses.begin(), addresses.end(), address, [this](uint16_t value, uint16_t rowAddress) {
+		return static_cast<uint16_t>(value - baseAddress) < static_cast<uint16_t>(rowAddress - baseAddress);
+	}) - addresses.begin();
+
+	if (row == 0) {
+		return columns.size();
+	}
+
+	const size_t covering = row - 1;
+	const size_t rowOffset = static_cast<uint16_t>(addresses[covering] - baseAddress);
+
+	return offset <= rowOffset + columns.operandLengths[covering] ? covering : columns.size();
+}
+
+ImageCache6502::ImageCache6502(size_t memoryBudget) :
+	memoryBudget(memoryBudget),
+	memoryUsage(0)
+{
+}
+
+uint64_t ImageCache6502::imageId(const uint8_t* data, size_t length, uint16_t baseAddress)
+{
+	// FNV-1a over the base address and the bytes
+	uint64_t hash = 14695981039346656037ULL;
+	const uint8_t base[2] = { static_cast<uint8_t>(baseAddress), static_cast<uint8_t>(baseAddress >> 8) };
+
+	for (size_t i = 0; i < sizeof(base); i++) {
+		hash = (hash ^ base[i]) * 1099511628211ULL;
+	}
+
+	for (size_t i = 0; i < length; i++) {
+		hash = (hash ^ data[i]) * 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+std::shared_ptr<const ImageCache6502::Image> ImageCache6502::decode(const uint8_t* data, size_t length, uint16_t baseAddress)
+{
+	std::shared_ptr<Image> image = std::make_shared<Image>();
+
+	image->id = imageId(data, length, baseAddress);
+	image->baseAddress = baseAddress;
+	image->bytes.assign(data, data + length);
+	image->columns = InstructionColumns6502::decode(data, length, baseAddress);
+
+	const InstructionColumns6502::View view = image->columns.view();
+	std::vector<std::pair<uint16_t, uint32_t> > references;
+
+	for (size_t row = 0; row < view.count; row++) {
+		uint16_t target;
+
+		if (BankedDisassembly6502::branchTarget(view, row, target)) {
+			references.push_back(std::make_pair(target, static_cast<uint32_t>(row)));
+		}
+	}
+
+	std::sort(references.begin(), references.end());
+
+	image->referenceTargets.reserve(references.size());
+	image->referenceRows.reserve(references.size());
+
+	for (const std::pair<uint16_t, uint32_t>& reference : references) {
+		image->referenceTargets.push_back(reference.first);
+		image->referenceRows.push_back(reference.second);
+	}
+
+	return image;
+}
+
+void ImageCache6502::evict()
+{
+	while (memoryUsage > memoryBudget && images.size() > 1) {
+		const std::shared_ptr<const Image>& oldest = images.back();
+
+		memoryUsage -= oldest->memoryUsage();
+		index.erase(oldest->id);
+		images.pop_back();
+	}
+}
+
+std::shared_ptr<const ImageCache6502::Image> ImageCache6502::load(const uint8_t* data, size_t length, uint16_t baseAddress)
+{
+	const uint64_t id = imageId(data, length, baseAddress);
+
+	std::shared_ptr<const Image> image = find(id);
+	if (image) {
+		return image;
+	}
+
+	// decode outside the lock so queries on other images are not held up
+	image = decode(data, length, baseAddress);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (index.find(id) == index.end()) {
+		images.push_front(image);
+		index[id] = images.begin();
+		memoryUsage += image->memoryUsage();
+		evict();
+	}
+
+	return image;
+}
+
+std::shared_ptr<const ImageCache6502::Image> ImageCache6502::find(uint64_t id)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	const std::unordered_map<uint64_t, ImageList::iterator>::iterator entry = index.find(id);
+	if (entry == index.end()) {
+		return std::shared_ptr<const Image>();
+	}
+
+	images.splice(images.begin(), images, entry->second);
+
+	return *entry->second;
+}
+
+size_t ImageCache6502::getMemoryUsage() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return memoryUsage;
+}
+
+size_t ImageCache6502::getImageCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return images.size();
+}
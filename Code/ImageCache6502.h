@@ -0,0 +1,66 @@
+#ifndef IMAGE_CACHE_6502_H
+#define IMAGE_CACHE_6502_H
+
+#include "InstructionColumns6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Decoded images and their indexes, kept resident under a memory budget and evicted least recently used first.
+// Images are identified by a hash of their base address and bytes, so loading the same image twice decodes it once.
+class ImageCache6502
+{
+public:
+
+	struct Image {
+		uint64_t id;
+		uint16_t baseAddress;
+		std::vector<uint8_t> bytes;
+		InstructionColumns6502 columns;
+		// rows with a branch or absolute operand, sorted by target
+		std::vector<uint16_t> referenceTargets;
+		std::vector<uint32_t> referenceRows;
+
+		size_t memoryUsage() const;
+
+		// Row of the instruction covering address, or columns.size() when address is outside the image
+		size_t rowContaining(uint16_t address) const;
+	};
+
+private:
+
+	typedef std::list<std::shared_ptr<const Image> > ImageList;
+
+	mutable std::mutex mutex;
+	ImageList images;
+	std::unordered_map<uint64_t, ImageList::iterator> index;
+	size_t memoryBudget;
+	size_t memoryUsage;
+
+	void evict();
+
+public:
+
+	explicit ImageCache6502(size_t memoryBudget);
+
+	static uint64_t imageId(const uint8_t* data, size_t length, uint16_t baseAddress);
+
+	static std::shared_ptr<const Image> decode(const uint8_t* data, size_t length, uint16_t baseAddress);
+
+	// Returns the cached image or decodes and inserts it. The newest image is kept even when it alone exceeds the budget
+	std::shared_ptr<const Image> load(const uint8_t* data, size_t length, uint16_t baseAddress);
+
+	// Returns NULL when the image was never loaded or has been evicted
+	std::shared_ptr<const Image> find(uint64_t id);
+
+	size_t getMemoryUsage() const;
+
+	size_t getImageCount() const;
+};
+
+#endif
@@ -0,0 +1,353 @@
+#include "InstructionColumns6502.h"
+#include "DecodeCore6502.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	const char FILE_MAGIC[8] = { '6', '5', '0', '2', 'C', 'O', 'L', 0 };
+	const uint32_t FILE_VERSION = 1;
+	const size_t COLUMN_COUNT = 6;
+	const size_t COLUMN_ALIGNMENT = 64;
+
+	struct FileHeader {
+		char magic[8];
+		uint32_t version;
+		uint16_t baseAddress;
+		uint16_t reserved;
+		uint64_t count;
+		uint64_t columnOffsets[COLUMN_COUNT];
+	};
+
+	const size_t COLUMN_WIDTHS[COLUMN_COUNT] = { 2, 1, 1, 1, 1, 2 };
+
+	size_t alignColumn(size_t offset)
+	{
+		return (offset + COLUMN_ALIGNMENT - 1) & ~(COLUMN_ALIGNMENT - 1);
+	}
+
+}
+
+InstructionColumns6502::InstructionColumns6502() : baseAddress(0) {}
+
+InstructionColumns6502::InstructionColumns6502(std::pmr::memory_resource* resource) :
+	baseAddress(0),
+	addresses(resource),
+	opcodeData(resource),
+	opcodes(resource),
+	addressingModes(resource),
+	operandLengths(resource),
+	operands(resource)
+{
+}
+
+InstructionColumns6502 InstructionColumns6502::decode(const uint8_t* data, size_t length, uint16_t baseAddress)
+{
+	return decode(data, length, baseAddress, std::pmr::get_default_resource());
+}
+
+InstructionColumns6502 InstructionColumns6502::decode(const uint8_t* data, size_t length, uint16_t baseAddress, std::pmr::memory_resource* resource)
+{
+	InstructionColumns6502 columns(resource);
+	columns.baseAddress = baseAddress;
+	// a sweep never produces more rows than bytes; most code averages a little over two bytes per row
+	columns.reserve(length / 2 + 1);
+	columns.append(data, length, baseAddress);
+
+	return columns;
+}
+
+void InstructionColumns6502::append(const uint8_t* data, size_t length, uint16_t address)
+{
+	const DecodeCore6502::Descriptor* table = DecodeCore6502::TABLE.entries;
+
+	for (size_t i = 0; i < length;) {
+		const DecodeCore6502::Descriptor& descriptor = table[data[i]];
+
+		if (i + 1 + descriptor.operandLength > length) {
+			break;
+		}
+
+		uint16_t operand = 0;
+		if (descriptor.operandLength == 1) {
+			operand = data[i + 1];
+		}
+		else if (descriptor.operandLength == 2) {
+			operand = static_cast<uint16_t>(data[i + 1] | (data[i + 2] << 8));
+		}
+
+		addresses.push_back(static_cast<uint16_t>(address + i));
+		opcodeData.push_back(data[i]);
+		opcodes.push_back(descriptor.opcode);
+		addressingModes.push_back(descriptor.addressingMode);
+		operandLengths.push_back(descriptor.operandLength);
+		operands.push_back(operand);
+
+		i += 1 + descriptor.operandLength;
+	}
+}
+
+void InstructionColumns6502::reserve(size_t count)
+{
+	addresses.reserve(count);
+	opcodeData.reserve(count);
+	opcodes.reserve(count);
+	addressingModes.reserve(count);
+	operandLengths.reserve(count);
+	operands.reserve(count);
+}
+
+void InstructionColumns6502::clear()
+{
+	addresses.clear();
+	opcodeData.clear();
+	opcodes.clear();
+	addressingModes.clear();
+	operandLengths.clear();
+	operands.clear();
+}
+
+size_t InstructionColumns6502::size() const
+{
+	return addresses.size();
+}
+
+InstructionColumns6502::View InstructionColumns6502::view() const
+{
+	return {
+		size(),
+		baseAddress,
+		addresses.data(),
+		opcodeData.data(),
+		opcodes.data(),
+		addressingModes.data(),
+		operandLengths.data(),
+		operands.data()
+	};
+}
+
+bool InstructionColumns6502::save(const char* path) const
+{
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		return false;
+	}
+
+	FileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+	header.version = FILE_VERSION;
+	header.baseAddress = baseAddress;
+	header.count = size();
+
+	const void* columnData[COLUMN_COUNT] = {
+		addresses.data(),
+		opcodeData.data(),
+		opcodes.data(),
+		addressingModes.data(),
+		operandLengths.data(),
+		operands.data()
+	};
+
+	size_t offset = alignColumn(sizeof(FileHeader));
+	for (size_t i = 0; i < COLUMN_COUNT; i++) {
+		header.columnOffsets[i] = offset;
+		offset = alignColumn(offset + COLUMN_WIDTHS[i] * size());
+	}
+
+	static const char padding[COLUMN_ALIGNMENT] = { 0 };
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	size_t written = sizeof(header);
+
+	for (size_t i = 0; ok && i < COLUMN_COUNT; i++) {
+		ok = fwrite(padding, 1, header.columnOffsets[i] - written, file) == header.columnOffsets[i] - written;
+		written = header.columnOffsets[i];
+
+		if (ok && size() > 0) {
+			ok = fwrite(columnData[i], COLUMN_WIDTHS[i], size(), file) == size();
+		}
+		written += COLUMN_WIDTHS[i] * size();
+	}
+
+	return fclose(file) == 0 && ok;
+}
+
+size_t InstructionColumns6502::selectOperandRange(const View& view, Disassembler6502::Opcode opcode, uint16_t first, uint16_t last, std::vector<uint32_t>& indices,
+	uint32_t addressingModes)
+{
+	const size_t start = indices.size();
+	indices.resize(start + view.count);
+
+	uint32_t* out = indices.data() + start;
+	size_t found = 0;
+	const uint16_t span = static_cast<uint16_t>(last - first);
+
+	// branch free so the compare runs over whole columns; unmatched rows are overwritten by the next one
+	for (size_t i = 0; i < view.count; i++) {
+		const bool relative = view.addressingModes[i] == Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM;
+		const uint16_t target = static_cast<uint16_t>(view.addresses[i] + 1 + view.operandLengths[i] + static_cast<int8_t>(view.operands[i]));
+		const uint16_t value = relative ? target : view.operands[i];
+		const bool match =
+			(view.opcodes[i] == opcode) &
+			(view.operandLengths[i] != 0) &
+			(((addressingModes >> (view.addressingModes[i] & 31)) & 1) != 0) &
+			(static_cast<uint16_t>(value - first) <= span);
+
+		out[found] = static_cast<uint32_t>(i);
+		found += match;
+	}
+
+	indices.resize(start + found);
+	return found;
+}
+
+size_t InstructionColumns6502::countOpcode(const View& view, Disassembler6502::Opcode opcode)
+{
+	size_t found = 0;
+
+	for (size_t i = 0; i < view.count; i++) {
+		found += view.opcodes[i] == opcode;
+	}
+
+	return found;
+}
+
+MappedInstructionColumns6502::MappedInstructionColumns6502() :
+	mapping(NULL),
+	mappingLength(0),
+#ifdef _WIN32
+	fileHandle(NULL),
+	mappingHandle(NULL),
+#endif
+	columns()
+{
+}
+
+MappedInstructionColumns6502::~MappedInstructionColumns6502()
+{
+	close();
+}
+
+bool MappedInstructionColumns6502::open(const char* path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader))) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE fileMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (fileMapping == NULL) {
+		CloseHandle(file);
+		return false;
+	}
+
+	mapping = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+	if (mapping == NULL) {
+		CloseHandle(fileMapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = fileMapping;
+	mappingLength = static_cast<size_t>(fileSize.QuadPart);
+#else
+	const int file = ::open(path, O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < sizeof(FileHeader)) {
+		::close(file);
+		return false;
+	}
+
+	void* mapped = mmap(NULL, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_SHARED, file, 0);
+	::close(file);
+
+	if (mapped == MAP_FAILED) {
+		return false;
+	}
+
+	mapping = mapped;
+	mappingLength = static_cast<size_t>(fileStat.st_size);
+#endif
+
+	const uint8_t* base = static_cast<const uint8_t*>(mapping);
+	const FileHeader* header = reinterpret_cast<const FileHeader*>(base);
+
+	if (memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header->version != FILE_VERSION) {
+		close();
+		return false;
+	}
+
+	for (size_t i = 0; i < COLUMN_COUNT; i++) {
+		if (header->columnOffsets[i] % COLUMN_ALIGNMENT != 0 ||
+			header->columnOffsets[i] > mappingLength ||
+			header->count > (mappingLength - header->columnOffsets[i]) / COLUMN_WIDTHS[i]) {
+			close();
+			return false;
+		}
+	}
+
+	columns.count = static_cast<size_t>(header->count);
+	columns.baseAddress = header->baseAddress;
+	columns.addresses = reinterpret_cast<const uint16_t*>(base + header->columnOffsets[0]);
+	columns.opcodeData = base + header->columnOffsets[1];
+	columns.opcodes = base + header->columnOffsets[2];
+	columns.addressingModes = base + header->columnOffsets[3];
+	columns.operandLengths = base + header->columnOffsets[4];
+	columns.operands = reinterpret_cast<const uint16_t*>(base + header->columnOffsets[5]);
+
+	return true;
+}
+
+void MappedInstructionColumns6502::close()
+{
+	if (mapping != NULL) {
+#ifdef _WIN32
+		UnmapViewOfFile(mapping);
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		mappingHandle = NULL;
+		fileHandle = NULL;
+#else
+		munmap(mapping, mappingLength);
+#endif
+	}
+
+	mapping = NULL;
+	mappingLength = 0;
+	columns = InstructionColumns6502::View();
+}
+
+bool MappedInstructionColumns6502::isOpen() const
+{
+	return mapping != NULL;
+}
+
+InstructionColumns6502::View MappedInstructionColumns6502::view() const
+{
+	return columns;
+}
@@ -0,0 +1,116 @@
+#ifndef INSTRUCTION_COLUMNS_6502_H
+#define INSTRUCTION_COLUMNS_6502_H
+
+#include "Disassembler6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Struct-of-arrays form of a linear sweep: row i of every column describes the same instruction.
+// Bytes that do not decode are kept as one byte rows with INVALID_OPCODE, the same way analyze() prints "???".
+class InstructionColumns6502
+{
+public:
+
+	static const uint8_t INVALID_OPCODE = 0xFF;
+
+	// Masks of 1 << AddressingMode for selectOperandRange()
+	static const uint32_t DIRECT_ADDRESS_MODES =
+		(1u << Disassembler6502::ABSOLUTE_AM) |
+		(1u << Disassembler6502::ABSOLUTE_INDEXED_WITH_X_AM) |
+		(1u << Disassembler6502::ABSOLUTE_INDEXED_WITH_Y_AM) |
+		(1u << Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM) |
+		(1u << Disassembler6502::ZERO_PAGE_AM) |
+		(1u << Disassembler6502::ZERO_PAGE_INDEXED_WITH_X_AM) |
+		(1u << Disassembler6502::ZERO_PAGE_INDEXED_WITH_Y_AM);
+	// The operand is where the pointer is, not where the access goes
+	static const uint32_t INDIRECT_ADDRESS_MODES =
+		(1u << Disassembler6502::ABSOLUTE_INDEXED_INDIRECT_AM) |
+		(1u << Disassembler6502::ABSOLUTE_INDIRECT_AM) |
+		(1u << Disassembler6502::ZERO_PAGE_INDEXED_INDIRECT_AM) |
+		(1u << Disassembler6502::ZERO_PAGE_INDIRECT_AM) |
+		(1u << Disassembler6502::ZERO_PAGE_INDIRECT_INDEXED_WITH_Y_AM);
+
+	struct View {
+		size_t count;
+		uint16_t baseAddress;
+		const uint16_t* addresses;
+		const uint8_t* opcodeData;
+		const uint8_t* opcodes;
+		const uint8_t* addressingModes;
+		const uint8_t* operandLengths;
+		const uint16_t* operands;
+	};
+
+	uint16_t baseAddress;
+
+	std::pmr::vector<uint16_t> addresses;
+	std::pmr::vector<uint8_t> opcodeData;
+	std::pmr::vector<uint8_t> opcodes;
+	std::pmr::vector<uint8_t> addressingModes;
+	std::pmr::vector<uint8_t> operandLengths;
+	std::pmr::vector<uint16_t> operands;
+
+	InstructionColumns6502();
+
+	// Columns allocated from resource, e.g. the arena of an AnalysisSession6502
+	explicit InstructionColumns6502(std::pmr::memory_resource* resource);
+
+	// A trailing instruction whose operand runs past the end of data is not emitted
+	static InstructionColumns6502 decode(const uint8_t* data, size_t length, uint16_t baseAddress = 0);
+
+	static InstructionColumns6502 decode(const uint8_t* data, size_t length, uint16_t baseAddress, std::pmr::memory_resource* resource);
+
+	void append(const uint8_t* data, size_t length, uint16_t address);
+
+	void reserve(size_t count);
+
+	void clear();
+
+	size_t size() const;
+
+	View view() const;
+
+	bool save(const char* path) const;
+
+	// Appends the rows of opcode in one of addressingModes whose operand value is in [first, last]; for branches that
+	// is the branch target, like DecodeCore6502::operandValue()
+	static size_t selectOperandRange(const View& view, Disassembler6502::Opcode opcode, uint16_t first, uint16_t last, std::vector<uint32_t>& indices,
+		uint32_t addressingModes = DIRECT_ADDRESS_MODES);
+
+	static size_t countOpcode(const View& view, Disassembler6502::Opcode opcode);
+};
+
+// Read-only columns backed by a file written with InstructionColumns6502::save()
+class MappedInstructionColumns6502
+{
+private:
+
+	void* mapping;
+	size_t mappingLength;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+	InstructionColumns6502::View columns;
+
+public:
+
+	MappedInstructionColumns6502();
+	~MappedInstructionColumns6502();
+
+	MappedInstructionColumns6502(const MappedInstructionColumns6502&) = delete;
+	MappedInstructionColumns6502& operator=(const MappedInstructionColumns6502&) = delete;
+
+	bool open(const char* path);
+
+	void close();
+
+	bool isOpen() const;
+
+	InstructionColumns6502::View view() const;
+};
+
+#endif
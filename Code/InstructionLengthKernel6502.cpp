@@ -0,0 +1,231 @@
+#include "InstructionLengthKernel6502.h"
+#include "DecodeCore6502.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define INSTRUCTION_LENGTH_KERNEL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+	bool endsBlock(Disassembler6502::Opcode opcode)
+	{
+		switch (opcode)
+		{
+		case Disassembler6502::RTS_INSTR:
+		case Disassembler6502::RTI_INSTR:
+		case Disassembler6502::JMP_INSTR:
+		case Disassembler6502::BRA_INSTR:
+		case Disassembler6502::BRK_INSTR:
+		case Disassembler6502::STP_INSTR:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	struct ClassTable {
+		alignas(64) uint8_t classes[256];
+
+		ClassTable()
+		{
+			for (size_t i = 0; i < 256; i++) {
+				const DecodeCore6502::Descriptor& descriptor = DecodeCore6502::TABLE.entries[i];
+
+				if (descriptor.opcode == DecodeCore6502::INVALID_OPCODE) {
+					classes[i] = 0;
+					continue;
+				}
+
+				classes[i] = static_cast<uint8_t>(
+					descriptor.operandLength |
+					InstructionLengthKernel6502::VALID_FLAG |
+					(endsBlock(static_cast<Disassembler6502::Opcode>(descriptor.opcode)) ? InstructionLengthKernel6502::BLOCK_END_FLAG : 0));
+			}
+		}
+	};
+
+	const ClassTable& classTable()
+	{
+		static const ClassTable table;
+		return table;
+	}
+
+	typedef void (*ClassifyKernel)(const uint8_t* table, const uint8_t* data, size_t length, uint8_t* classes);
+
+	void classifyTable(const uint8_t* table, const uint8_t* data, size_t length, uint8_t* classes)
+	{
+		for (size_t i = 0; i < length; i++) {
+			classes[i] = table[data[i]];
+		}
+	}
+
+#ifdef INSTRUCTION_LENGTH_KERNEL_X86
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#define VBMI_TARGET __attribute__((target("avx512f,avx512bw,avx512vbmi")))
+#else
+#define AVX2_TARGET
+#define VBMI_TARGET
+#endif
+
+	// Classes fit in 4 Bits, so row h of the table (the classes of 0xh0 - 0xhF) shares a shuffle with row h + 8 in its
+	// high nibble and the top bit of the byte picks the nibble. Subtracting 16 per row leaves the bytes of the current row
+	// at 0 - 15, and the saturating add of 0x70 sets the top bit of every other byte, which pshufb turns into 0
+	AVX2_TARGET void classifyAvx2(const uint8_t* table, const uint8_t* data, size_t length, uint8_t* classes)
+	{
+		const __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+		const __m256i lowBitsMask = _mm256_set1_epi8(0x7F);
+		const __m256i rowStep = _mm256_set1_epi8(16);
+		const __m256i outsideRow = _mm256_set1_epi8(0x70);
+		__m256i rows[8];
+		size_t i = 0;
+
+		for (int h = 0; h < 8; h++) {
+			const __m128i low = _mm_load_si128(reinterpret_cast<const __m128i*>(table + h * 16));
+			const __m128i high = _mm_load_si128(reinterpret_cast<const __m128i*>(table + (h + 8) * 16));
+			rows[h] = _mm256_broadcastsi128_si256(_mm_or_si128(low, _mm_slli_epi16(high, 4)));
+		}
+
+		for (; i + 32 <= length; i += 32) {
+			const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+			__m256i rowOffset = _mm256_and_si256(bytes, lowBitsMask);
+			__m256i pair = _mm256_setzero_si256();
+
+			for (int h = 0; h < 8; h++) {
+				pair = _mm256_or_si256(pair, _mm256_shuffle_epi8(rows[h], _mm256_adds_epu8(rowOffset, outsideRow)));
+				rowOffset = _mm256_sub_epi8(rowOffset, rowStep);
+			}
+
+			const __m256i low = _mm256_and_si256(pair, nibbleMask);
+			const __m256i high = _mm256_and_si256(_mm256_srli_epi16(pair, 4), nibbleMask);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(classes + i), _mm256_blendv_epi8(low, high, bytes));
+		}
+
+		classifyTable(table, data + i, length - i, classes + i);
+	}
+
+	// Two vpermi2b cover the 128 classes each half of the table holds, and the top bit of the byte picks the half
+	VBMI_TARGET void classifyVbmi(const uint8_t* table, const uint8_t* data, size_t length, uint8_t* classes)
+	{
+		const __m512i lowHalf0 = _mm512_loadu_si512(table);
+		const __m512i lowHalf1 = _mm512_loadu_si512(table + 64);
+		const __m512i highHalf0 = _mm512_loadu_si512(table + 128);
+		const __m512i highHalf1 = _mm512_loadu_si512(table + 192);
+		size_t i = 0;
+
+		for (; i + 64 <= length; i += 64) {
+			const __m512i bytes = _mm512_loadu_si512(data + i);
+			const __m512i low = _mm512_permutex2var_epi8(lowHalf0, bytes, lowHalf1);
+			const __m512i high = _mm512_permutex2var_epi8(highHalf0, bytes, highHalf1);
+
+			_mm512_storeu_si512(classes + i, _mm512_mask_blend_epi8(_mm512_movepi8_mask(bytes), low, high));
+		}
+
+		classifyTable(table, data + i, length - i, classes + i);
+	}
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	// Register states the OS saves on a context switch, from XCR0
+	bool osSavesState(unsigned long long states)
+	{
+		int registers[4];
+		__cpuid(registers, 1);
+
+		return (registers[2] & (1 << 27)) != 0 && (_xgetbv(0) & states) == states;
+	}
+#endif
+
+	bool hasAvx2()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int registers[4];
+		__cpuid(registers, 0);
+		if (registers[0] < 7) {
+			return false;
+		}
+
+		__cpuidex(registers, 7, 0);
+		const bool avx2 = (registers[1] & (1 << 5)) != 0;
+
+		// SSE and AVX register states
+		return avx2 && osSavesState(0x06);
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	bool hasVbmi()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int registers[4];
+		__cpuid(registers, 0);
+		if (registers[0] < 7) {
+			return false;
+		}
+
+		__cpuidex(registers, 7, 0);
+		const bool avx512 = (registers[1] & (1 << 16)) != 0 && (registers[1] & (1 << 30)) != 0 && (registers[2] & (1 << 1)) != 0;
+
+		// SSE, AVX and the three AVX-512 register states
+		return avx512 && osSavesState(0xE6);
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi");
+#endif
+	}
+#endif
+
+	struct Kernel {
+		ClassifyKernel classify;
+		const char* name;
+	};
+
+	// Picked once from what the CPU running the program supports
+	const Kernel& kernel()
+	{
+		static const Kernel selected = []() {
+#ifdef INSTRUCTION_LENGTH_KERNEL_X86
+			if (hasVbmi()) {
+				return Kernel{ classifyVbmi, "avx512vbmi" };
+			}
+			if (hasAvx2()) {
+				return Kernel{ classifyAvx2, "avx2" };
+			}
+#endif
+			return Kernel{ classifyTable, "scalar" };
+		}();
+
+		return selected;
+	}
+
+}
+
+const uint8_t* InstructionLengthKernel6502::table()
+{
+	return classTable().classes;
+}
+
+uint8_t InstructionLengthKernel6502::classify(uint8_t data)
+{
+	return classTable().classes[data];
+}
+
+void InstructionLengthKernel6502::classifyScalar(const uint8_t* data, size_t length, uint8_t* classes)
+{
+	classifyTable(classTable().classes, data, length, classes);
+}
+
+void InstructionLengthKernel6502::classify(const uint8_t* data, size_t length, uint8_t* classes)
+{
+	kernel().classify(classTable().classes, data, length, classes);
+}
+
+const char* InstructionLengthKernel6502::kernelName()
+{
+	return kernel().name;
+}
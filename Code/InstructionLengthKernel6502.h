@@ -0,0 +1,56 @@
+#ifndef INSTRUCTION_LENGTH_KERNEL_6502_H
+#define INSTRUCTION_LENGTH_KERNEL_6502_H
+
+#include "Disassembler6502.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Maps every byte of a buffer to a packed class byte, as if each byte were an opcode:
+// bits 0-1 hold the operand length, VALID_FLAG marks decodable opcodes and
+// BLOCK_END_FLAG marks RTS, RTI, JMP, BRA, BRK and STP.
+// Invalid bytes have operand length 0, so the next instruction starts right after them like in analyze().
+class InstructionLengthKernel6502
+{
+public:
+
+	static const uint8_t OPERAND_LENGTH_MASK = 0x03;
+	static const uint8_t VALID_FLAG = 0x04;
+	static const uint8_t BLOCK_END_FLAG = 0x08;
+
+	// Bytes processed per step of the AVX-512 VBMI kernel. classify() picks it at run time when the CPU has it,
+	// then the AVX2 kernel (32 Bytes per step), then the scalar table lookup, which an SSSE3 lookup did not beat
+	static const size_t BLOCK_SIZE = 64;
+
+	static const uint8_t* table();
+
+	static uint8_t classify(uint8_t data);
+
+	static void classify(const uint8_t* data, size_t length, uint8_t* classes);
+
+	static void classifyScalar(const uint8_t* data, size_t length, uint8_t* classes);
+
+	static const char* kernelName();
+
+	static uint8_t operandLength(uint8_t classByte)
+	{
+		return classByte & OPERAND_LENGTH_MASK;
+	}
+
+	static uint8_t instructionLength(uint8_t classByte)
+	{
+		return 1 + (classByte & OPERAND_LENGTH_MASK);
+	}
+
+	static bool isValid(uint8_t classByte)
+	{
+		return (classByte & VALID_FLAG) != 0;
+	}
+
+	static bool endsBlock(uint8_t classByte)
+	{
+		return (classByte & BLOCK_END_FLAG) != 0;
+	}
+};
+
+#endif
@@ -0,0 +1,346 @@
+#ifndef INSTRUCTION_RANGE_6502_H
+#define INSTRUCTION_RANGE_6502_H
+
+#include "StreamingDisassembler6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#if defined(__cpp_lib_ranges)
+#include <ranges>
+#endif
+
+#if defined(__cpp_impl_coroutine) && defined(__cpp_lib_coroutine)
+#include <coroutine>
+#include <exception>
+#include <utility>
+#endif
+
+struct InstructionSentinel6502 {
+};
+
+// Lazy linear sweep over any byte source: a pointer pair, container iterators or istreambuf_iterator.
+// Each increment reads only the bytes of the next instruction, so stopping early (break, std::views::take)
+// leaves the rest of the source unread. Records are the StreamingDisassembler6502 ones with offset set to the
+// instruction address; a trailing instruction whose operand runs past the end of the source is not yielded.
+template <typename ByteIterator, typename ByteSentinel = ByteIterator>
+class InstructionRange6502
+#if defined(__cpp_lib_ranges)
+	: public std::ranges::view_base
+#endif
+{
+public:
+
+	class iterator
+	{
+	private:
+
+		ByteIterator position;
+		ByteSentinel end;
+		StreamingDisassembler6502 decoder;
+		StreamingDisassembler6502::Record record;
+		uint16_t baseAddress;
+		bool done;
+
+		void next()
+		{
+			while (!(position == end)) {
+				const uint8_t data = static_cast<uint8_t>(*position);
+				++position;
+
+				if (decoder.analyze(data, record)) {
+					record.offset = static_cast<uint16_t>(baseAddress + record.offset);
+					return;
+				}
+			}
+
+			done = true;
+		}
+
+	public:
+
+		typedef std::input_iterator_tag iterator_category;
+		typedef StreamingDisassembler6502::Record value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const StreamingDisassembler6502::Record* pointer;
+		typedef const StreamingDisassembler6502::Record& reference;
+
+		iterator() :
+			position(),
+			end(),
+			decoder(),
+			record(),
+			baseAddress(0),
+			done(true)
+		{
+		}
+
+		iterator(ByteIterator position, ByteSentinel end, uint16_t baseAddress) :
+			position(position),
+			end(end),
+			decoder(),
+			record(),
+			baseAddress(baseAddress),
+			done(false)
+		{
+			next();
+		}
+
+		reference operator*() const
+		{
+			return record;
+		}
+
+		pointer operator->() const
+		{
+			return &record;
+		}
+
+		iterator& operator++()
+		{
+			next();
+			return *this;
+		}
+
+		void operator++(int)
+		{
+			next();
+		}
+
+		// Iterator past the last byte of the current instruction in the byte source
+		ByteIterator base() const
+		{
+			return position;
+		}
+
+		friend bool operator==(const iterator& current, InstructionSentinel6502)
+		{
+			return current.done;
+		}
+
+		friend bool operator!=(const iterator& current, InstructionSentinel6502)
+		{
+			return !current.done;
+		}
+
+		friend bool operator==(InstructionSentinel6502, const iterator& current)
+		{
+			return current.done;
+		}
+
+		friend bool operator!=(InstructionSentinel6502, const iterator& current)
+		{
+			return !current.done;
+		}
+	};
+
+private:
+
+	ByteIterator first;
+	ByteSentinel last;
+	uint16_t baseAddress;
+
+public:
+
+	InstructionRange6502() :
+		first(),
+		last(),
+		baseAddress(0)
+	{
+	}
+
+	InstructionRange6502(ByteIterator first, ByteSentinel last, uint16_t baseAddress = 0) :
+		first(first),
+		last(last),
+		baseAddress(baseAddress)
+	{
+	}
+
+	// Decoding starts here; with a single pass source like istreambuf_iterator call it once
+	iterator begin() const
+	{
+		return iterator(first, last, baseAddress);
+	}
+
+	InstructionSentinel6502 end() const
+	{
+		return InstructionSentinel6502();
+	}
+};
+
+#if defined(__cpp_impl_coroutine) && defined(__cpp_lib_coroutine)
+
+// Coroutine form for byte sources that are pulled one call at a time, like a device or a socket.
+// ByteSource is called as int() and returns the next byte, or a negative value at the end of the data;
+// decoding runs only while the consumer asks for the next record.
+class InstructionGenerator6502
+{
+public:
+
+	struct promise_type {
+		const StreamingDisassembler6502::Record* current;
+		std::exception_ptr exception;
+
+		InstructionGenerator6502 get_return_object()
+		{
+			return InstructionGenerator6502(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+		std::suspend_always initial_suspend() noexcept
+		{
+			return std::suspend_always();
+		}
+
+		std::suspend_always final_suspend() noexcept
+		{
+			return std::suspend_always();
+		}
+
+		std::suspend_always yield_value(const StreamingDisassembler6502::Record& record) noexcept
+		{
+			current = &record;
+			return std::suspend_always();
+		}
+
+		void return_void()
+		{
+		}
+
+		void unhandled_exception()
+		{
+			exception = std::current_exception();
+		}
+	};
+
+	class iterator
+	{
+	private:
+
+		std::coroutine_handle<promise_type> coroutine;
+
+	public:
+
+		typedef std::input_iterator_tag iterator_category;
+		typedef StreamingDisassembler6502::Record value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const StreamingDisassembler6502::Record* pointer;
+		typedef const StreamingDisassembler6502::Record& reference;
+
+		iterator() :
+			coroutine()
+		{
+		}
+
+		explicit iterator(std::coroutine_handle<promise_type> coroutine) :
+			coroutine(coroutine)
+		{
+		}
+
+		reference operator*() const
+		{
+			return *coroutine.promise().current;
+		}
+
+		pointer operator->() const
+		{
+			return coroutine.promise().current;
+		}
+
+		iterator& operator++()
+		{
+			coroutine.resume();
+			if (coroutine.done() && coroutine.promise().exception) {
+				std::rethrow_exception(coroutine.promise().exception);
+			}
+			return *this;
+		}
+
+		void operator++(int)
+		{
+			++*this;
+		}
+
+		friend bool operator==(const iterator& current, InstructionSentinel6502)
+		{
+			return !current.coroutine || current.coroutine.done();
+		}
+
+		friend bool operator!=(const iterator& current, InstructionSentinel6502 sentinel)
+		{
+			return !(current == sentinel);
+		}
+	};
+
+private:
+
+	std::coroutine_handle<promise_type> coroutine;
+
+	explicit InstructionGenerator6502(std::coroutine_handle<promise_type> coroutine) :
+		coroutine(coroutine)
+	{
+	}
+
+public:
+
+	InstructionGenerator6502(InstructionGenerator6502&& other) noexcept :
+		coroutine(std::exchange(other.coroutine, nullptr))
+	{
+	}
+
+	InstructionGenerator6502& operator=(InstructionGenerator6502&& other) noexcept
+	{
+		if (this != &other) {
+			if (coroutine) {
+				coroutine.destroy();
+			}
+			coroutine = std::exchange(other.coroutine, nullptr);
+		}
+		return *this;
+	}
+
+	InstructionGenerator6502(const InstructionGenerator6502&) = delete;
+	InstructionGenerator6502& operator=(const InstructionGenerator6502&) = delete;
+
+	~InstructionGenerator6502()
+	{
+		if (coroutine) {
+			coroutine.destroy();
+		}
+	}
+
+	iterator begin()
+	{
+		iterator first(coroutine);
+		return ++first;
+	}
+
+	InstructionSentinel6502 end()
+	{
+		return InstructionSentinel6502();
+	}
+
+	template <typename ByteSource>
+	static InstructionGenerator6502 decode(ByteSource source, uint16_t baseAddress = 0)
+	{
+		StreamingDisassembler6502 decoder;
+		StreamingDisassembler6502::Record record;
+
+		for (int data = source(); data >= 0; data = source()) {
+			if (decoder.analyze(static_cast<uint8_t>(data), record)) {
+				record.offset = static_cast<uint16_t>(baseAddress + record.offset);
+				co_yield record;
+			}
+		}
+	}
+};
+
+#endif
+
+#endif
@@ -0,0 +1,300 @@
+#ifndef INSTRUCTION_SEMANTICS_6502_H
+#define INSTRUCTION_SEMANTICS_6502_H
+
+#include "DecodeCore6502.h"
+#include "Disassembler6502.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// What every opcode byte reads and writes: the registers, each flag of P on its own, and memory as one location.
+// Header-only and constexpr like DecodeCore6502, effects() is a single table load.
+// Memory covers operands, pointers and the stack page alike; JSR only lists its own return address push,
+// what the subroutine does is left to the caller. Bytes that do not decode use every location and define none.
+class InstructionSemantics6502
+{
+public:
+
+	static constexpr uint16_t A_LOCATION = 0x0001;
+	static constexpr uint16_t X_LOCATION = 0x0002;
+	static constexpr uint16_t Y_LOCATION = 0x0004;
+	static constexpr uint16_t S_LOCATION = 0x0008;
+	static constexpr uint16_t C_LOCATION = 0x0010;
+	static constexpr uint16_t Z_LOCATION = 0x0020;
+	static constexpr uint16_t I_LOCATION = 0x0040;
+	static constexpr uint16_t D_LOCATION = 0x0080;
+	static constexpr uint16_t V_LOCATION = 0x0100;
+	static constexpr uint16_t N_LOCATION = 0x0200;
+	static constexpr uint16_t MEMORY_LOCATION = 0x0400;
+
+	static constexpr size_t LOCATION_COUNT = 11;
+
+	static constexpr uint16_t REGISTER_LOCATIONS = A_LOCATION | X_LOCATION | Y_LOCATION | S_LOCATION;
+	static constexpr uint16_t FLAG_LOCATIONS = C_LOCATION | Z_LOCATION | I_LOCATION | D_LOCATION | V_LOCATION | N_LOCATION;
+	static constexpr uint16_t ALL_LOCATIONS = REGISTER_LOCATIONS | FLAG_LOCATIONS | MEMORY_LOCATION;
+
+	struct Effects {
+		uint16_t uses;
+		uint16_t defs;
+	};
+
+	struct EffectsTable {
+		Effects entries[256];
+
+		constexpr EffectsTable();
+	};
+
+	static const EffectsTable TABLE;
+
+	// Index registers and memory read to form the operand address; the operand itself is not included
+	static constexpr uint16_t addressUses(Disassembler6502::AddressingMode addressingMode)
+	{
+		switch (addressingMode)
+		{
+		case Disassembler6502::ABSOLUTE_INDEXED_WITH_X_AM:
+		case Disassembler6502::ZERO_PAGE_INDEXED_WITH_X_AM:
+			return X_LOCATION;
+		case Disassembler6502::ABSOLUTE_INDEXED_WITH_Y_AM:
+		case Disassembler6502::ZERO_PAGE_INDEXED_WITH_Y_AM:
+			return Y_LOCATION;
+		case Disassembler6502::ABSOLUTE_INDEXED_INDIRECT_AM:
+		case Disassembler6502::ZERO_PAGE_INDEXED_INDIRECT_AM:
+			return X_LOCATION | MEMORY_LOCATION;
+		case Disassembler6502::ZERO_PAGE_INDIRECT_INDEXED_WITH_Y_AM:
+			return Y_LOCATION | MEMORY_LOCATION;
+		case Disassembler6502::ABSOLUTE_INDIRECT_AM:
+		case Disassembler6502::ZERO_PAGE_INDIRECT_AM:
+			return MEMORY_LOCATION;
+		default:
+			return 0;
+		}
+	}
+
+	static constexpr Effects effects(Disassembler6502::Opcode opcode, Disassembler6502::AddressingMode addressingMode)
+	{
+		const uint16_t address = addressUses(addressingMode);
+		// the value operand of loads and arithmetic: memory unless immediate
+		const uint16_t source = addressingMode == Disassembler6502::IMMEDIATE_ADDRESSING_AM ? 0 : static_cast<uint16_t>(address | MEMORY_LOCATION);
+		// read-modify-write target: A in accumulator mode, memory otherwise
+		const uint16_t target = addressingMode == Disassembler6502::ACCUMULATOR_AM ? A_LOCATION : MEMORY_LOCATION;
+		const uint16_t targetUses = addressingMode == Disassembler6502::ACCUMULATOR_AM ? A_LOCATION : static_cast<uint16_t>(address | MEMORY_LOCATION);
+		const uint16_t nz = N_LOCATION | Z_LOCATION;
+
+		switch (opcode)
+		{
+		case Disassembler6502::ADC_INSTR:
+		case Disassembler6502::SBC_INSTR:
+			return { static_cast<uint16_t>(A_LOCATION | C_LOCATION | D_LOCATION | source), A_LOCATION | nz | V_LOCATION | C_LOCATION };
+		case Disassembler6502::AND_INSTR:
+		case Disassembler6502::EOR_INSTR:
+		case Disassembler6502::ORA_INSTR:
+			return { static_cast<uint16_t>(A_LOCATION | source), A_LOCATION | nz };
+		case Disassembler6502::ASL_INSTR:
+		case Disassembler6502::LSR_INSTR:
+			return { targetUses, static_cast<uint16_t>(target | nz | C_LOCATION) };
+		case Disassembler6502::ROL_INSTR:
+		case Disassembler6502::ROR_INSTR:
+			return { static_cast<uint16_t>(targetUses | C_LOCATION), static_cast<uint16_t>(target | nz | C_LOCATION) };
+		case Disassembler6502::DEC_INSTR:
+		case Disassembler6502::INC_INSTR:
+			return { targetUses, static_cast<uint16_t>(target | nz) };
+		case Disassembler6502::BBR0_INSTR:
+		case Disassembler6502::BBR1_INSTR:
+		case Disassembler6502::BBR2_INSTR:
+		case Disassembler6502::BBR3_INSTR:
+		case Disassembler6502::BBR4_INSTR:
+		case Disassembler6502::BBR5_INSTR:
+		case Disassembler6502::BBR6_INSTR:
+		case Disassembler6502::BBR7_INSTR:
+		case Disassembler6502::BBS0_INSTR:
+		case Disassembler6502::BBS1_INSTR:
+		case Disassembler6502::BBS2_INSTR:
+		case Disassembler6502::BBS3_INSTR:
+		case Disassembler6502::BBS4_INSTR:
+		case Disassembler6502::BBS5_INSTR:
+		case Disassembler6502::BBS6_INSTR:
+		case Disassembler6502::BBS7_INSTR:
+			return { MEMORY_LOCATION, 0 };
+		case Disassembler6502::BCC_INSTR:
+		case Disassembler6502::BCS_INSTR:
+			return { C_LOCATION, 0 };
+		case Disassembler6502::BEQ_INSTR:
+		case Disassembler6502::BNE_INSTR:
+			return { Z_LOCATION, 0 };
+		case Disassembler6502::BMI_INSTR:
+		case Disassembler6502::BPL_INSTR:
+			return { N_LOCATION, 0 };
+		case Disassembler6502::BVC_INSTR:
+		case Disassembler6502::BVS_INSTR:
+			return { V_LOCATION, 0 };
+		case Disassembler6502::BRA_INSTR:
+		case Disassembler6502::NOP_INSTR:
+		case Disassembler6502::STP_INSTR:
+		case Disassembler6502::WAI_INSTR:
+			return { 0, 0 };
+		case Disassembler6502::BIT_INSTR:
+			// BIT #imm only sets Z
+			return addressingMode == Disassembler6502::IMMEDIATE_ADDRESSING_AM ?
+				Effects{ A_LOCATION, Z_LOCATION } :
+				Effects{ static_cast<uint16_t>(A_LOCATION | source), nz | V_LOCATION };
+		case Disassembler6502::BRK_INSTR:
+			// pushes PC and P, then sets I and clears D on the 65C02
+			return { S_LOCATION | FLAG_LOCATIONS, S_LOCATION | I_LOCATION | D_LOCATION | MEMORY_LOCATION };
+		case Disassembler6502::CLC_INSTR:
+		case Disassembler6502::SEC_INSTR:
+			return { 0, C_LOCATION };
+		case Disassembler6502::CLD_INSTR:
+		case Disassembler6502::SED_INSTR:
+			return { 0, D_LOCATION };
+		case Disassembler6502::CLI_INSTR:
+		case Disassembler6502::SEI_INSTR:
+			return { 0, I_LOCATION };
+		case Disassembler6502::CLV_INSTR:
+			return { 0, V_LOCATION };
+		case Disassembler6502::CMP_INSTR:
+			return { static_cast<uint16_t>(A_LOCATION | source), nz | C_LOCATION };
+		case Disassembler6502::CPX_INSTR:
+			return { static_cast<uint16_t>(X_LOCATION | source), nz | C_LOCATION };
+		case Disassembler6502::CPY_INSTR:
+			return { static_cast<uint16_t>(Y_LOCATION | source), nz | C_LOCATION };
+		case Disassembler6502::DEX_INSTR:
+		case Disassembler6502::INX_INSTR:
+			return { X_LOCATION, X_LOCATION | nz };
+		case Disassembler6502::DEY_INSTR:
+		case Disassembler6502::INY_INSTR:
+			return { Y_LOCATION, Y_LOCATION | nz };
+		case Disassembler6502::JMP_INSTR:
+			return { address, 0 };
+		case Disassembler6502::JSR_INSTR:
+			return { S_LOCATION, S_LOCATION | MEMORY_LOCATION };
+		case Disassembler6502::LDA_INSTR:
+			return { source, A_LOCATION | nz };
+		case Disassembler6502::LDX_INSTR:
+			return { source, X_LOCATION | nz };
+		case Disassembler6502::LDY_INSTR:
+			return { source, Y_LOCATION | nz };
+		case Disassembler6502::PHA_INSTR:
+			return { A_LOCATION | S_LOCATION, S_LOCATION | MEMORY_LOCATION };
+		case Disassembler6502::PHP_INSTR:
+			return { FLAG_LOCATIONS | S_LOCATION, S_LOCATION | MEMORY_LOCATION };
+		case Disassembler6502::PHX_INSTR:
+			return { X_LOCATION | S_LOCATION, S_LOCATION | MEMORY_LOCATION };
+		case Disassembler6502::PHY_INSTR:
+			return { Y_LOCATION | S_LOCATION, S_LOCATION | MEMORY_LOCATION };
+		case Disassembler6502::PLA_INSTR:
+			return { S_LOCATION | MEMORY_LOCATION, A_LOCATION | S_LOCATION | nz };
+		case Disassembler6502::PLP_INSTR:
+			return { S_LOCATION | MEMORY_LOCATION, S_LOCATION | FLAG_LOCATIONS };
+		case Disassembler6502::PLX_INSTR:
+			return { S_LOCATION | MEMORY_LOCATION, X_LOCATION | S_LOCATION | nz };
+		case Disassembler6502::PLY_INSTR:
+			return { S_LOCATION | MEMORY_LOCATION, Y_LOCATION | S_LOCATION | nz };
+		case Disassembler6502::RMB0_INSTR:
+		case Disassembler6502::RMB1_INSTR:
+		case Disassembler6502::RMB2_INSTR:
+		case Disassembler6502::RMB3_INSTR:
+		case Disassembler6502::RMB4_INSTR:
+		case Disassembler6502::RMB5_INSTR:
+		case Disassembler6502::RMB6_INSTR:
+		case Disassembler6502::RMB7_INSTR:
+		case Disassembler6502::SMB0_INSTR:
+		case Disassembler6502::SMB1_INSTR:
+		case Disassembler6502::SMB2_INSTR:
+		case Disassembler6502::SMB3_INSTR:
+		case Disassembler6502::SMB4_INSTR:
+		case Disassembler6502::SMB5_INSTR:
+		case Disassembler6502::SMB6_INSTR:
+		case Disassembler6502::SMB7_INSTR:
+			return { MEMORY_LOCATION, MEMORY_LOCATION };
+		case Disassembler6502::RTI_INSTR:
+			return { S_LOCATION | MEMORY_LOCATION, S_LOCATION | FLAG_LOCATIONS };
+		case Disassembler6502::RTS_INSTR:
+			return { S_LOCATION | MEMORY_LOCATION, S_LOCATION };
+		case Disassembler6502::STA_INSTR:
+			return { static_cast<uint16_t>(A_LOCATION | address), MEMORY_LOCATION };
+		case Disassembler6502::STX_INSTR:
+			return { static_cast<uint16_t>(X_LOCATION | address), MEMORY_LOCATION };
+		case Disassembler6502::STY_INSTR:
+			return { static_cast<uint16_t>(Y_LOCATION | address), MEMORY_LOCATION };
+		case Disassembler6502::STZ_INSTR:
+			return { address, MEMORY_LOCATION };
+		case Disassembler6502::TAX_INSTR:
+			return { A_LOCATION, X_LOCATION | nz };
+		case Disassembler6502::TAY_INSTR:
+			return { A_LOCATION, Y_LOCATION | nz };
+		case Disassembler6502::TSX_INSTR:
+			return { S_LOCATION, X_LOCATION | nz };
+		case Disassembler6502::TXA_INSTR:
+			return { X_LOCATION, A_LOCATION | nz };
+		case Disassembler6502::TXS_INSTR:
+			return { X_LOCATION, S_LOCATION };
+		case Disassembler6502::TYA_INSTR:
+			return { Y_LOCATION, A_LOCATION | nz };
+		case Disassembler6502::TRB_INSTR:
+		case Disassembler6502::TSB_INSTR:
+			return { A_LOCATION | MEMORY_LOCATION, MEMORY_LOCATION | Z_LOCATION };
+		}
+
+		return { ALL_LOCATIONS, 0 };
+	}
+
+	static constexpr Effects effects(uint8_t data);
+
+	// Single letter name of one location bit: "A", "X", "Y", "S", "C", "Z", "I", "D", "V", "N" or "M"
+	static constexpr const char* locationName(uint16_t location)
+	{
+		switch (location)
+		{
+		case A_LOCATION:
+			return "A";
+		case X_LOCATION:
+			return "X";
+		case Y_LOCATION:
+			return "Y";
+		case S_LOCATION:
+			return "S";
+		case C_LOCATION:
+			return "C";
+		case Z_LOCATION:
+			return "Z";
+		case I_LOCATION:
+			return "I";
+		case D_LOCATION:
+			return "D";
+		case V_LOCATION:
+			return "V";
+		case N_LOCATION:
+			return "N";
+		case MEMORY_LOCATION:
+			return "M";
+		}
+
+		return NULL;
+	}
+};
+
+constexpr InstructionSemantics6502::EffectsTable::EffectsTable() :
+	entries()
+{
+	for (size_t i = 0; i < 256; i++) {
+		const DecodeCore6502::Descriptor descriptor = DecodeCore6502::TABLE.entries[i];
+
+		if (descriptor.opcode == DecodeCore6502::INVALID_OPCODE) {
+			entries[i] = { ALL_LOCATIONS, 0 };
+			continue;
+		}
+
+		entries[i] = InstructionSemantics6502::effects(
+			static_cast<Disassembler6502::Opcode>(descriptor.opcode),
+			static_cast<Disassembler6502::AddressingMode>(descriptor.addressingMode));
+	}
+}
+
+inline constexpr InstructionSemantics6502::EffectsTable InstructionSemantics6502::TABLE;
+
+constexpr InstructionSemantics6502::Effects InstructionSemantics6502::effects(uint8_t data)
+{
+	return TABLE.entries[data];
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef LISTING_LINE_6502_H
+#define LISTING_LINE_6502_H
+
+#include "DecodeCore6502.h"
+#include "InstructionColumns6502.h"
+#include "InstructionLengthKernel6502.h"
+#include "StreamingDisassembler6502.h"
+#include "SymbolTable6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// The "$XXXX\tTEXT\n" listing line shared by the listing writers, with "NAME:\n" before it when symbols name the address
+class ListingLine6502
+{
+public:
+
+	// "$XXXX\t" before the text and '\n' after it
+	static const size_t PREFIX_LEN = 6;
+	// Longest line without symbols
+	static const size_t MAX_LEN = PREFIX_LEN + StreamingDisassembler6502::MAX_TEXT_LEN + 1;
+
+	// Writes digits upper case hex digits of value and returns the end
+	static char* formatHex(uint32_t value, size_t digits, char* text)
+	{
+		for (size_t i = digits; i > 0; i--) {
+			*text++ = "0123456789ABCDEF"[(value >> (4 * (i - 1))) & 0xF];
+		}
+
+		return text;
+	}
+
+	static char* formatPrefix(uint16_t address, char* text)
+	{
+		*text++ = '$';
+		text = formatHex(address, 4, text);
+		*text++ = '\t';
+
+		return text;
+	}
+
+	static DecodeCore6502::Descriptor descriptorFromRow(const InstructionColumns6502::View& view, size_t row)
+	{
+		const DecodeCore6502::Descriptor descriptor = { view.opcodes[row], view.addressingModes[row], view.operandLengths[row] };
+		return descriptor;
+	}
+
+	static StreamingDisassembler6502::Record recordFromRow(const InstructionColumns6502::View& view, size_t row)
+	{
+		const StreamingDisassembler6502::Record record = {
+			view.addresses[row],
+			view.operands[row],
+			view.opcodeData[row],
+			InstructionLengthKernel6502::classify(view.opcodeData[row])
+		};
+		return record;
+	}
+
+	// Like format(): the full text length is returned even when capacity cuts the text
+	static size_t formatText(const InstructionColumns6502::View& view, size_t row, const SymbolTable6502* symbols, char* buffer, size_t capacity)
+	{
+		return symbols == NULL ?
+			DecodeCore6502::format(descriptorFromRow(view, row), view.operands[row], view.addresses[row], buffer, capacity) :
+			symbols->format(recordFromRow(view, row), buffer, capacity);
+	}
+
+	// Appends the label line and the listing line of row to text, which may be any string with resize()
+	template <typename String>
+	static void append(String& text, const InstructionColumns6502::View& view, size_t row, const SymbolTable6502* symbols)
+	{
+		if (symbols != NULL) {
+			const char* label = symbols->find(view.addresses[row]);
+			if (label != NULL) {
+				text.append(label, strlen(label));
+				text.append(":\n", 2);
+			}
+		}
+
+		// formatted in place, room for the NUL format() writes included; a longer symbol line is formatted again
+		const size_t start = text.size();
+		text.resize(start + MAX_LEN + 1);
+		formatPrefix(view.addresses[row], &text[start]);
+
+		const size_t length = formatText(view, row, symbols, &text[start + PREFIX_LEN], MAX_LEN + 1 - PREFIX_LEN);
+		if (PREFIX_LEN + length + 1 > MAX_LEN + 1) {
+			text.resize(start + PREFIX_LEN + length + 1);
+			formatText(view, row, symbols, &text[start + PREFIX_LEN], length + 1);
+		}
+
+		text.resize(start + PREFIX_LEN + length);
+		text.push_back('\n');
+	}
+};
+
+#endif
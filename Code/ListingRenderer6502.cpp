@@ -0,0 +1,216 @@
+#include "ListingRenderer6502.h"
+#include "DecodeCore6502.h"
+#include "ListingLine6502.h"
+#include "SymbolTable6502.h"
+
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	struct Chunk {
+		size_t begin;
+		size_t end;
+		size_t length;
+		size_t offset;
+	};
+
+	size_t rowLength(const InstructionColumns6502::View& view, size_t row, const SymbolTable6502* symbols)
+	{
+		if (symbols == NULL) {
+			return ListingLine6502::PREFIX_LEN + DecodeCore6502::formatLength(ListingLine6502::descriptorFromRow(view, row), view.operands[row], view.addresses[row]) + 1;
+		}
+
+		size_t length = ListingLine6502::PREFIX_LEN + symbols->format(ListingLine6502::recordFromRow(view, row), NULL, 0) + 1;
+
+		const char* label = symbols->find(view.addresses[row]);
+		if (label != NULL) {
+			length += strlen(label) + 2;
+		}
+
+		return length;
+	}
+
+	// end is where the chunk ends; the text always leaves room for the NUL format() writes, which the newline replaces
+	char* renderRow(const InstructionColumns6502::View& view, size_t row, const SymbolTable6502* symbols, char* text, char* end)
+	{
+		const uint16_t address = view.addresses[row];
+
+		if (symbols != NULL) {
+			const char* label = symbols->find(address);
+			if (label != NULL) {
+				const size_t labelLength = strlen(label);
+				memcpy(text, label, labelLength);
+				text += labelLength;
+				*text++ = ':';
+				*text++ = '\n';
+			}
+		}
+
+		text = ListingLine6502::formatPrefix(address, text);
+		text += ListingLine6502::formatText(view, row, symbols, text, end - text);
+		*text++ = '\n';
+
+		return text;
+	}
+
+	template <typename Function>
+	void forEachChunk(std::vector<Chunk>& chunks, Function function)
+	{
+		std::vector<std::thread> workers;
+		workers.reserve(chunks.size() - 1);
+
+		for (size_t i = 1; i < chunks.size(); i++) {
+			workers.emplace_back(function, std::ref(chunks[i]));
+		}
+
+		function(chunks[0]);
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	}
+
+	// Splits the rows into chunks and sets their exact lengths and output offsets
+	std::vector<Chunk> measure(const InstructionColumns6502::View& view, const SymbolTable6502* symbols, unsigned threadCount)
+	{
+		if (threadCount == 0) {
+			threadCount = std::thread::hardware_concurrency();
+		}
+
+		size_t chunkCount = view.count / ListingRenderer6502::MIN_CHUNK_ROWS;
+		chunkCount = chunkCount > threadCount ? threadCount : chunkCount;
+		chunkCount = chunkCount > 0 ? chunkCount : 1;
+
+		std::vector<Chunk> chunks(chunkCount);
+		for (size_t i = 0; i < chunkCount; i++) {
+			chunks[i].begin = view.count * i / chunkCount;
+			chunks[i].end = view.count * (i + 1) / chunkCount;
+		}
+
+		forEachChunk(chunks, [&view, symbols](Chunk& chunk) {
+			size_t length = 0;
+			for (size_t row = chunk.begin; row < chunk.end; row++) {
+				length += rowLength(view, row, symbols);
+			}
+			chunk.length = length;
+		});
+
+		size_t offset = 0;
+		for (Chunk& chunk : chunks) {
+			chunk.offset = offset;
+			offset += chunk.length;
+		}
+
+		return chunks;
+	}
+
+	void renderChunks(const InstructionColumns6502::View& view, const SymbolTable6502* symbols, std::vector<Chunk>& chunks, char* output)
+	{
+		forEachChunk(chunks, [&view, symbols, output](Chunk& chunk) {
+			char* text = output + chunk.offset;
+			char* const end = text + chunk.length;
+
+			for (size_t row = chunk.begin; row < chunk.end; row++) {
+				text = renderRow(view, row, symbols, text, end);
+			}
+		});
+	}
+
+	size_t totalLength(const std::vector<Chunk>& chunks)
+	{
+		return chunks.back().offset + chunks.back().length;
+	}
+
+}
+
+size_t ListingRenderer6502::length(const InstructionColumns6502::View& view, const SymbolTable6502* symbols, unsigned threadCount)
+{
+	return totalLength(measure(view, symbols, threadCount));
+}
+
+size_t ListingRenderer6502::render(const InstructionColumns6502::View& view, char* output, const SymbolTable6502* symbols, unsigned threadCount)
+{
+	std::vector<Chunk> chunks = measure(view, symbols, threadCount);
+	renderChunks(view, symbols, chunks, output);
+
+	return totalLength(chunks);
+}
+
+bool ListingRenderer6502::renderFile(const InstructionColumns6502::View& view, const char* path, const SymbolTable6502* symbols, unsigned threadCount)
+{
+	std::vector<Chunk> chunks = measure(view, symbols, threadCount);
+	const size_t length = totalLength(chunks);
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	if (length == 0) {
+		return CloseHandle(file) != 0;
+	}
+
+	const unsigned long long fileLength = length;
+	HANDLE fileMapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, static_cast<DWORD>(fileLength >> 32), static_cast<DWORD>(fileLength), NULL);
+	if (fileMapping == NULL) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void* mapped = MapViewOfFile(fileMapping, FILE_MAP_WRITE, 0, 0, length);
+	if (mapped == NULL) {
+		CloseHandle(fileMapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	renderChunks(view, symbols, chunks, static_cast<char*>(mapped));
+
+	bool ok = FlushViewOfFile(mapped, length) != 0;
+	ok = UnmapViewOfFile(mapped) != 0 && ok;
+	ok = CloseHandle(fileMapping) != 0 && ok;
+	ok = CloseHandle(file) != 0 && ok;
+
+	return ok;
+#else
+	const int file = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (file < 0) {
+		return false;
+	}
+
+	if (length == 0) {
+		return ::close(file) == 0;
+	}
+
+	if (ftruncate(file, static_cast<off_t>(length)) != 0) {
+		::close(file);
+		return false;
+	}
+
+	void* mapped = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	if (mapped == MAP_FAILED) {
+		::close(file);
+		return false;
+	}
+
+	renderChunks(view, symbols, chunks, static_cast<char*>(mapped));
+
+	bool ok = munmap(mapped, length) == 0;
+	ok = ::close(file) == 0 && ok;
+
+	return ok;
+#endif
+}
@@ -0,0 +1,32 @@
+#ifndef LISTING_RENDERER_6502_H
+#define LISTING_RENDERER_6502_H
+
+#include "InstructionColumns6502.h"
+
+#include <cstddef>
+#include <cstdint>
+
+class SymbolTable6502;
+
+// Renders decoded columns as the same "$XXXX\tTEXT\n" listing as TextSink6502, on every core.
+// Rows are split into one chunk per thread; the threads first add up the exact text length of their rows,
+// a prefix sum of the chunk lengths gives every chunk its output offset, and the threads then format their
+// rows straight into the one output buffer or file mapping, so the result is in order without any copying.
+class ListingRenderer6502
+{
+public:
+
+	// Fewer rows than this per thread are not worth starting the thread for
+	static const size_t MIN_CHUNK_ROWS = 16 * 1024;
+
+	// Exact listing length in Bytes. threadCount 0 uses std::thread::hardware_concurrency()
+	static size_t length(const InstructionColumns6502::View& view, const SymbolTable6502* symbols = NULL, unsigned threadCount = 0);
+
+	// Writes the listing to output, which must hold length() Bytes; returns the Bytes written, no NUL is added
+	static size_t render(const InstructionColumns6502::View& view, char* output, const SymbolTable6502* symbols = NULL, unsigned threadCount = 0);
+
+	// Sizes the file to the listing and renders into a writable mapping of it; returns false on any file error
+	static bool renderFile(const InstructionColumns6502::View& view, const char* path, const SymbolTable6502* symbols = NULL, unsigned threadCount = 0);
+};
+
+#endif
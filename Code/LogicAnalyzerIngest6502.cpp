@@ -0,0 +1,379 @@
+#include "LogicAnalyzerIngest6502.h"
+#include "InstructionLengthKernel6502.h"
+#include "StageProfiler6502.h"
+
+#include <cstring>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+	// Bits of the packed word gather() returns; SYNC and R/W line up with the BusTrace6502 flags
+	const unsigned PACKED_DATA_SHIFT = 16;
+	const unsigned PACKED_FLAGS_SHIFT = 24;
+	const unsigned PACKED_PHI2_SHIFT = 26;
+	const uint32_t PACKED_FLAGS_MASK = BusTrace6502::SYNC_FLAG | BusTrace6502::READ_FLAG;
+	const size_t PACKED_BITS = 27;
+
+	BusTrace6502::Sample sampleFromPacked(uint32_t packed)
+	{
+		const BusTrace6502::Sample sample = {
+			static_cast<uint16_t>(packed),
+			static_cast<uint8_t>(packed >> PACKED_DATA_SHIFT),
+			static_cast<uint8_t>((packed >> PACKED_FLAGS_SHIFT) & PACKED_FLAGS_MASK)
+		};
+		return sample;
+	}
+
+}
+
+LogicAnalyzerIngest6502::ChannelMap::ChannelMap() :
+	sync(24),
+	readWrite(25),
+	phi2(26)
+{
+	for (uint8_t i = 0; i < Disassembler6502::ADDR_LEN; i++) {
+		address[i] = i;
+	}
+
+	for (uint8_t i = 0; i < Disassembler6502::DATA_LEN; i++) {
+		data[i] = static_cast<uint8_t>(PACKED_DATA_SHIFT + i);
+	}
+}
+
+LogicAnalyzerIngest6502::LogicAnalyzerIngest6502(const ChannelMap& channels) :
+	pextMask(0),
+	constantBits(0),
+	usePext(false),
+	hasPhi2(channels.phi2 != NO_CHANNEL),
+	previousPacked(0),
+	cycleCount(0),
+	pending(),
+	operandsLeft(0),
+	operandIndex(0),
+	nextOperandAddress(0),
+	classTable(InstructionLengthKernel6502::table()),
+	holding(false),
+	dataHit(false)
+{
+	uint8_t positions[PACKED_BITS];
+	for (size_t i = 0; i < Disassembler6502::ADDR_LEN; i++) {
+		positions[i] = channels.address[i];
+	}
+	for (size_t i = 0; i < Disassembler6502::DATA_LEN; i++) {
+		positions[PACKED_DATA_SHIFT + i] = channels.data[i];
+	}
+	positions[PACKED_FLAGS_SHIFT] = channels.sync;
+	positions[PACKED_FLAGS_SHIFT + 1] = channels.readWrite;
+	positions[PACKED_PHI2_SHIFT] = channels.phi2;
+
+	for (size_t i = 0; i < 4; i++) {
+		for (size_t j = 0; j < 256; j++) {
+			gatherTables[i][j] = 0;
+		}
+	}
+
+	// pext keeps the order of the selected bits, so it only fits when the captured channels come in packed order
+	bool ordered = true;
+	bool missing = false;
+	int previousPosition = -1;
+
+	for (size_t bit = 0; bit < PACKED_BITS; bit++) {
+		const uint8_t position = positions[bit];
+
+		if (position == NO_CHANNEL || position >= 32) {
+			missing = true;
+			continue;
+		}
+
+		ordered = ordered && !missing && position > previousPosition;
+		previousPosition = position;
+		pextMask |= static_cast<uint32_t>(1) << position;
+
+		for (size_t j = 0; j < 256; j++) {
+			if ((j >> (position % 8)) & 1) {
+				gatherTables[position / 8][j] |= static_cast<uint32_t>(1) << bit;
+			}
+		}
+	}
+
+	// without R/W every cycle counts as a read
+	if (channels.readWrite == NO_CHANNEL) {
+		constantBits = static_cast<uint32_t>(BusTrace6502::READ_FLAG) << PACKED_FLAGS_SHIFT;
+	}
+
+#if defined(__BMI2__)
+	usePext = ordered;
+#else
+	(void)ordered;
+#endif
+}
+
+uint32_t LogicAnalyzerIngest6502::gather(uint32_t word) const
+{
+#if defined(__BMI2__)
+	if (usePext) {
+		return _pext_u32(word, pextMask) | constantBits;
+	}
+#endif
+
+	return
+		gatherTables[0][word & 0xFF] |
+		gatherTables[1][(word >> 8) & 0xFF] |
+		gatherTables[2][(word >> 16) & 0xFF] |
+		gatherTables[3][word >> 24] |
+		constantBits;
+}
+
+size_t LogicAnalyzerIngest6502::extract(const uint32_t* words, size_t count, BusTrace6502::Sample* cycles)
+{
+	PROFILE_STAGE_6502(INGEST_STAGE);
+
+	size_t found = 0;
+
+	if (!hasPhi2) {
+		for (size_t i = 0; i < count; i++) {
+			cycles[i] = sampleFromPacked(gather(words[i]));
+		}
+		found = count;
+	}
+	else {
+		uint32_t previous = previousPacked;
+
+		// branch free: every sample is written and only a falling edge keeps the one before it
+		for (size_t i = 0; i < count; i++) {
+			const uint32_t packed = gather(words[i]);
+
+			cycles[found] = sampleFromPacked(previous);
+			found += (previous >> PACKED_PHI2_SHIFT) & ~(packed >> PACKED_PHI2_SHIFT) & 1;
+			previous = packed;
+		}
+
+		previousPacked = previous;
+	}
+
+	cycleCount += found;
+	return found;
+}
+
+size_t LogicAnalyzerIngest6502::decode(const BusTrace6502::Sample* cycles, size_t count, StreamingDisassembler6502::Record* records)
+{
+	PROFILE_STAGE_6502(INGEST_STAGE);
+
+	size_t found = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		const BusTrace6502::Sample& cycle = cycles[i];
+
+		if ((cycle.flags & BusTrace6502::SYNC_FLAG) != 0) {
+			pending.offset = cycle.address;
+			pending.operand = 0;
+			pending.opcodeData = cycle.data;
+			pending.classByte = classTable[cycle.data];
+			operandsLeft = InstructionLengthKernel6502::operandLength(pending.classByte);
+			operandIndex = 0;
+			nextOperandAddress = static_cast<uint16_t>(cycle.address + 1);
+		}
+		else if (operandsLeft != 0 && (cycle.flags & BusTrace6502::READ_FLAG) != 0 && cycle.address == nextOperandAddress) {
+			pending.operand |= static_cast<uint16_t>(cycle.data << (Disassembler6502::DATA_LEN * operandIndex));
+			operandIndex++;
+			operandsLeft--;
+			nextOperandAddress++;
+		}
+		else {
+			continue;
+		}
+
+		if (operandsLeft == 0) {
+			records[found++] = pending;
+		}
+	}
+
+	return found;
+}
+
+size_t LogicAnalyzerIngest6502::decode(const BusTrace6502::Sample* cycles, size_t count, StreamingDisassembler6502::Record* records, const TraceFilter6502& filter)
+{
+	PROFILE_STAGE_6502(INGEST_STAGE);
+
+	size_t found = 0;
+
+	pcMatches.resize(BLOCK_SAMPLES);
+	dataMatches.resize(BLOCK_SAMPLES);
+
+	for (size_t start = 0; start < count; start += BLOCK_SAMPLES) {
+		const size_t length = count - start < BLOCK_SAMPLES ? count - start : BLOCK_SAMPLES;
+		found += decodeBlock(cycles + start, length, records + found, filter);
+	}
+
+	return found;
+}
+
+size_t LogicAnalyzerIngest6502::decodeBlock(const BusTrace6502::Sample* cycles, size_t count, StreamingDisassembler6502::Record* records, const TraceFilter6502& filter)
+{
+	const bool dataFilter = filter.hasDataRanges();
+	size_t found = 0;
+
+	uint8_t* wanted = pcMatches.data();
+	filter.matchPc(cycles, count, wanted);
+	for (size_t i = 0; i < count; i++) {
+		wanted[i] &= cycles[i].flags & BusTrace6502::SYNC_FLAG;
+	}
+
+	if (dataFilter) {
+		filter.matchData(cycles, count, dataMatches.data());
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		// between wanted instructions only the next fetch in a PC range matters, so jump straight to it
+		if (operandsLeft == 0 && !holding) {
+			const uint8_t* next = static_cast<const uint8_t*>(memchr(wanted + i, 1, count - i));
+			if (next == NULL) {
+				break;
+			}
+			i = next - wanted;
+		}
+
+		const BusTrace6502::Sample& cycle = cycles[i];
+
+		if ((cycle.flags & BusTrace6502::SYNC_FLAG) != 0) {
+			if (holding) {
+				if (dataHit) {
+					records[found++] = pending;
+				}
+				holding = false;
+			}
+
+			if (wanted[i] == 0 || !filter.acceptsOpcode(cycle.data)) {
+				// SYNC marks the next instruction, so a skipped one needs neither its length nor its operands
+				operandsLeft = 0;
+				continue;
+			}
+
+			pending.offset = cycle.address;
+			pending.operand = 0;
+			pending.opcodeData = cycle.data;
+			pending.classByte = classTable[cycle.data];
+			operandsLeft = InstructionLengthKernel6502::operandLength(pending.classByte);
+			operandIndex = 0;
+			nextOperandAddress = static_cast<uint16_t>(cycle.address + 1);
+			dataHit = false;
+		}
+		else if (operandsLeft != 0 && (cycle.flags & BusTrace6502::READ_FLAG) != 0 && cycle.address == nextOperandAddress) {
+			pending.operand |= static_cast<uint16_t>(cycle.data << (Disassembler6502::DATA_LEN * operandIndex));
+			operandIndex++;
+			operandsLeft--;
+			nextOperandAddress++;
+		}
+		else {
+			dataHit = dataHit || (holding && dataMatches[i] != 0);
+			continue;
+		}
+
+		if (operandsLeft == 0) {
+			if (dataFilter) {
+				holding = true;
+			}
+			else {
+				records[found++] = pending;
+			}
+		}
+	}
+
+	return found;
+}
+
+void LogicAnalyzerIngest6502::decode(const MappedBusTrace6502& trace, const TraceFilter6502& filter, std::vector<StreamingDisassembler6502::Record>& records)
+{
+	const BusTrace6502::Sample* samples = trace.getSamples();
+	const size_t sampleCount = trace.getSampleCount();
+
+	for (size_t block = 0; block * BusTrace6502::BLOCK_SAMPLES < sampleCount; block++) {
+		const size_t start = block * BusTrace6502::BLOCK_SAMPLES;
+		const size_t length = sampleCount - start < BusTrace6502::BLOCK_SAMPLES ? sampleCount - start : BusTrace6502::BLOCK_SAMPLES;
+		size_t decodeLength = length;
+
+		if (!filter.mayFetchIn(trace.getPcMask(block))) {
+			// only the instruction running in from the previous block is finished, up to and with the first SYNC
+			decodeLength = 0;
+			while (decodeLength < length && (samples[start + decodeLength].flags & BusTrace6502::SYNC_FLAG) == 0) {
+				decodeLength++;
+			}
+			decodeLength += decodeLength < length ? 1 : 0;
+		}
+
+		const size_t recordStart = records.size();
+		records.resize(recordStart + decodeLength);
+		records.resize(recordStart + decode(samples + start, decodeLength, records.data() + recordStart, filter));
+	}
+
+	StreamingDisassembler6502::Record last;
+	if (flush(&last) != 0) {
+		records.push_back(last);
+	}
+}
+
+void LogicAnalyzerIngest6502::ingest(const uint32_t* words, size_t count, std::vector<StreamingDisassembler6502::Record>& records, BusTraceWriter6502* trace, const TraceFilter6502* filter)
+{
+	PROFILE_STAGE_6502(INGEST_STAGE);
+
+	cycles.resize(BLOCK_SAMPLES);
+
+	for (size_t start = 0; start < count; start += BLOCK_SAMPLES) {
+		const size_t length = count - start < BLOCK_SAMPLES ? count - start : BLOCK_SAMPLES;
+		const uint64_t firstCycle = cycleCount;
+		const size_t found = extract(words + start, length, cycles.data());
+
+		if (trace != NULL) {
+			for (size_t i = 0; i < found; i++) {
+				trace->add(firstCycle + i, cycles[i].address, cycles[i].data, cycles[i].flags);
+			}
+		}
+
+		const size_t recordStart = records.size();
+		records.resize(recordStart + found);
+		const size_t decoded = filter != NULL ?
+			decode(cycles.data(), found, records.data() + recordStart, *filter) :
+			decode(cycles.data(), found, records.data() + recordStart);
+		records.resize(recordStart + decoded);
+	}
+}
+
+size_t LogicAnalyzerIngest6502::flush(StreamingDisassembler6502::Record* records)
+{
+	const bool write = holding && dataHit;
+
+	if (write) {
+		records[0] = pending;
+	}
+
+	holding = false;
+	dataHit = false;
+	operandsLeft = 0;
+
+	return write ? 1 : 0;
+}
+
+void LogicAnalyzerIngest6502::reset()
+{
+	previousPacked = 0;
+	cycleCount = 0;
+	pending = StreamingDisassembler6502::Record();
+	operandsLeft = 0;
+	operandIndex = 0;
+	nextOperandAddress = 0;
+	holding = false;
+	dataHit = false;
+}
+
+uint64_t LogicAnalyzerIngest6502::getCycleCount() const
+{
+	return cycleCount;
+}
+
+const char* LogicAnalyzerIngest6502::kernelName() const
+{
+	return usePext ? "pext" : "lookup";
+}
@@ -0,0 +1,102 @@
+#ifndef LOGIC_ANALYZER_INGEST_6502_H
+#define LOGIC_ANALYZER_INGEST_6502_H
+
+#include "BusTrace6502.h"
+#include "StreamingDisassembler6502.h"
+#include "TraceFilter6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Turns raw logic analyzer words (one 32 bit word of channels per sample) into bus cycles and instructions.
+// Channels are gathered into a packed address/data/control word with one pext when the mapping keeps the
+// channels in bus order and BMI2 is compiled in, otherwise with four byte lookups that handle any mapping.
+// A bus cycle is the last sample before a PHI2 falling edge, so oversampled and idle samples are dropped;
+// without a PHI2 channel every sample is a cycle. Instructions start on SYNC and take their operands from
+// the reads that follow the opcode fetch, so dummy reads and data accesses never reach the decoder.
+class LogicAnalyzerIngest6502
+{
+public:
+
+	static const uint8_t NO_CHANNEL = 0xFF;
+
+	// Bit position of every signal in the sample word, NO_CHANNEL when not captured
+	struct ChannelMap {
+		uint8_t address[Disassembler6502::ADDR_LEN];
+		uint8_t data[Disassembler6502::DATA_LEN];
+		uint8_t sync;
+		// High for reads
+		uint8_t readWrite;
+		uint8_t phi2;
+
+		// A0-A15 on bits 0-15, D0-D7 on 16-23, SYNC on 24, R/W on 25 and PHI2 on 26
+		ChannelMap();
+	};
+
+	// Samples converted per ingest() step
+	static const size_t BLOCK_SAMPLES = 4096;
+
+private:
+
+	uint32_t gatherTables[4][256];
+	uint32_t pextMask;
+	uint32_t constantBits;
+	bool usePext;
+	bool hasPhi2;
+	uint32_t previousPacked;
+
+	uint64_t cycleCount;
+	StreamingDisassembler6502::Record pending;
+	uint8_t operandsLeft;
+	uint8_t operandIndex;
+	uint16_t nextOperandAddress;
+	const uint8_t* classTable;
+	// A filtered instruction that waits for its data cycles to show whether it touches a data range
+	bool holding;
+	bool dataHit;
+
+	std::vector<BusTrace6502::Sample> cycles;
+	std::vector<uint8_t> pcMatches;
+	std::vector<uint8_t> dataMatches;
+
+	uint32_t gather(uint32_t word) const;
+
+	size_t decodeBlock(const BusTrace6502::Sample* cycles, size_t count, StreamingDisassembler6502::Record* records, const TraceFilter6502& filter);
+
+public:
+
+	explicit LogicAnalyzerIngest6502(const ChannelMap& channels = ChannelMap());
+
+	// Writes the bus cycles found in words to cycles, which must hold count entries; returns how many were written.
+	// PHI2 state carries over from call to call
+	size_t extract(const uint32_t* words, size_t count, BusTrace6502::Sample* cycles);
+
+	// Decodes bus cycles into records whose offset is the address of the opcode; records must hold count entries.
+	// An instruction interrupted before its operands were read is dropped
+	size_t decode(const BusTrace6502::Sample* cycles, size_t count, StreamingDisassembler6502::Record* records);
+
+	// decode() keeping only the instructions filter accepts. Fetches outside the PC ranges or the opcode set
+	// end the current instruction without starting one. With data ranges an instruction is written at the
+	// next SYNC, once its data cycles are known; flush() writes the last one of a capture
+	size_t decode(const BusTrace6502::Sample* cycles, size_t count, StreamingDisassembler6502::Record* records, const TraceFilter6502& filter);
+
+	// Filtered decode of a whole trace, flushed at the end; blocks whose PC index shows no fetch in the PC ranges are skipped
+	void decode(const MappedBusTrace6502& trace, const TraceFilter6502& filter, std::vector<StreamingDisassembler6502::Record>& records);
+
+	// extract() and decode() in blocks, appending the records and writing the cycles to trace when given.
+	// A filter only limits the records, the trace still gets every cycle
+	void ingest(const uint32_t* words, size_t count, std::vector<StreamingDisassembler6502::Record>& records, BusTraceWriter6502* trace = NULL, const TraceFilter6502* filter = NULL);
+
+	// Ends the capture for a filter with data ranges: writes the instruction still waiting for a SYNC to records,
+	// which must hold one entry, when its data cycles so far touched a range. Returns how many records were written
+	size_t flush(StreamingDisassembler6502::Record* records);
+
+	void reset();
+
+	uint64_t getCycleCount() const;
+
+	const char* kernelName() const;
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "MemoryMap6502.h"
+
+#include <algorithm>
+
+namespace {
+
+	const uint32_t NO_SLOT = 0xFFFFFFFF;
+
+}
+
+// std::fill takes the value by reference, so the constant needs storage
+const uint32_t MemoryMap6502::UNMAPPED;
+
+MemoryMap6502::MemoryMap6502()
+{
+	std::fill(fixedPages.pageOffsets, fixedPages.pageOffsets + PAGE_COUNT, UNMAPPED);
+}
+
+const MemoryMap6502::PageTable* MemoryMap6502::pageTable(uint16_t bank) const
+{
+	if (bank == FIXED_BANK) {
+		return &fixedPages;
+	}
+
+	if (bank >= bankSlots.size() || bankSlots[bank] == NO_SLOT) {
+		return NULL;
+	}
+
+	return &pageTables[bankSlots[bank]];
+}
+
+bool MemoryMap6502::addWindow(const Window& window)
+{
+	if (window.bank == NO_BANK ||
+		window.length == 0 ||
+		window.cpuAddress % PAGE_SIZE != 0 ||
+		window.length % PAGE_SIZE != 0 ||
+		window.cpuAddress + window.length > 0x10000) {
+		return false;
+	}
+
+	PageTable* pages = &fixedPages;
+
+	if (window.bank != FIXED_BANK) {
+		if (window.bank >= bankSlots.size()) {
+			bankSlots.resize(window.bank + 1, NO_SLOT);
+		}
+
+		if (bankSlots[window.bank] == NO_SLOT) {
+			bankSlots[window.bank] = static_cast<uint32_t>(pageTables.size());
+			pageTables.emplace_back();
+			std::fill(pageTables.back().pageOffsets, pageTables.back().pageOffsets + PAGE_COUNT, UNMAPPED);
+		}
+
+		pages = &pageTables[bankSlots[window.bank]];
+	}
+
+	const size_t firstPage = window.cpuAddress / PAGE_SIZE;
+
+	for (size_t page = 0; page < window.length / PAGE_SIZE; page++) {
+		pages->pageOffsets[firstPage + page] = window.fileOffset + static_cast<uint32_t>(page * PAGE_SIZE);
+	}
+
+	windowList.push_back(window);
+	return true;
+}
+
+MemoryMap6502 MemoryMap6502::switchableWindows(size_t imageLength, uint16_t windowAddress, uint32_t windowLength)
+{
+	MemoryMap6502 map;
+
+	for (size_t offset = 0, bank = 0; windowLength > 0 && offset + windowLength <= imageLength && bank < NO_BANK; offset += windowLength, bank++) {
+		map.addWindow({ static_cast<uint16_t>(bank), windowAddress, windowLength, static_cast<uint32_t>(offset) });
+	}
+
+	return map;
+}
+
+uint32_t MemoryMap6502::fileOffset(uint16_t bank, uint16_t cpuAddress) const
+{
+	const PageTable* pages = pageTable(bank);
+
+	if (pages == NULL) {
+		return UNMAPPED;
+	}
+
+	const uint32_t pageOffset = pages->pageOffsets[cpuAddress / PAGE_SIZE];
+
+	return pageOffset == UNMAPPED ? UNMAPPED : pageOffset + cpuAddress % PAGE_SIZE;
+}
+
+bool MemoryMap6502::resolve(uint16_t bank, uint16_t cpuAddress, Location& location) const
+{
+	uint32_t offset = fileOffset(bank, cpuAddress);
+
+	if (offset != UNMAPPED) {
+		location = { bank, offset };
+		return true;
+	}
+
+	offset = fileOffset(FIXED_BANK, cpuAddress);
+
+	if (offset != UNMAPPED) {
+		location = { FIXED_BANK, offset };
+		return true;
+	}
+
+	return false;
+}
+
+const std::vector<MemoryMap6502::Window>& MemoryMap6502::windows() const
+{
+	return windowList;
+}
+
+std::vector<uint16_t> MemoryMap6502::banks() const
+{
+	std::vector<uint16_t> result;
+
+	for (size_t bank = 0; bank < bankSlots.size(); bank++) {
+		if (bankSlots[bank] != NO_SLOT) {
+			result.push_back(static_cast<uint16_t>(bank));
+		}
+	}
+
+	return result;
+}
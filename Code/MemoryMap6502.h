@@ -0,0 +1,67 @@
+#ifndef MEMORY_MAP_6502_H
+#define MEMORY_MAP_6502_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Maps (bank, CPU address) pairs of a banked image to file offsets.
+// Windows are page aligned so every bank keeps a 256 entry page table and lookups are a single index.
+// Windows added to FIXED_BANK are visible from every bank, like the fixed upper bank of most NES mappers.
+class MemoryMap6502
+{
+public:
+
+	static const uint16_t FIXED_BANK = 0xFFFF;
+	static const uint16_t NO_BANK = 0xFFFE;
+	static const uint32_t UNMAPPED = 0xFFFFFFFF;
+
+	static const size_t PAGE_SIZE = 0x100;
+	static const size_t PAGE_COUNT = 0x10000 / PAGE_SIZE;
+
+	struct Window {
+		uint16_t bank;
+		uint16_t cpuAddress;
+		uint32_t length;
+		uint32_t fileOffset;
+	};
+
+	struct Location {
+		uint16_t bank;
+		uint32_t fileOffset;
+	};
+
+private:
+
+	struct PageTable {
+		uint32_t pageOffsets[PAGE_COUNT];
+	};
+
+	std::vector<Window> windowList;
+	std::vector<PageTable> pageTables;
+	std::vector<uint32_t> bankSlots;
+	PageTable fixedPages;
+
+	const PageTable* pageTable(uint16_t bank) const;
+
+public:
+
+	MemoryMap6502();
+
+	// Returns false when the window is not page aligned, wraps the address space or bank is NO_BANK
+	bool addWindow(const Window& window);
+
+	// Every bank sees its own window of windowLength bytes at windowAddress, bank n at file offset n * windowLength
+	static MemoryMap6502 switchableWindows(size_t imageLength, uint16_t windowAddress, uint32_t windowLength);
+
+	uint32_t fileOffset(uint16_t bank, uint16_t cpuAddress) const;
+
+	// Looks in bank first and in the fixed windows second
+	bool resolve(uint16_t bank, uint16_t cpuAddress, Location& location) const;
+
+	const std::vector<Window>& windows() const;
+
+	std::vector<uint16_t> banks() const;
+};
+
+#endif
@@ -0,0 +1,310 @@
+#include "OutputFanout6502.h"
+#include "DecodeCore6502.h"
+#include "InstructionLengthKernel6502.h"
+#include "ListingLine6502.h"
+#include "StageProfiler6502.h"
+#include "SymbolTable6502.h"
+
+#include <cstring>
+
+namespace {
+
+	const char RECORD_FILE_MAGIC[8] = { '6', '5', '0', '2', 'R', 'E', 'C', 0 };
+
+	// Fills text from the end and returns the start of the digits
+	char* formatDecimal(uint32_t value, char* end)
+	{
+		do {
+			*--end = static_cast<char>('0' + value % 10);
+			value /= 10;
+		} while (value != 0);
+
+		return end;
+	}
+
+}
+
+OutputSink6502::~OutputSink6502()
+{
+}
+
+BufferedFileSink6502::BufferedFileSink6502(FILE* file, size_t bufferLength) :
+	file(file),
+	buffer(bufferLength > 0 ? bufferLength : 1),
+	used(0),
+	failed(false)
+{
+}
+
+void BufferedFileSink6502::append(const char* text, size_t length)
+{
+	while (length > 0) {
+		if (used == buffer.size()) {
+			flush();
+		}
+
+		const size_t chunk = length < buffer.size() - used ? length : buffer.size() - used;
+		memcpy(buffer.data() + used, text, chunk);
+		used += chunk;
+		text += chunk;
+		length -= chunk;
+	}
+}
+
+void BufferedFileSink6502::flush()
+{
+	if (used > 0 && fwrite(buffer.data(), 1, used, file) != used) {
+		failed = true;
+	}
+
+	used = 0;
+}
+
+bool BufferedFileSink6502::finish()
+{
+	flush();
+	return fflush(file) == 0 && !failed;
+}
+
+TextSink6502::TextSink6502(FILE* file, const SymbolTable6502* symbols, size_t bufferLength) :
+	BufferedFileSink6502(file, bufferLength),
+	symbols(symbols),
+	operandText(StreamingDisassembler6502::MAX_TEXT_LEN + 1)
+{
+}
+
+void TextSink6502::write(const StreamingDisassembler6502::Record* records, size_t count)
+{
+	char line[ListingLine6502::MAX_LEN + 1];
+
+	for (size_t i = 0; i < count; i++) {
+		char* text = ListingLine6502::formatPrefix(records[i].offset & 0xFFFF, line);
+
+		if (symbols == NULL) {
+			text += StreamingDisassembler6502::format(records[i], text, sizeof(line) - (text - line));
+			*text++ = '\n';
+			append(line, text - line);
+			continue;
+		}
+
+		const char* label = symbols->find(records[i].offset & 0xFFFF);
+		if (label != NULL) {
+			append(label, strlen(label));
+			append(":\n", 2);
+		}
+
+		// symbols can be longer than the line buffer, so the text goes out separately
+		append(line, text - line);
+		size_t length = symbols->format(records[i], operandText.data(), operandText.size());
+		if (length >= operandText.size()) {
+			operandText.resize(length + 1);
+			length = symbols->format(records[i], operandText.data(), operandText.size());
+		}
+		append(operandText.data(), length);
+		append('\n');
+	}
+}
+
+NdjsonSink6502::NdjsonSink6502(FILE* file, size_t bufferLength) :
+	BufferedFileSink6502(file, bufferLength)
+{
+}
+
+void NdjsonSink6502::write(const StreamingDisassembler6502::Record* records, size_t count)
+{
+	static const char ADDRESS_KEY[] = "{\"address\":";
+	static const char BYTES_KEY[] = ",\"bytes\":\"";
+	static const char VALID_KEY[] = "\",\"valid\":";
+	static const char MNEMONIC_KEY[] = ",\"mnemonic\":\"";
+	static const char OPERAND_KEY[] = ",\"operand\":";
+	static const char TEXT_KEY[] = ",\"text\":\"";
+
+	char number[16];
+	char text[StreamingDisassembler6502::MAX_TEXT_LEN + 1];
+
+	for (size_t i = 0; i < count; i++) {
+		const StreamingDisassembler6502::Record& record = records[i];
+		const bool valid = StreamingDisassembler6502::isValid(record);
+		const uint8_t operandLength = InstructionLengthKernel6502::operandLength(record.classByte);
+
+		append(ADDRESS_KEY, sizeof(ADDRESS_KEY) - 1);
+		const char* digits = formatDecimal(record.offset & 0xFFFF, number + sizeof(number));
+		append(digits, number + sizeof(number) - digits);
+
+		append(BYTES_KEY, sizeof(BYTES_KEY) - 1);
+		char* bytes = ListingLine6502::formatHex(record.opcodeData, 2, number);
+		for (uint8_t j = 0; j < operandLength; j++) {
+			bytes = ListingLine6502::formatHex(record.operand >> (8 * j), 2, bytes);
+		}
+		append(number, bytes - number);
+
+		append(VALID_KEY, sizeof(VALID_KEY) - 1);
+		if (valid) {
+			append("true", 4);
+
+			const char* mnemonic = DecodeCore6502::mnemonic(static_cast<Disassembler6502::Opcode>(DecodeCore6502::descriptor(record.opcodeData).opcode));
+			append(MNEMONIC_KEY, sizeof(MNEMONIC_KEY) - 1);
+			append(mnemonic, strlen(mnemonic));
+			append('"');
+
+			if (operandLength > 0) {
+				append(OPERAND_KEY, sizeof(OPERAND_KEY) - 1);
+				digits = formatDecimal(record.operand, number + sizeof(number));
+				append(digits, number + sizeof(number) - digits);
+			}
+		}
+		else {
+			append("false", 5);
+		}
+
+		// the listing text never holds quotes or backslashes, so it needs no escaping
+		append(TEXT_KEY, sizeof(TEXT_KEY) - 1);
+		append(text, StreamingDisassembler6502::format(record, text, sizeof(text)));
+		append("\"}\n", 3);
+	}
+}
+
+BinarySink6502::BinarySink6502(FILE* file, size_t bufferLength) :
+	BufferedFileSink6502(file, bufferLength),
+	headerWritten(false)
+{
+}
+
+void BinarySink6502::write(const StreamingDisassembler6502::Record* records, size_t count)
+{
+	if (!headerWritten) {
+		append(RECORD_FILE_MAGIC, sizeof(RECORD_FILE_MAGIC));
+		headerWritten = true;
+	}
+
+	append(reinterpret_cast<const char*>(records), count * sizeof(StreamingDisassembler6502::Record));
+}
+
+bool BinarySink6502::finish()
+{
+	if (!headerWritten) {
+		append(RECORD_FILE_MAGIC, sizeof(RECORD_FILE_MAGIC));
+		headerWritten = true;
+	}
+
+	return BufferedFileSink6502::finish();
+}
+
+OutputFanout6502::OutputFanout6502()
+{
+	batch.reserve(BATCH_RECORDS);
+}
+
+OutputFanout6502::~OutputFanout6502()
+{
+	finish();
+}
+
+void OutputFanout6502::addSink(OutputSink6502* sink, bool ownThread)
+{
+	if (!ownThread) {
+		inlineSinks.push_back(sink);
+		return;
+	}
+
+	workers.emplace_back(new SinkWorker());
+	SinkWorker* worker = workers.back().get();
+	worker->sink = sink;
+	worker->done = false;
+	worker->thread = std::thread(runWorker, worker);
+}
+
+void OutputFanout6502::runWorker(SinkWorker* worker)
+{
+	std::unique_lock<std::mutex> lock(worker->mutex);
+
+	for (;;) {
+		worker->changed.wait(lock, [worker] { return !worker->queue.empty() || worker->done; });
+
+		if (worker->queue.empty()) {
+			return;
+		}
+
+		const Batch next = worker->queue.front();
+		lock.unlock();
+		{
+			PROFILE_STAGE_6502(OUTPUT_STAGE);
+			worker->sink->write(next->data(), next->size());
+		}
+		lock.lock();
+
+		worker->queue.pop_front();
+		worker->changed.notify_all();
+	}
+}
+
+void OutputFanout6502::dispatch()
+{
+	PROFILE_STAGE_6502(OUTPUT_STAGE);
+
+	if (batch.empty()) {
+		return;
+	}
+
+	for (size_t i = 0; i < inlineSinks.size(); i++) {
+		inlineSinks[i]->write(batch.data(), batch.size());
+	}
+
+	if (!workers.empty()) {
+		const Batch shared(new std::vector<StreamingDisassembler6502::Record>(batch));
+
+		for (size_t i = 0; i < workers.size(); i++) {
+			SinkWorker& worker = *workers[i];
+			std::unique_lock<std::mutex> lock(worker.mutex);
+
+			worker.changed.wait(lock, [&worker] { return worker.queue.size() < MAX_QUEUED_BATCHES; });
+			worker.queue.push_back(shared);
+			worker.changed.notify_all();
+		}
+	}
+
+	batch.clear();
+}
+
+void OutputFanout6502::decode(const uint8_t* data, size_t length, uint16_t baseAddress)
+{
+	StreamingDisassembler6502 decoder;
+	StreamingDisassembler6502::Record record;
+
+	for (size_t i = 0; i < length; i++) {
+		if (decoder.analyze(data[i], record)) {
+			record.offset = static_cast<uint16_t>(baseAddress + record.offset);
+			write(record);
+		}
+	}
+}
+
+bool OutputFanout6502::finish()
+{
+	dispatch();
+
+	for (size_t i = 0; i < workers.size(); i++) {
+		SinkWorker& worker = *workers[i];
+		{
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			worker.done = true;
+		}
+		worker.changed.notify_all();
+		worker.thread.join();
+	}
+
+	bool ok = true;
+
+	for (size_t i = 0; i < inlineSinks.size(); i++) {
+		ok = inlineSinks[i]->finish() && ok;
+	}
+
+	for (size_t i = 0; i < workers.size(); i++) {
+		ok = workers[i]->sink->finish() && ok;
+	}
+
+	inlineSinks.clear();
+	workers.clear();
+
+	return ok;
+}
@@ -0,0 +1,168 @@
+#ifndef OUTPUT_FANOUT_6502_H
+#define OUTPUT_FANOUT_6502_H
+
+#include "StreamingDisassembler6502.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SymbolTable6502;
+
+// Receives decoded records in batches; record offsets are instruction addresses
+class OutputSink6502
+{
+public:
+
+	virtual ~OutputSink6502();
+
+	virtual void write(const StreamingDisassembler6502::Record* records, size_t count) = 0;
+
+	// Called once after the last write; returns false when output failed
+	virtual bool finish() = 0;
+};
+
+// Sink with its own output buffer, written to file whenever it fills up
+class BufferedFileSink6502 : public OutputSink6502
+{
+private:
+
+	FILE* file;
+	std::vector<char> buffer;
+	size_t used;
+	bool failed;
+
+protected:
+
+	void append(const char* text, size_t length);
+
+	void append(char character)
+	{
+		if (used == buffer.size()) {
+			flush();
+		}
+		buffer[used++] = character;
+	}
+
+	void flush();
+
+public:
+
+	static const size_t DEFAULT_BUFFER_LEN = 64 * 1024;
+
+	explicit BufferedFileSink6502(FILE* file, size_t bufferLength = DEFAULT_BUFFER_LEN);
+
+	bool finish() override;
+};
+
+// One "$XXXX\tTEXT\n" line per instruction.
+// With symbols, operands are printed as symbols and a "NAME:" line comes before every named address
+class TextSink6502 : public BufferedFileSink6502
+{
+private:
+
+	const SymbolTable6502* symbols;
+	// Grows to the longest instruction text a symbol gave so far
+	std::vector<char> operandText;
+
+public:
+
+	explicit TextSink6502(FILE* file, const SymbolTable6502* symbols = NULL, size_t bufferLength = DEFAULT_BUFFER_LEN);
+
+	void write(const StreamingDisassembler6502::Record* records, size_t count) override;
+};
+
+// One JSON object per line:
+// {"address":32768,"bytes":"A902","valid":true,"mnemonic":"LDA","operand":2,"text":"LDA #$02"}
+// mnemonic and operand are left out for bytes that do not decode
+class NdjsonSink6502 : public BufferedFileSink6502
+{
+public:
+
+	explicit NdjsonSink6502(FILE* file, size_t bufferLength = DEFAULT_BUFFER_LEN);
+
+	void write(const StreamingDisassembler6502::Record* records, size_t count) override;
+};
+
+// The 8 Byte magic "6502REC" followed by the records as they are in memory
+class BinarySink6502 : public BufferedFileSink6502
+{
+private:
+
+	bool headerWritten;
+
+public:
+
+	explicit BinarySink6502(FILE* file, size_t bufferLength = DEFAULT_BUFFER_LEN);
+
+	void write(const StreamingDisassembler6502::Record* records, size_t count) override;
+
+	bool finish() override;
+};
+
+// Decodes once and hands every batch of records to all registered sinks.
+// Sinks added with their own thread get the batches through a bounded queue and share them with the
+// other threaded sinks; the remaining sinks are called in the decoding thread.
+class OutputFanout6502
+{
+public:
+
+	static const size_t BATCH_RECORDS = 4096;
+	// Batches a threaded sink may fall behind before the decoding thread waits for it
+	static const size_t MAX_QUEUED_BATCHES = 8;
+
+private:
+
+	typedef std::shared_ptr<const std::vector<StreamingDisassembler6502::Record> > Batch;
+
+	struct SinkWorker {
+		OutputSink6502* sink;
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable changed;
+		std::deque<Batch> queue;
+		bool done;
+	};
+
+	std::vector<OutputSink6502*> inlineSinks;
+	std::vector<std::unique_ptr<SinkWorker> > workers;
+	std::vector<StreamingDisassembler6502::Record> batch;
+
+	void dispatch();
+
+	static void runWorker(SinkWorker* worker);
+
+public:
+
+	OutputFanout6502();
+	~OutputFanout6502();
+
+	OutputFanout6502(const OutputFanout6502&) = delete;
+	OutputFanout6502& operator=(const OutputFanout6502&) = delete;
+
+	// The sink must outlive finish()
+	void addSink(OutputSink6502* sink, bool ownThread = false);
+
+	void write(const StreamingDisassembler6502::Record& record)
+	{
+		batch.push_back(record);
+
+		if (batch.size() == BATCH_RECORDS) {
+			dispatch();
+		}
+	}
+
+	// Linear sweep of data, like analyze() with the addresses starting at baseAddress
+	void decode(const uint8_t* data, size_t length, uint16_t baseAddress = 0);
+
+	// Hands out the last batch, waits for the threaded sinks and finishes every sink
+	bool finish();
+};
+
+#endif
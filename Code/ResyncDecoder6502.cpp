@@ -0,0 +1,336 @@
+#include "ResyncDecoder6502.h"
+#include "DecodeCore6502.h"
+#include "InstructionLengthKernel6502.h"
+
+namespace {
+
+	const int32_t INVALID_SCORE = -12;
+	const int32_t BRK_SCORE = -4;
+	const int32_t RARE_SCORE = -6;
+	const int32_t VALID_SCORE = 1;
+	const int32_t FREQUENT_SCORE = 2;
+	const int32_t ZERO_PAGE_ABSOLUTE_SCORE = -3;
+	const int32_t BRANCH_ON_START_SCORE = 3;
+	const int32_t BRANCH_MID_INSTRUCTION_SCORE = -3;
+	// Cost of assuming a byte was lost or corrupted and the next byte is an opcode
+	const int32_t GLITCH_SCORE = -10;
+
+	// Scores stay relative to the best hypothesis; far behind ones are clamped so nothing overflows
+	const int32_t MIN_SCORE = -(1 << 16);
+	const int32_t DEAD_SCORE = -(1 << 30);
+
+	const uint8_t ABSOLUTE_OPERAND_FLAG = 0x01;
+	const uint8_t RELATIVE_OPERAND_FLAG = 0x02;
+
+	struct OpcodeScore {
+		int8_t score;
+		uint8_t flags;
+	};
+
+	bool isFrequent(const Disassembler6502::Opcode opcode)
+	{
+		switch (opcode)
+		{
+		case Disassembler6502::ADC_INSTR:
+		case Disassembler6502::AND_INSTR:
+		case Disassembler6502::BCC_INSTR:
+		case Disassembler6502::BCS_INSTR:
+		case Disassembler6502::BEQ_INSTR:
+		case Disassembler6502::BMI_INSTR:
+		case Disassembler6502::BNE_INSTR:
+		case Disassembler6502::BPL_INSTR:
+		case Disassembler6502::CLC_INSTR:
+		case Disassembler6502::CMP_INSTR:
+		case Disassembler6502::DEC_INSTR:
+		case Disassembler6502::DEX_INSTR:
+		case Disassembler6502::DEY_INSTR:
+		case Disassembler6502::INC_INSTR:
+		case Disassembler6502::INX_INSTR:
+		case Disassembler6502::INY_INSTR:
+		case Disassembler6502::JMP_INSTR:
+		case Disassembler6502::JSR_INSTR:
+		case Disassembler6502::LDA_INSTR:
+		case Disassembler6502::LDX_INSTR:
+		case Disassembler6502::LDY_INSTR:
+		case Disassembler6502::ORA_INSTR:
+		case Disassembler6502::PHA_INSTR:
+		case Disassembler6502::PLA_INSTR:
+		case Disassembler6502::RTS_INSTR:
+		case Disassembler6502::SBC_INSTR:
+		case Disassembler6502::SEC_INSTR:
+		case Disassembler6502::STA_INSTR:
+		case Disassembler6502::STX_INSTR:
+		case Disassembler6502::STY_INSTR:
+		case Disassembler6502::TAX_INSTR:
+		case Disassembler6502::TAY_INSTR:
+		case Disassembler6502::TXA_INSTR:
+		case Disassembler6502::TYA_INSTR:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Bit instructions and halts hardly ever show up in real code, but misaligned bytes decode to them often
+	bool isRare(const Disassembler6502::Opcode opcode)
+	{
+		return
+			(opcode >= Disassembler6502::BBR0_INSTR && opcode <= Disassembler6502::BBS7_INSTR) ||
+			(opcode >= Disassembler6502::RMB0_INSTR && opcode <= Disassembler6502::RMB7_INSTR) ||
+			(opcode >= Disassembler6502::SMB0_INSTR && opcode <= Disassembler6502::SMB7_INSTR) ||
+			opcode == Disassembler6502::STP_INSTR ||
+			opcode == Disassembler6502::WAI_INSTR;
+	}
+
+	const OpcodeScore* opcodeScoreTable()
+	{
+		static const struct Table {
+			OpcodeScore entries[256];
+
+			Table()
+			{
+				for (size_t i = 0; i < 256; i++) {
+					const DecodeCore6502::Descriptor& descriptor = DecodeCore6502::TABLE.entries[i];
+					const Disassembler6502::Opcode opcode = static_cast<Disassembler6502::Opcode>(descriptor.opcode);
+
+					if (descriptor.opcode == DecodeCore6502::INVALID_OPCODE) {
+						entries[i] = { static_cast<int8_t>(INVALID_SCORE), 0 };
+						continue;
+					}
+
+					uint8_t flags = 0;
+					switch (descriptor.addressingMode)
+					{
+					case Disassembler6502::ABSOLUTE_AM:
+					case Disassembler6502::ABSOLUTE_INDEXED_WITH_X_AM:
+					case Disassembler6502::ABSOLUTE_INDEXED_WITH_Y_AM:
+						// JSR and JMP into page zero are rare too, so they are not told apart
+						flags = ABSOLUTE_OPERAND_FLAG;
+						break;
+					case Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM:
+						flags = RELATIVE_OPERAND_FLAG;
+						break;
+					default:
+						break;
+					}
+
+					const int32_t score =
+						opcode == Disassembler6502::BRK_INSTR ? BRK_SCORE :
+						isRare(opcode) ? RARE_SCORE :
+						isFrequent(opcode) ? FREQUENT_SCORE : VALID_SCORE;
+
+					entries[i] = { static_cast<int8_t>(score), flags };
+				}
+			}
+		} table;
+
+		return table.entries;
+	}
+
+}
+
+void ResyncDecoder6502::startInstruction(Hypothesis& hypothesis, uint8_t data, int32_t cost)
+{
+	hypothesis.starts |= 1;
+	hypothesis.opcodeData = data;
+	hypothesis.operandsLeft = InstructionLengthKernel6502::operandLength(InstructionLengthKernel6502::classify(data));
+	hypothesis.score += opcodeScoreTable()[data].score + cost;
+}
+
+void ResyncDecoder6502::keepBetter(Hypothesis* hypotheses, const Hypothesis& candidate)
+{
+	// alignments that meet have the same future, so only the better past survives
+	Hypothesis& slot = hypotheses[candidate.operandsLeft];
+	if (candidate.score > slot.score) {
+		slot = candidate;
+	}
+}
+
+ResyncDecoder6502::ResyncDecoder6502(size_t delay) noexcept :
+	delay(delay > MAX_DELAY ? MAX_DELAY : delay)
+{
+	opcodeScoreTable();
+	reset();
+}
+
+void ResyncDecoder6502::reset() noexcept
+{
+	for (size_t i = 0; i < HYPOTHESIS_COUNT; i++) {
+		hypotheses[i] = { 0, 0, static_cast<uint8_t>(i), 0, 0 };
+	}
+
+	currentDataOffset = 0;
+	pending = StreamingDisassembler6502::Record();
+	committedLeft = 0;
+	committedIndex = 0;
+	resyncCount = 0;
+	skippedBytes = 0;
+}
+
+size_t ResyncDecoder6502::best() const
+{
+	// ties go to the lowest alignment, so a clean stream stays on the plain linear sweep
+	size_t index = 0;
+
+	for (size_t i = 1; i < HYPOTHESIS_COUNT; i++) {
+		if (hypotheses[i].score > hypotheses[index].score) {
+			index = i;
+		}
+	}
+
+	return index;
+}
+
+size_t ResyncDecoder6502::analyze(uint8_t data, StreamingDisassembler6502::Record* records) noexcept
+{
+	const uint8_t* classTable = InstructionLengthKernel6502::table();
+	const OpcodeScore* scoreTable = opcodeScoreTable();
+
+	Hypothesis next[HYPOTHESIS_COUNT];
+	for (size_t i = 0; i < HYPOTHESIS_COUNT; i++) {
+		next[i].score = DEAD_SCORE;
+	}
+
+	for (size_t i = 0; i < HYPOTHESIS_COUNT; i++) {
+		const Hypothesis& current = hypotheses[i];
+
+		if (current.score == DEAD_SCORE) {
+			continue;
+		}
+
+		// the byte read as the hypothesis expects it
+		Hypothesis candidate = current;
+		candidate.starts <<= 1;
+
+		if (current.operandsLeft == 0) {
+			startInstruction(candidate, data, 0);
+		}
+		else {
+			const OpcodeScore& opcode = scoreTable[current.opcodeData];
+			const uint8_t operandLength = InstructionLengthKernel6502::operandLength(classTable[current.opcodeData]);
+
+			if (current.operandsLeft == operandLength) {
+				candidate.operandLow = data;
+			}
+			candidate.operandsLeft--;
+
+			if (candidate.operandsLeft == 0) {
+				if ((opcode.flags & ABSOLUTE_OPERAND_FLAG) != 0 && operandLength == 2 && data == 0) {
+					candidate.score += ZERO_PAGE_ABSOLUTE_SCORE;
+				}
+
+				if ((opcode.flags & RELATIVE_OPERAND_FLAG) != 0 && static_cast<int8_t>(data) < 0) {
+					// the target is 1 + offset bytes from this operand byte, which is bit 0 of starts
+					const unsigned back = static_cast<unsigned>(-1 - static_cast<int8_t>(data));
+
+					if (back < 64) {
+						candidate.score += ((candidate.starts >> back) & 1) != 0 ? BRANCH_ON_START_SCORE : BRANCH_MID_INSTRUCTION_SCORE;
+					}
+				}
+			}
+
+			// or an operand byte was lost and this byte already is the next opcode
+			Hypothesis truncated = current;
+			truncated.starts <<= 1;
+			startInstruction(truncated, data, GLITCH_SCORE);
+			keepBetter(next, truncated);
+		}
+
+		keepBetter(next, candidate);
+
+		// or the byte is garbage, a corrupted opcode or a stray byte, and the next one is an opcode
+		Hypothesis skipped = current;
+		skipped.starts <<= 1;
+		skipped.score += GLITCH_SCORE;
+		skipped.operandsLeft = 0;
+		keepBetter(next, skipped);
+	}
+
+	int32_t bestScore = DEAD_SCORE;
+	for (size_t i = 0; i < HYPOTHESIS_COUNT; i++) {
+		bestScore = next[i].score > bestScore ? next[i].score : bestScore;
+	}
+
+	for (size_t i = 0; i < HYPOTHESIS_COUNT; i++) {
+		if (next[i].score != DEAD_SCORE) {
+			next[i].score -= bestScore;
+			next[i].score = next[i].score < MIN_SCORE ? MIN_SCORE : next[i].score;
+		}
+		hypotheses[i] = next[i];
+	}
+
+	history[currentDataOffset % 64] = data;
+	currentDataOffset++;
+
+	if (currentDataOffset <= delay) {
+		return 0;
+	}
+
+	const bool isStart = ((hypotheses[best()].starts >> delay) & 1) != 0;
+	return commit(currentDataOffset - 1 - static_cast<uint32_t>(delay), isStart, records);
+}
+
+size_t ResyncDecoder6502::commit(uint32_t offset, bool isStart, StreamingDisassembler6502::Record* records) noexcept
+{
+	const uint8_t data = history[offset % 64];
+	size_t count = 0;
+
+	if (isStart) {
+		if (committedLeft != 0) {
+			pending.classByte = 0;
+			records[count++] = pending;
+			resyncCount++;
+		}
+
+		pending.offset = offset;
+		pending.operand = 0;
+		pending.opcodeData = data;
+		pending.classByte = InstructionLengthKernel6502::classify(data);
+		committedLeft = InstructionLengthKernel6502::operandLength(pending.classByte);
+		committedIndex = 0;
+	}
+	else if (committedLeft == 0) {
+		const StreamingDisassembler6502::Record skipped = { offset, 0, data, 0 };
+		records[count++] = skipped;
+		skippedBytes++;
+		return count;
+	}
+	else {
+		pending.operand |= static_cast<uint16_t>(data << (Disassembler6502::DATA_LEN * committedIndex));
+		committedIndex++;
+		committedLeft--;
+	}
+
+	if (committedLeft == 0) {
+		records[count++] = pending;
+	}
+
+	return count;
+}
+
+size_t ResyncDecoder6502::flush(StreamingDisassembler6502::Record* records) noexcept
+{
+	const Hypothesis& winner = hypotheses[best()];
+	const size_t held = currentDataOffset < delay ? currentDataOffset : delay;
+	size_t count = 0;
+
+	for (size_t back = held; back > 0; back--) {
+		const bool isStart = ((winner.starts >> (back - 1)) & 1) != 0;
+		count += commit(currentDataOffset - static_cast<uint32_t>(back), isStart, records + count);
+	}
+
+	// an instruction whose operand never arrived is not emitted, like in StreamingDisassembler6502
+	committedLeft = 0;
+
+	return count;
+}
+
+uint32_t ResyncDecoder6502::getResyncCount() const noexcept
+{
+	return resyncCount;
+}
+
+uint32_t ResyncDecoder6502::getSkippedBytes() const noexcept
+{
+	return skippedBytes;
+}
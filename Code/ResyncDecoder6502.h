@@ -0,0 +1,76 @@
+#ifndef RESYNC_DECODER_6502_H
+#define RESYNC_DECODER_6502_H
+
+#include "StreamingDisassembler6502.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Streaming decoder for captures without SYNC that recovers from corrupted and dropped bytes.
+// At every byte the stream can only be in one of three alignments, 0, 1 or 2 operand bytes left before
+// the next opcode, so all hypotheses are tracked at once like a Viterbi decoder: each alignment keeps a
+// score and a 64 bit history of where its instructions started, and when two hypotheses reach the same
+// alignment only the better one survives. Instructions are scored by opcode validity and frequency,
+// absolute operands that should have been zero page and whether backward branches land on an instruction start.
+// Bytes are committed delay bytes after they arrive along the best hypothesis, so latency and memory are fixed.
+class ResyncDecoder6502
+{
+public:
+
+	static const size_t HYPOTHESIS_COUNT = 3;
+	static const size_t MAX_DELAY = 48;
+	static const size_t DEFAULT_DELAY = 24;
+	// Records analyze() can write for one byte
+	static const size_t MAX_RECORDS_PER_BYTE = 2;
+
+private:
+
+	struct Hypothesis {
+		// Bit i set when the byte i positions back started an instruction
+		uint64_t starts;
+		int32_t score;
+		uint8_t operandsLeft;
+		uint8_t opcodeData;
+		uint8_t operandLow;
+	};
+
+	Hypothesis hypotheses[HYPOTHESIS_COUNT];
+	uint8_t history[64];
+	uint32_t currentDataOffset;
+	size_t delay;
+
+	StreamingDisassembler6502::Record pending;
+	uint8_t committedLeft;
+	uint8_t committedIndex;
+
+	uint32_t resyncCount;
+	uint32_t skippedBytes;
+
+	size_t best() const;
+
+	static void startInstruction(Hypothesis& hypothesis, uint8_t data, int32_t cost);
+
+	static void keepBetter(Hypothesis* hypotheses, const Hypothesis& candidate);
+
+	size_t commit(uint32_t offset, bool isStart, StreamingDisassembler6502::Record* records) noexcept;
+
+public:
+
+	explicit ResyncDecoder6502(size_t delay = DEFAULT_DELAY) noexcept;
+
+	// Writes up to MAX_RECORDS_PER_BYTE records for the byte committed delay bytes ago and returns how many.
+	// An instruction cut short by a resync and a byte skipped to regain alignment come out as invalid records
+	size_t analyze(uint8_t data, StreamingDisassembler6502::Record* records) noexcept;
+
+	// Commits the bytes still held back at the end of the stream; records must hold delay * MAX_RECORDS_PER_BYTE
+	size_t flush(StreamingDisassembler6502::Record* records) noexcept;
+
+	void reset() noexcept;
+
+	// Instructions cut short because the best hypothesis moved to another alignment
+	uint32_t getResyncCount() const noexcept;
+
+	uint32_t getSkippedBytes() const noexcept;
+};
+
+#endif
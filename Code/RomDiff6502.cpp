@@ -0,0 +1,358 @@
+#include "RomDiff6502.h"
+#include "BankedDisassembly6502.h"
+#include "HashMix6502.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+	const int32_t NO_ROW = -1;
+	const uint64_t MASKED_OPERAND = 0x10000;
+	const uint64_t WINDOW_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+
+	struct Side {
+		InstructionColumns6502::View view;
+		uint16_t firstAddress;
+		size_t span;
+		std::vector<uint64_t> tokens;
+
+		explicit Side(const InstructionColumns6502& columns) :
+			view(columns.view()),
+			firstAddress(view.count > 0 ? view.addresses[0] : 0),
+			span(0)
+		{
+			if (view.count > 0) {
+				const size_t last = view.count - 1;
+				span = static_cast<uint16_t>(view.addresses[last] - firstAddress) + 1 + view.operandLengths[last];
+			}
+
+			tokens.resize(view.count);
+			for (size_t row = 0; row < view.count; row++) {
+				tokens[row] = token(row);
+			}
+		}
+
+		bool isInside(uint16_t address) const
+		{
+			return static_cast<size_t>(static_cast<uint16_t>(address - firstAddress)) < span;
+		}
+
+		bool positionDependent(size_t row, uint16_t& target) const
+		{
+			if (!BankedDisassembly6502::branchTarget(view, row, target)) {
+				return false;
+			}
+
+			return view.addressingModes[row] == Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM || isInside(target);
+		}
+
+		uint64_t token(size_t row) const
+		{
+			uint16_t target;
+			const uint64_t operand = positionDependent(row, target) ? MASKED_OPERAND : view.operands[row];
+
+			return (static_cast<uint64_t>(view.opcodeData[row]) << 32) | operand;
+		}
+
+		int32_t rowAt(uint16_t address) const
+		{
+			const uint16_t* begin = view.addresses;
+			const uint16_t* end = view.addresses + view.count;
+			const uint16_t* found = std::lower_bound(begin, end, address, [this](uint16_t rowAddress, uint16_t value) {
+				return static_cast<uint16_t>(rowAddress - firstAddress) < static_cast<uint16_t>(value - firstAddress);
+			});
+
+			return found != end && *found == address ? static_cast<int32_t>(found - begin) : NO_ROW;
+		}
+	};
+
+	void windowHashes(const std::vector<uint64_t>& tokens, size_t length, std::vector<uint64_t>& hashes)
+	{
+		hashes.clear();
+		if (tokens.size() < length) {
+			return;
+		}
+
+		uint64_t power = 1;
+		for (size_t i = 1; i < length; i++) {
+			power *= WINDOW_MULTIPLIER;
+		}
+
+		uint64_t hash = 0;
+		for (size_t i = 0; i < tokens.size(); i++) {
+			if (i >= length) {
+				hash -= HashMix6502::mix(tokens[i - length]) * power;
+			}
+
+			hash = hash * WINDOW_MULTIPLIER + HashMix6502::mix(tokens[i]);
+
+			if (i + 1 >= length) {
+				hashes.push_back(hash);
+			}
+		}
+	}
+
+	// Unique window hashes of one side, NO_ROW marks hashes seen more than once
+	void uniqueWindows(const std::vector<uint64_t>& hashes, std::unordered_map<uint64_t, int32_t>& unique)
+	{
+		unique.reserve(hashes.size());
+
+		for (size_t i = 0; i < hashes.size(); i++) {
+			const std::pair<std::unordered_map<uint64_t, int32_t>::iterator, bool> inserted = unique.insert(std::make_pair(hashes[i], static_cast<int32_t>(i)));
+
+			if (!inserted.second) {
+				inserted.first->second = NO_ROW;
+			}
+		}
+	}
+
+	typedef std::pair<uint32_t, uint32_t> Match;
+
+	// Anchors are unique on both sides; the longest chain increasing on both sides is kept
+	void anchorMatches(const Side& oldSide, const Side& newSide, size_t anchorLength, std::vector<Match>& matches)
+	{
+		std::vector<uint64_t> oldHashes;
+		std::vector<uint64_t> newHashes;
+		windowHashes(oldSide.tokens, anchorLength, oldHashes);
+		windowHashes(newSide.tokens, anchorLength, newHashes);
+
+		std::unordered_map<uint64_t, int32_t> oldUnique;
+		std::unordered_map<uint64_t, int32_t> newUnique;
+		uniqueWindows(oldHashes, oldUnique);
+		uniqueWindows(newHashes, newUnique);
+
+		std::vector<Match> anchors;
+		for (size_t newRow = 0; newRow < newHashes.size(); newRow++) {
+			const std::unordered_map<uint64_t, int32_t>::const_iterator oldEntry = oldUnique.find(newHashes[newRow]);
+
+			if (oldEntry == oldUnique.end() || oldEntry->second == NO_ROW || newUnique[newHashes[newRow]] == NO_ROW) {
+				continue;
+			}
+
+			const size_t oldRow = static_cast<size_t>(oldEntry->second);
+			if (std::equal(oldSide.tokens.begin() + oldRow, oldSide.tokens.begin() + oldRow + anchorLength, newSide.tokens.begin() + newRow)) {
+				anchors.push_back(Match(static_cast<uint32_t>(oldRow), static_cast<uint32_t>(newRow)));
+			}
+		}
+
+		// longest increasing subsequence of old rows, anchors already being in new row order
+		std::vector<size_t> tails;
+		std::vector<int32_t> previous(anchors.size(), NO_ROW);
+
+		for (size_t i = 0; i < anchors.size(); i++) {
+			const std::vector<size_t>::iterator position = std::lower_bound(tails.begin(), tails.end(), i, [&anchors](size_t tail, size_t anchor) {
+				return anchors[tail].first < anchors[anchor].first;
+			});
+
+			if (position != tails.begin()) {
+				previous[i] = static_cast<int32_t>(*(position - 1));
+			}
+
+			if (position == tails.end()) {
+				tails.push_back(i);
+			}
+			else {
+				*position = i;
+			}
+		}
+
+		std::vector<Match> chain;
+		for (int32_t i = tails.empty() ? NO_ROW : static_cast<int32_t>(tails.back()); i != NO_ROW; i = previous[i]) {
+			chain.push_back(anchors[i]);
+		}
+		std::reverse(chain.begin(), chain.end());
+
+		for (const Match& anchor : chain) {
+			for (uint32_t j = 0; j < anchorLength; j++) {
+				const Match match(anchor.first + j, anchor.second + j);
+
+				if (matches.empty() || (match.first > matches.back().first && match.second > matches.back().second)) {
+					matches.push_back(match);
+				}
+			}
+		}
+	}
+
+	void diffGap(const Side& oldSide, const Side& newSide, size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd, size_t maxGapCells, std::vector<Match>& matches)
+	{
+		const std::vector<uint64_t>& oldTokens = oldSide.tokens;
+		const std::vector<uint64_t>& newTokens = newSide.tokens;
+
+		while (oldBegin < oldEnd && newBegin < newEnd && oldTokens[oldBegin] == newTokens[newBegin]) {
+			matches.push_back(Match(static_cast<uint32_t>(oldBegin++), static_cast<uint32_t>(newBegin++)));
+		}
+
+		size_t suffix = 0;
+		while (oldEnd - suffix > oldBegin && newEnd - suffix > newBegin && oldTokens[oldEnd - suffix - 1] == newTokens[newEnd - suffix - 1]) {
+			suffix++;
+		}
+
+		const size_t oldCount = oldEnd - suffix - oldBegin;
+		const size_t newCount = newEnd - suffix - newBegin;
+
+		if (oldCount > 0 && newCount > 0 && oldCount * newCount <= maxGapCells) {
+			// longest common subsequence of the gap's interior
+			std::vector<uint32_t> lengths((oldCount + 1) * (newCount + 1), 0);
+			const size_t width = newCount + 1;
+
+			for (size_t i = oldCount; i-- > 0;) {
+				for (size_t j = newCount; j-- > 0;) {
+					lengths[i * width + j] = oldTokens[oldBegin + i] == newTokens[newBegin + j] ?
+						lengths[(i + 1) * width + j + 1] + 1 :
+						std::max(lengths[(i + 1) * width + j], lengths[i * width + j + 1]);
+				}
+			}
+
+			for (size_t i = 0, j = 0; i < oldCount && j < newCount;) {
+				if (oldTokens[oldBegin + i] == newTokens[newBegin + j]) {
+					matches.push_back(Match(static_cast<uint32_t>(oldBegin + i), static_cast<uint32_t>(newBegin + j)));
+					i++;
+					j++;
+				}
+				else if (lengths[(i + 1) * width + j] >= lengths[i * width + j + 1]) {
+					i++;
+				}
+				else {
+					j++;
+				}
+			}
+		}
+
+		for (size_t i = suffix; i > 0; i--) {
+			matches.push_back(Match(static_cast<uint32_t>(oldEnd - i), static_cast<uint32_t>(newEnd - i)));
+		}
+	}
+
+	void appendEdit(std::vector<RomDiff6502::Edit>& edits, RomDiff6502::EditKind kind, size_t oldRow, size_t newRow, size_t count)
+	{
+		if (count == 0) {
+			return;
+		}
+
+		if (!edits.empty()) {
+			RomDiff6502::Edit& last = edits.back();
+
+			const bool continuesOld = kind == RomDiff6502::INSERT_EDIT || last.oldRow + (last.kind == RomDiff6502::INSERT_EDIT ? 0 : last.count) == oldRow;
+			const bool continuesNew = kind == RomDiff6502::DELETE_EDIT || last.newRow + (last.kind == RomDiff6502::DELETE_EDIT ? 0 : last.count) == newRow;
+
+			if (last.kind == kind && continuesOld && continuesNew) {
+				last.count += static_cast<uint32_t>(count);
+				return;
+			}
+		}
+
+		edits.push_back({ kind, static_cast<uint32_t>(oldRow), static_cast<uint32_t>(newRow), static_cast<uint32_t>(count) });
+	}
+
+	void appendGapEdits(std::vector<RomDiff6502::Edit>& edits, size_t oldRow, size_t oldCount, size_t newRow, size_t newCount)
+	{
+		const size_t changed = std::min(oldCount, newCount);
+
+		appendEdit(edits, RomDiff6502::CHANGE_EDIT, oldRow, newRow, changed);
+		appendEdit(edits, RomDiff6502::DELETE_EDIT, oldRow + changed, newRow + changed, oldCount - changed);
+		appendEdit(edits, RomDiff6502::INSERT_EDIT, oldRow + changed, newRow + changed, newCount - changed);
+	}
+
+}
+
+RomDiff6502::Options::Options() :
+	anchorLength(8),
+	maxGapCells(1 << 22)
+{
+}
+
+std::vector<RomDiff6502::Edit> RomDiff6502::diff(const InstructionColumns6502& oldColumns, const InstructionColumns6502& newColumns, const Options& options)
+{
+	const Side oldSide(oldColumns);
+	const Side newSide(newColumns);
+	const size_t anchorLength = options.anchorLength > 0 ? options.anchorLength : 1;
+
+	std::vector<Match> anchors;
+	anchorMatches(oldSide, newSide, anchorLength, anchors);
+
+	// fill the gaps before, between and after the anchors
+	std::vector<Match> matches;
+	matches.reserve(std::min(oldSide.tokens.size(), newSide.tokens.size()));
+
+	size_t oldNext = 0;
+	size_t newNext = 0;
+
+	for (const Match& anchor : anchors) {
+		diffGap(oldSide, newSide, oldNext, anchor.first, newNext, anchor.second, options.maxGapCells, matches);
+		matches.push_back(anchor);
+		oldNext = anchor.first + 1;
+		newNext = anchor.second + 1;
+	}
+
+	diffGap(oldSide, newSide, oldNext, oldSide.tokens.size(), newNext, newSide.tokens.size(), options.maxGapCells, matches);
+
+	std::vector<int32_t> newForOld(oldSide.tokens.size(), NO_ROW);
+	for (const Match& match : matches) {
+		newForOld[match.first] = static_cast<int32_t>(match.second);
+	}
+
+	std::vector<Edit> edits;
+	oldNext = 0;
+	newNext = 0;
+
+	for (const Match& match : matches) {
+		appendGapEdits(edits, oldNext, match.first - oldNext, newNext, match.second - newNext);
+
+		// masked operands are equal when they point at instructions matched to each other,
+		// whether or not the numbers changed: the same JSR $8100 may now call different code
+		EditKind kind = EQUAL_EDIT;
+		uint16_t oldTarget;
+		uint16_t newTarget;
+		const bool oldDependent = oldSide.positionDependent(match.first, oldTarget);
+		const bool newDependent = newSide.positionDependent(match.second, newTarget);
+
+		if (oldDependent != newDependent) {
+			kind = CHANGE_EDIT;
+		}
+		else if (oldDependent) {
+			const int32_t oldTargetRow = oldSide.isInside(oldTarget) ? oldSide.rowAt(oldTarget) : NO_ROW;
+			const int32_t newTargetRow = newSide.isInside(newTarget) ? newSide.rowAt(newTarget) : NO_ROW;
+			bool same;
+
+			if (oldTargetRow != NO_ROW) {
+				same = newForOld[oldTargetRow] != NO_ROW && newForOld[oldTargetRow] == newTargetRow;
+			}
+			else {
+				// no instruction to follow on the old side, e.g. a branch out of the image: only the same operand on both sides counts
+				same = newTargetRow == NO_ROW && oldSide.view.operands[match.first] == newSide.view.operands[match.second];
+			}
+
+			kind = same ? EQUAL_EDIT : CHANGE_EDIT;
+		}
+
+		appendEdit(edits, kind, match.first, match.second, 1);
+		oldNext = match.first + 1;
+		newNext = match.second + 1;
+	}
+
+	appendGapEdits(edits, oldNext, oldSide.tokens.size() - oldNext, newNext, newSide.tokens.size() - newNext);
+
+	return edits;
+}
+
+std::vector<RomDiff6502::Edit> RomDiff6502::diff(const uint8_t* oldData, size_t oldLength, uint16_t oldBaseAddress,
+	const uint8_t* newData, size_t newLength, uint16_t newBaseAddress, const Options& options)
+{
+	return diff(
+		InstructionColumns6502::decode(oldData, oldLength, oldBaseAddress),
+		InstructionColumns6502::decode(newData, newLength, newBaseAddress),
+		options);
+}
+
+void RomDiff6502::writeScript(FILE* file, const std::vector<Edit>& edits, const InstructionColumns6502& oldColumns, const InstructionColumns6502& newColumns)
+{
+	static const char KIND_CHAR[] = "=+-~";
+
+	for (const Edit& edit : edits) {
+		const unsigned oldAddress = edit.oldRow < oldColumns.size() ? oldColumns.addresses[edit.oldRow] : 0;
+		const unsigned newAddress = edit.newRow < newColumns.size() ? newColumns.addresses[edit.newRow] : 0;
+
+		fprintf(file, "%c %u old@$%04X new@$%04X\n", KIND_CHAR[edit.kind], edit.count, oldAddress, newAddress);
+	}
+}
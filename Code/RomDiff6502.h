@@ -0,0 +1,54 @@
+#ifndef ROM_DIFF_6502_H
+#define ROM_DIFF_6502_H
+
+#include "InstructionColumns6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Instruction level diff between two images.
+// Instructions are compared with their position dependent operands (relative branches and absolute operands
+// pointing inside the image) masked out, aligned on unique runs of instructions found with a rolling hash,
+// and the gaps between anchors are diffed exactly when small. A matched pair whose masked operand still
+// points at the matching instruction on the other side counts as equal, so code that only moved is unchanged;
+// one pointing at anything else is a change even when the operand bytes are the same.
+class RomDiff6502
+{
+public:
+
+	enum EditKind {
+		EQUAL_EDIT,
+		INSERT_EDIT,
+		DELETE_EDIT,
+		CHANGE_EDIT
+	};
+
+	// A run of count instructions starting at oldRow and/or newRow
+	struct Edit {
+		EditKind kind;
+		uint32_t oldRow;
+		uint32_t newRow;
+		uint32_t count;
+	};
+
+	struct Options {
+		// Instructions hashed per anchor window
+		size_t anchorLength;
+		// Largest gap (old rows * new rows) diffed exactly; larger gaps become delete plus insert
+		size_t maxGapCells;
+
+		Options();
+	};
+
+	static std::vector<Edit> diff(const InstructionColumns6502& oldColumns, const InstructionColumns6502& newColumns, const Options& options = Options());
+
+	static std::vector<Edit> diff(const uint8_t* oldData, size_t oldLength, uint16_t oldBaseAddress,
+		const uint8_t* newData, size_t newLength, uint16_t newBaseAddress, const Options& options = Options());
+
+	// One "kind count old@$XXXX new@$XXXX" line per run, kind being = + - or ~
+	static void writeScript(FILE* file, const std::vector<Edit>& edits, const InstructionColumns6502& oldColumns, const InstructionColumns6502& newColumns);
+};
+
+#endif
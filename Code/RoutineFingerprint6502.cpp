@@ -0,0 +1,166 @@
+#include "RoutineFingerprint6502.h"
+#include "HashMix6502.h"
+
+namespace {
+
+	const uint32_t NO_ROW = 0xFFFFFFFF;
+	const size_t ADDRESS_COUNT = 0x10000;
+	const uint32_t KEPT_OPERAND = 0x100;
+	const uint64_t SHINGLE_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+
+	// Slot j of a MinHash is the high half of shingle * multipliers[j] + addends[j], the minimum over all shingles
+	struct MinHashParameters {
+		uint64_t multipliers[RoutineFingerprint6502::MINHASH_LEN];
+		uint64_t addends[RoutineFingerprint6502::MINHASH_LEN];
+
+		constexpr MinHashParameters() :
+			multipliers(),
+			addends()
+		{
+			for (size_t j = 0; j < RoutineFingerprint6502::MINHASH_LEN; j++) {
+				multipliers[j] = HashMix6502::mix(2 * j + 1) | 1;
+				addends[j] = HashMix6502::mix(2 * j + 2);
+			}
+		}
+	};
+
+	constexpr MinHashParameters PARAMETERS;
+
+	unsigned bitCount(uint64_t value)
+	{
+		unsigned count = 0;
+		for (; value != 0; value &= value - 1) {
+			count++;
+		}
+		return count;
+	}
+
+}
+
+uint32_t RoutineFingerprint6502::token(const InstructionColumns6502::View& view, size_t row)
+{
+	const uint32_t opcode = static_cast<uint32_t>(view.opcodeData[row]) << 16;
+
+	if (view.opcodes[row] == InstructionColumns6502::INVALID_OPCODE) {
+		return opcode;
+	}
+
+	switch (view.addressingModes[row])
+	{
+	case Disassembler6502::IMMEDIATE_ADDRESSING_AM:
+	case Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM:
+		// values and branch distances do not move with the code
+		return opcode | KEPT_OPERAND | (view.operands[row] & 0xFF);
+	default:
+		return opcode;
+	}
+}
+
+void RoutineFingerprint6502::sign(const InstructionColumns6502::View& view, size_t beginRow, size_t endRow, Signature& signature)
+{
+	for (size_t j = 0; j < MINHASH_LEN; j++) {
+		signature.minHash[j] = 0xFFFFFFFF;
+	}
+	signature.simHash = 0;
+	signature.shingleCount = 0;
+
+	if (beginRow >= endRow) {
+		return;
+	}
+
+	int32_t bitVotes[64] = {};
+	const size_t rowCount = endRow - beginRow;
+	const size_t shingleCount = rowCount < SHINGLE_LEN ? 1 : rowCount - SHINGLE_LEN + 1;
+	const size_t shingleLength = rowCount < SHINGLE_LEN ? rowCount : SHINGLE_LEN;
+
+	for (size_t first = beginRow; first < beginRow + shingleCount; first++) {
+		uint64_t shingle = 0;
+		for (size_t row = first; row < first + shingleLength; row++) {
+			shingle = shingle * SHINGLE_MULTIPLIER + token(view, row);
+		}
+		shingle = HashMix6502::mix(shingle);
+
+		for (size_t j = 0; j < MINHASH_LEN; j++) {
+			const uint32_t slot = static_cast<uint32_t>((shingle * PARAMETERS.multipliers[j] + PARAMETERS.addends[j]) >> 32);
+			signature.minHash[j] = slot < signature.minHash[j] ? slot : signature.minHash[j];
+		}
+
+		for (size_t bit = 0; bit < 64; bit++) {
+			bitVotes[bit] += ((shingle >> bit) & 1) ? 1 : -1;
+		}
+	}
+
+	for (size_t bit = 0; bit < 64; bit++) {
+		if (bitVotes[bit] > 0) {
+			signature.simHash |= 1ULL << bit;
+		}
+	}
+	signature.shingleCount = static_cast<uint32_t>(shingleCount);
+}
+
+RoutineFingerprint6502::Signature RoutineFingerprint6502::signImage(const InstructionColumns6502::View& view)
+{
+	Signature signature;
+	sign(view, 0, view.count, signature);
+	return signature;
+}
+
+std::vector<RoutineFingerprint6502::Routine> RoutineFingerprint6502::signRoutines(const InstructionColumns6502::View& view, size_t minRows)
+{
+	std::vector<Routine> routines;
+	if (view.count == 0) {
+		return routines;
+	}
+
+	std::vector<uint32_t> rowAt(ADDRESS_COUNT, NO_ROW);
+	for (size_t row = 0; row < view.count; row++) {
+		rowAt[view.addresses[row]] = static_cast<uint32_t>(row);
+	}
+
+	std::vector<uint8_t> entries(view.count, 0);
+	entries[0] = 1;
+	for (size_t row = 0; row < view.count; row++) {
+		if (view.opcodes[row] == Disassembler6502::JSR_INSTR && rowAt[view.operands[row]] != NO_ROW) {
+			entries[rowAt[view.operands[row]]] = 1;
+		}
+	}
+
+	for (size_t begin = 0; begin < view.count; ) {
+		size_t end = begin + 1;
+		while (end < view.count && !entries[end]) {
+			end++;
+		}
+
+		if (end - begin >= minRows) {
+			routines.emplace_back();
+			Routine& routine = routines.back();
+			routine.address = view.addresses[begin];
+			routine.beginRow = static_cast<uint32_t>(begin);
+			routine.endRow = static_cast<uint32_t>(end);
+			sign(view, begin, end, routine.signature);
+		}
+
+		begin = end;
+	}
+
+	return routines;
+}
+
+double RoutineFingerprint6502::similarity(const Signature& left, const Signature& right)
+{
+	if (left.shingleCount == 0 || right.shingleCount == 0) {
+		return 0.0;
+	}
+
+	size_t matches = 0;
+	for (size_t j = 0; j < MINHASH_LEN; j++) {
+		matches += left.minHash[j] == right.minHash[j];
+	}
+
+	return static_cast<double>(matches) / MINHASH_LEN;
+}
+
+unsigned RoutineFingerprint6502::simHashDistance(const Signature& left, const Signature& right)
+{
+	return bitCount(left.simHash ^ right.simHash);
+}
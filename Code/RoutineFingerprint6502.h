@@ -0,0 +1,55 @@
+#ifndef ROUTINE_FINGERPRINT_6502_H
+#define ROUTINE_FINGERPRINT_6502_H
+
+#include "InstructionColumns6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fuzzy fingerprints of decoded code, to find the same routine relocated or slightly patched across many images.
+// Every instruction becomes a token of its opcode Byte and, for immediate and relative operands only, the operand;
+// absolute and zero page addresses are dropped, so code linked at another address gives the same tokens.
+// Runs of SHINGLE_LEN tokens are hashed into shingles, summarized as a MinHash, whose matching slots estimate the
+// Jaccard similarity of the shingle sets, and a SimHash, whose Hamming distance is a cheaper coarse comparison.
+class RoutineFingerprint6502
+{
+public:
+
+	static const size_t SHINGLE_LEN = 4;
+	static const size_t MINHASH_LEN = 64;
+	static const size_t DEFAULT_MIN_ROUTINE_ROWS = 8;
+
+	struct Signature {
+		uint32_t minHash[MINHASH_LEN];
+		uint64_t simHash;
+		// 0 for an empty range, which is similar to nothing
+		uint32_t shingleCount;
+	};
+
+	// Rows from a routine entry up to the next one
+	struct Routine {
+		uint16_t address;
+		uint32_t beginRow;
+		uint32_t endRow;
+		Signature signature;
+	};
+
+	static uint32_t token(const InstructionColumns6502::View& view, size_t row);
+
+	// A range shorter than SHINGLE_LEN is one shingle
+	static void sign(const InstructionColumns6502::View& view, size_t beginRow, size_t endRow, Signature& signature);
+
+	static Signature signImage(const InstructionColumns6502::View& view);
+
+	// Routines start at the first row and at every JSR target that is an instruction start inside the image.
+	// Routines with fewer than minRows rows are left out
+	static std::vector<Routine> signRoutines(const InstructionColumns6502::View& view, size_t minRows = DEFAULT_MIN_ROUTINE_ROWS);
+
+	// Estimated Jaccard similarity of the shingle sets, from 0 to 1
+	static double similarity(const Signature& left, const Signature& right);
+
+	static unsigned simHashDistance(const Signature& left, const Signature& right);
+};
+
+#endif
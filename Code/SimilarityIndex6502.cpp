@@ -0,0 +1,84 @@
+#include "SimilarityIndex6502.h"
+#include "HashMix6502.h"
+
+#include <algorithm>
+
+const uint32_t SimilarityIndex6502::NO_ENTRY;
+
+uint64_t SimilarityIndex6502::bandKey(const RoutineFingerprint6502::Signature& signature, size_t band)
+{
+	uint64_t key = band;
+	for (size_t j = band * BAND_ROWS; j < (band + 1) * BAND_ROWS; j++) {
+		key = HashMix6502::mix(key ^ signature.minHash[j]);
+	}
+	return key;
+}
+
+void SimilarityIndex6502::add(uint64_t id, const RoutineFingerprint6502::Signature& signature)
+{
+	const uint32_t entry = static_cast<uint32_t>(entries.size());
+	entries.push_back({ id, signature });
+	next.resize(next.size() + BANDS, NO_ENTRY);
+
+	if (signature.shingleCount == 0) {
+		return;
+	}
+
+	for (size_t band = 0; band < BANDS; band++) {
+		const std::pair<std::unordered_map<uint64_t, uint32_t>::iterator, bool> inserted = heads[band].insert(std::make_pair(bandKey(signature, band), entry));
+		if (!inserted.second) {
+			next[entry * BANDS + band] = inserted.first->second;
+			inserted.first->second = entry;
+		}
+	}
+}
+
+size_t SimilarityIndex6502::query(const RoutineFingerprint6502::Signature& signature, double minSimilarity, std::vector<Match>& matches) const
+{
+	if (signature.shingleCount == 0) {
+		return 0;
+	}
+
+	std::vector<uint32_t> candidates;
+	for (size_t band = 0; band < BANDS; band++) {
+		const std::unordered_map<uint64_t, uint32_t>::const_iterator head = heads[band].find(bandKey(signature, band));
+		if (head == heads[band].end()) {
+			continue;
+		}
+
+		for (uint32_t entry = head->second; entry != NO_ENTRY; entry = next[entry * BANDS + band]) {
+			candidates.push_back(entry);
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	const size_t first = matches.size();
+	for (uint32_t entry : candidates) {
+		const double similarity = RoutineFingerprint6502::similarity(signature, entries[entry].signature);
+		if (similarity >= minSimilarity) {
+			matches.push_back({ entries[entry].id, similarity });
+		}
+	}
+
+	std::stable_sort(matches.begin() + first, matches.end(), [](const Match& left, const Match& right) {
+		return left.similarity > right.similarity;
+	});
+
+	return matches.size() - first;
+}
+
+size_t SimilarityIndex6502::size() const
+{
+	return entries.size();
+}
+
+void SimilarityIndex6502::clear()
+{
+	entries.clear();
+	next.clear();
+	for (std::unordered_map<uint64_t, uint32_t>& band : heads) {
+		band.clear();
+	}
+}
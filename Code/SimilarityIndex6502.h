@@ -0,0 +1,56 @@
+#ifndef SIMILARITY_INDEX_6502_H
+#define SIMILARITY_INDEX_6502_H
+
+#include "RoutineFingerprint6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Locality sensitive hashing over RoutineFingerprint6502 MinHashes, so "what is similar to this routine" looks at a few
+// candidates instead of every signature. The MinHash is cut into BANDS bands of BAND_ROWS slots; signatures sharing any
+// whole band land in the same bucket of that band. Two routines of Jaccard similarity s share a band with probability
+// 1 - (1 - s^BAND_ROWS)^BANDS: about 0.64 at s = 0.5 and over 0.99 from s = 0.75 up.
+class SimilarityIndex6502
+{
+public:
+
+	static const size_t BANDS = 16;
+	static const size_t BAND_ROWS = RoutineFingerprint6502::MINHASH_LEN / BANDS;
+
+	struct Match {
+		uint64_t id;
+		double similarity;
+	};
+
+private:
+
+	static const uint32_t NO_ENTRY = 0xFFFFFFFF;
+
+	struct Entry {
+		uint64_t id;
+		RoutineFingerprint6502::Signature signature;
+	};
+
+	std::vector<Entry> entries;
+	// Buckets are chains through next, one link per entry and band, started from the head of the band key
+	std::unordered_map<uint64_t, uint32_t> heads[BANDS];
+	std::vector<uint32_t> next;
+
+	static uint64_t bandKey(const RoutineFingerprint6502::Signature& signature, size_t band);
+
+public:
+
+	// id is whatever the caller needs to find the routine again, e.g. image number and address
+	void add(uint64_t id, const RoutineFingerprint6502::Signature& signature);
+
+	// Indexed signatures sharing a band with signature and at least minSimilarity similar to it, most similar first
+	size_t query(const RoutineFingerprint6502::Signature& signature, double minSimilarity, std::vector<Match>& matches) const;
+
+	size_t size() const;
+
+	void clear();
+};
+
+#endif
@@ -0,0 +1,473 @@
+#include "StageProfiler6502.h"
+
+#ifdef USE_STAGE_PROFILING
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+	const char* const STAGE_NAMES[StageProfiler6502::STAGE_COUNT] = {
+		"ingest",
+		"opcode lookup",
+		"operand",
+		"format",
+		"output"
+	};
+
+	const char* const COUNTER_NAMES[StageProfiler6502::COUNTER_COUNT] = {
+		"cycles",
+		"instructions",
+		"cache misses",
+		"branch misses"
+	};
+
+	uint64_t timestamp()
+	{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+#if defined(__linux__)
+
+	const uint64_t HARDWARE_EVENTS[StageProfiler6502::COUNTER_COUNT] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+
+	int openCounter(uint64_t event, int groupLeader)
+	{
+		perf_event_attr attributes;
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.size = sizeof(attributes);
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.config = event;
+		attributes.read_format = PERF_FORMAT_GROUP;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+
+		// pid 0 and cpu -1: the calling thread on whatever CPU it runs
+		return static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, groupLeader, 0));
+	}
+
+	// Counter value without a system call, false when the kernel does not allow rdpmc for the event right now
+	bool readMapped(const volatile perf_event_mmap_page* page, uint64_t& value)
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		uint32_t sequence;
+
+		do {
+			sequence = page->lock;
+			std::atomic_signal_fence(std::memory_order_acquire);
+
+			const uint32_t index = page->index;
+			if (!page->cap_user_rdpmc || index == 0) {
+				return false;
+			}
+
+			const unsigned width = page->pmc_width;
+			int64_t count = static_cast<int64_t>(__rdpmc(static_cast<int>(index - 1)));
+			count = static_cast<int64_t>(static_cast<uint64_t>(count) << (64 - width)) >> (64 - width);
+			value = static_cast<uint64_t>(page->offset + count);
+
+			std::atomic_signal_fence(std::memory_order_acquire);
+		} while (page->lock != sequence);
+
+		return true;
+#else
+		(void)page;
+		(void)value;
+		return false;
+#endif
+	}
+
+#endif
+
+}
+
+class StageProfiler6502::ThreadState
+{
+public:
+
+	const unsigned thread;
+	Source source;
+	Scope* current;
+	// calls, then the counters
+	std::atomic<uint64_t> totals[STAGE_COUNT][1 + COUNTER_COUNT];
+
+#if defined(__linux__)
+	int descriptors[COUNTER_COUNT];
+	// position of every counter in the group read, -1 when it could not be opened
+	int groupSlots[COUNTER_COUNT];
+	size_t groupSize;
+	perf_event_mmap_page* pages[COUNTER_COUNT];
+	size_t pageSize;
+	bool useRdpmc;
+	bool countersOpen;
+#endif
+
+	explicit ThreadState(unsigned thread) :
+		thread(thread),
+		source(TIMESTAMP_SOURCE),
+		current(NULL)
+	{
+		clear();
+		openCounters();
+	}
+
+	void clear()
+	{
+		for (size_t stage = 0; stage < STAGE_COUNT; stage++) {
+			for (size_t i = 0; i < 1 + COUNTER_COUNT; i++) {
+				totals[stage][i].store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	void openCounters()
+	{
+#if defined(__linux__)
+		countersOpen = false;
+		groupSize = 0;
+		pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		useRdpmc = true;
+
+		for (size_t i = 0; i < COUNTER_COUNT; i++) {
+			descriptors[i] = openCounter(HARDWARE_EVENTS[i], i == 0 ? -1 : descriptors[0]);
+			groupSlots[i] = descriptors[i] >= 0 ? static_cast<int>(groupSize++) : -1;
+			pages[i] = NULL;
+
+			// without a cycle counter there is no group to join
+			if (i == 0 && descriptors[0] < 0) {
+				return;
+			}
+
+			if (descriptors[i] >= 0) {
+				void* page = mmap(NULL, pageSize, PROT_READ, MAP_SHARED, descriptors[i], 0);
+				pages[i] = page != MAP_FAILED ? static_cast<perf_event_mmap_page*>(page) : NULL;
+				useRdpmc = useRdpmc && pages[i] != NULL;
+			}
+		}
+
+		source = PERF_EVENT_SOURCE;
+		countersOpen = true;
+#endif
+	}
+
+	void closeCounters()
+	{
+#if defined(__linux__)
+		if (!countersOpen) {
+			return;
+		}
+
+		for (size_t i = COUNTER_COUNT; i > 0; i--) {
+			if (pages[i - 1] != NULL) {
+				munmap(pages[i - 1], pageSize);
+			}
+			if (descriptors[i - 1] >= 0) {
+				close(descriptors[i - 1]);
+			}
+		}
+
+		countersOpen = false;
+#endif
+	}
+
+	void read(uint64_t* values)
+	{
+#if defined(__linux__)
+		if (source == PERF_EVENT_SOURCE) {
+			bool mapped = useRdpmc;
+			for (size_t i = 0; i < COUNTER_COUNT && mapped; i++) {
+				values[i] = 0;
+				mapped = pages[i] == NULL || readMapped(pages[i], values[i]);
+			}
+
+			if (mapped) {
+				return;
+			}
+
+			struct {
+				uint64_t count;
+				uint64_t values[COUNTER_COUNT];
+			} group;
+
+			if (::read(descriptors[0], &group, sizeof(group)) > 0) {
+				for (size_t i = 0; i < COUNTER_COUNT; i++) {
+					values[i] = groupSlots[i] >= 0 && static_cast<uint64_t>(groupSlots[i]) < group.count ? group.values[groupSlots[i]] : 0;
+				}
+				return;
+			}
+		}
+#endif
+
+		values[CYCLES_COUNTER] = timestamp();
+		for (size_t i = 1; i < COUNTER_COUNT; i++) {
+			values[i] = 0;
+		}
+	}
+
+	// Only the owning thread adds, so a load and a store are enough; readers see every total whole
+	void add(Stage stage, const uint64_t* values)
+	{
+		std::atomic<uint64_t>* stageTotals = totals[stage];
+
+		stageTotals[0].store(stageTotals[0].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		for (size_t i = 0; i < COUNTER_COUNT; i++) {
+			stageTotals[1 + i].store(stageTotals[1 + i].load(std::memory_order_relaxed) + values[i], std::memory_order_relaxed);
+		}
+	}
+
+	ThreadReport report() const
+	{
+		ThreadReport result;
+		result.thread = thread;
+		result.source = source;
+
+		for (size_t stage = 0; stage < STAGE_COUNT; stage++) {
+			result.stages[stage].calls = totals[stage][0].load(std::memory_order_relaxed);
+			for (size_t i = 0; i < COUNTER_COUNT; i++) {
+				result.stages[stage].counters[i] = totals[stage][1 + i].load(std::memory_order_relaxed);
+			}
+		}
+
+		return result;
+	}
+};
+
+namespace {
+
+	struct Registry {
+		std::mutex mutex;
+		unsigned nextThread;
+		std::vector<std::shared_ptr<StageProfiler6502::ThreadState> > states;
+		bool hasRetired;
+		StageProfiler6502::ThreadReport retired;
+
+		Registry() :
+			nextThread(0),
+			hasRetired(false)
+		{
+			clearRetired();
+		}
+
+		void clearRetired()
+		{
+			memset(&retired, 0, sizeof(retired));
+			retired.thread = StageProfiler6502::RETIRED_THREADS;
+			retired.source = StageProfiler6502::PERF_EVENT_SOURCE;
+		}
+
+		// Adds the totals of an exiting thread to retired and forgets its state; the mutex must be held
+		void retire(const StageProfiler6502::ThreadState& state)
+		{
+			const StageProfiler6502::ThreadReport report = state.report();
+
+			retired.source = report.source == StageProfiler6502::TIMESTAMP_SOURCE ? StageProfiler6502::TIMESTAMP_SOURCE : retired.source;
+			for (size_t stage = 0; stage < StageProfiler6502::STAGE_COUNT; stage++) {
+				retired.stages[stage].calls += report.stages[stage].calls;
+				for (size_t i = 0; i < StageProfiler6502::COUNTER_COUNT; i++) {
+					retired.stages[stage].counters[i] += report.stages[stage].counters[i];
+				}
+			}
+			hasRetired = true;
+
+			for (size_t i = 0; i < states.size(); i++) {
+				if (states[i].get() == &state) {
+					states.erase(states.begin() + i);
+					break;
+				}
+			}
+		}
+	};
+
+	Registry& registry()
+	{
+		static Registry instance;
+		return instance;
+	}
+
+	// Closes the counters when the thread exits and folds its totals into the retired ones
+	struct ThreadHolder {
+		std::shared_ptr<StageProfiler6502::ThreadState> state;
+
+		~ThreadHolder()
+		{
+			if (state) {
+				Registry& instance = registry();
+				std::lock_guard<std::mutex> lock(instance.mutex);
+				state->closeCounters();
+				instance.retire(*state);
+			}
+		}
+	};
+
+	thread_local ThreadHolder threadHolder;
+
+}
+
+StageProfiler6502::Scope::Scope(Stage stage) :
+	stage(stage)
+{
+	if (!threadHolder.state) {
+		Registry& instance = registry();
+		std::lock_guard<std::mutex> lock(instance.mutex);
+
+		threadHolder.state = std::make_shared<ThreadState>(instance.nextThread++);
+		instance.states.push_back(threadHolder.state);
+	}
+
+	state = threadHolder.state.get();
+	parent = state->current;
+	state->current = this;
+
+	for (size_t i = 0; i < COUNTER_COUNT; i++) {
+		children[i] = 0;
+	}
+
+	// read last, so setting up the scope is not counted
+	state->read(start);
+}
+
+StageProfiler6502::Scope::~Scope()
+{
+	uint64_t end[COUNTER_COUNT];
+	state->read(end);
+
+	uint64_t exclusive[COUNTER_COUNT];
+	for (size_t i = 0; i < COUNTER_COUNT; i++) {
+		const uint64_t inclusive = end[i] - start[i];
+
+		exclusive[i] = inclusive - children[i];
+		if (parent != NULL) {
+			parent->children[i] += inclusive;
+		}
+	}
+
+	state->add(stage, exclusive);
+	state->current = parent;
+}
+
+const char* StageProfiler6502::stageName(Stage stage)
+{
+	return stage < STAGE_COUNT ? STAGE_NAMES[stage] : "";
+}
+
+const char* StageProfiler6502::counterName(Counter counter)
+{
+	return counter < COUNTER_COUNT ? COUNTER_NAMES[counter] : "";
+}
+
+std::vector<StageProfiler6502::ThreadReport> StageProfiler6502::threadReports()
+{
+	Registry& instance = registry();
+	std::lock_guard<std::mutex> lock(instance.mutex);
+
+	std::vector<ThreadReport> reports;
+	reports.reserve(instance.states.size() + 1);
+
+	for (size_t i = 0; i < instance.states.size(); i++) {
+		reports.push_back(instance.states[i]->report());
+	}
+
+	if (instance.hasRetired) {
+		reports.push_back(instance.retired);
+	}
+
+	return reports;
+}
+
+StageProfiler6502::ThreadReport StageProfiler6502::total()
+{
+	ThreadReport sum;
+	memset(&sum, 0, sizeof(sum));
+	sum.source = PERF_EVENT_SOURCE;
+
+	const std::vector<ThreadReport> reports = threadReports();
+
+	for (const ThreadReport& report : reports) {
+		sum.source = report.source == TIMESTAMP_SOURCE ? TIMESTAMP_SOURCE : sum.source;
+
+		for (size_t stage = 0; stage < STAGE_COUNT; stage++) {
+			sum.stages[stage].calls += report.stages[stage].calls;
+			for (size_t i = 0; i < COUNTER_COUNT; i++) {
+				sum.stages[stage].counters[i] += report.stages[stage].counters[i];
+			}
+		}
+	}
+
+	return sum;
+}
+
+void StageProfiler6502::report(FILE* file)
+{
+	const std::vector<ThreadReport> reports = threadReports();
+
+	for (const ThreadReport& report : reports) {
+		uint64_t threadCycles = 0;
+		for (size_t stage = 0; stage < STAGE_COUNT; stage++) {
+			threadCycles += report.stages[stage].counters[CYCLES_COUNTER];
+		}
+
+		const char* source = report.source == PERF_EVENT_SOURCE ? "perf_event" : "time stamp counter";
+		if (report.thread == RETIRED_THREADS) {
+			fprintf(file, "exited threads (%s)\n", source);
+		}
+		else {
+			fprintf(file, "thread %u (%s)\n", report.thread, source);
+		}
+		fprintf(file, "  %-14s %12s %16s %16s %14s %14s %7s\n", "stage", "calls", COUNTER_NAMES[0], COUNTER_NAMES[1], COUNTER_NAMES[2], COUNTER_NAMES[3], "share");
+
+		for (size_t stage = 0; stage < STAGE_COUNT; stage++) {
+			const StageTotals& totals = report.stages[stage];
+			if (totals.calls == 0) {
+				continue;
+			}
+
+			fprintf(file, "  %-14s %12llu %16llu %16llu %14llu %14llu %6.1f%%\n",
+				STAGE_NAMES[stage],
+				static_cast<unsigned long long>(totals.calls),
+				static_cast<unsigned long long>(totals.counters[CYCLES_COUNTER]),
+				static_cast<unsigned long long>(totals.counters[INSTRUCTIONS_COUNTER]),
+				static_cast<unsigned long long>(totals.counters[CACHE_MISSES_COUNTER]),
+				static_cast<unsigned long long>(totals.counters[BRANCH_MISSES_COUNTER]),
+				threadCycles != 0 ? 100.0 * totals.counters[CYCLES_COUNTER] / threadCycles : 0.0);
+		}
+	}
+}
+
+void StageProfiler6502::reset()
+{
+	Registry& instance = registry();
+	std::lock_guard<std::mutex> lock(instance.mutex);
+
+	for (size_t i = 0; i < instance.states.size(); i++) {
+		instance.states[i]->clear();
+	}
+
+	instance.clearRetired();
+}
+
+#endif
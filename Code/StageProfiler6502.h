@@ -0,0 +1,107 @@
+#ifndef STAGE_PROFILER_6502_H
+#define STAGE_PROFILER_6502_H
+
+// Per-stage cost accounting inside the library, compiled in with USE_STAGE_PROFILING.
+// Without it PROFILE_STAGE_6502 expands to nothing and this header declares nothing else.
+#ifdef USE_STAGE_PROFILING
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Every thread reads its own counters: on Linux a perf_event_open group of cycles, instructions, cache misses
+// and branch misses, read with rdpmc where the kernel allows it; elsewhere, or when the group cannot be opened,
+// the time stamp counter in place of cycles and zero for the rest.
+// Stages nest and are counted exclusively: time in a stage called from another one goes to the inner stage only.
+// When a thread exits its totals are folded into one report numbered RETIRED_THREADS, so a report still covers every
+// thread that ever ran a stage while only the running threads keep their own state.
+class StageProfiler6502
+{
+public:
+
+	enum Stage {
+		INGEST_STAGE,
+		OPCODE_LOOKUP_STAGE,
+		OPERAND_STAGE,
+		FORMAT_STAGE,
+		OUTPUT_STAGE,
+		STAGE_COUNT
+	};
+
+	enum Counter {
+		CYCLES_COUNTER,
+		INSTRUCTIONS_COUNTER,
+		CACHE_MISSES_COUNTER,
+		BRANCH_MISSES_COUNTER,
+		COUNTER_COUNT
+	};
+
+	enum Source {
+		PERF_EVENT_SOURCE,
+		// CYCLES_COUNTER holds time stamp counter ticks, the other counters stay 0
+		TIMESTAMP_SOURCE
+	};
+
+	struct StageTotals {
+		uint64_t calls;
+		uint64_t counters[COUNTER_COUNT];
+	};
+
+	// Thread number of the report summing all threads that exited
+	static const unsigned RETIRED_THREADS = ~0u;
+
+	struct ThreadReport {
+		// Threads are numbered in the order they first entered a stage
+		unsigned thread;
+		Source source;
+		StageTotals stages[STAGE_COUNT];
+	};
+
+	class ThreadState;
+
+	class Scope
+	{
+	private:
+
+		ThreadState* state;
+		Scope* parent;
+		Stage stage;
+		uint64_t start[COUNTER_COUNT];
+		uint64_t children[COUNTER_COUNT];
+
+	public:
+
+		explicit Scope(Stage stage);
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+	static const char* stageName(Stage stage);
+
+	static const char* counterName(Counter counter);
+
+	// Running threads, then RETIRED_THREADS once a thread that ran a stage has exited
+	static std::vector<ThreadReport> threadReports();
+
+	// Sum over all threads; source is TIMESTAMP_SOURCE when any thread fell back to it
+	static ThreadReport total();
+
+	// One line per stage and thread with calls, counters and their share of the thread's cycles
+	static void report(FILE* file);
+
+	// Zeroes the totals of every thread and of the exited ones
+	static void reset();
+};
+
+#define PROFILE_STAGE_6502(stage) StageProfiler6502::Scope stageScope6502(StageProfiler6502::stage)
+
+#else
+
+#define PROFILE_STAGE_6502(stage)
+
+#endif
+
+#endif
@@ -0,0 +1,68 @@
+#include "StreamingDisassembler6502.h"
+#include "DecodeCore6502.h"
+#include "InstructionLengthKernel6502.h"
+#include "StageProfiler6502.h"
+
+StreamingDisassembler6502::StreamingDisassembler6502() noexcept :
+	classTable(InstructionLengthKernel6502::table()),
+	pending(),
+	currentDataOffset(0),
+	argumentsLeft(0)
+{
+}
+
+bool StreamingDisassembler6502::analyze(uint8_t data, Record& record) noexcept
+{
+	currentDataOffset++;
+
+	if (argumentsLeft == 0) {
+		pending.offset = currentDataOffset - 1;
+		pending.operand = 0;
+		pending.opcodeData = data;
+		pending.classByte = classTable[data];
+		argumentsLeft = InstructionLengthKernel6502::operandLength(pending.classByte);
+	}
+	else {
+		const uint8_t argumentNumber = InstructionLengthKernel6502::operandLength(pending.classByte);
+
+		pending.operand |= static_cast<uint16_t>(data << (Disassembler6502::DATA_LEN * (argumentNumber - argumentsLeft)));
+		argumentsLeft--;
+	}
+
+	if (argumentsLeft != 0) {
+		return false;
+	}
+
+	record = pending;
+	return true;
+}
+
+void StreamingDisassembler6502::reset() noexcept
+{
+	pending = Record();
+	currentDataOffset = 0;
+	argumentsLeft = 0;
+}
+
+uint32_t StreamingDisassembler6502::getCurrentDataOffset() const noexcept
+{
+	return currentDataOffset;
+}
+
+bool StreamingDisassembler6502::isValid(const Record& record) noexcept
+{
+	return InstructionLengthKernel6502::isValid(record.classByte);
+}
+
+size_t StreamingDisassembler6502::format(const Record& record, char* buffer, size_t capacity) noexcept
+{
+	PROFILE_STAGE_6502(FORMAT_STAGE);
+
+	// records carry their own validity, e.g. an instruction a resync cut short
+	if (!isValid(record)) {
+		const DecodeCore6502::Descriptor invalid = { DecodeCore6502::INVALID_OPCODE, 0, 0 };
+		return DecodeCore6502::format(invalid, 0, 0, buffer, capacity);
+	}
+
+	return DecodeCore6502::format(record.opcodeData, record.operand, static_cast<uint16_t>(record.offset), buffer, capacity);
+}
@@ -0,0 +1,118 @@
+#ifndef STREAMING_DISASSEMBLER_6502_H
+#define STREAMING_DISASSEMBLER_6502_H
+
+#include "Disassembler6502.h"
+
+#ifdef USE_ETL
+#include <etl/atomic.h>
+#else
+#include <atomic>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Real-time counterpart of Disassembler6502 for bus sniffers.
+// analyze() never allocates, never throws and has no loops: per byte it does one table load,
+// at most three compares and one 8 Byte record write, so its cost is the same for every input byte.
+// Decoded instructions come out as plain records that format() turns into text later, outside the sampling context.
+//
+// Worst case, derived from the x86-64 code at -O2: the longest path through analyze() (an operand byte that completes
+// the instruction) is 29 instructions with three conditional branches, one variable shift and a load from the 256 Byte
+// class table, about 30 core cycles with that table in L1 and one cache miss more when it is not.
+// RecordQueue6502::push() is 12 instructions when it stores, 6 plus one locked add when the queue is full.
+// benchmark/latency_benchmark.cpp times every opcode in every operand phase; on an x86-64 host it measured
+// analyze() at p50 10-14, p99 54 and push() at p50 10, p99 24 TSC ticks, with larger maxima only from host interrupts.
+class StreamingDisassembler6502
+{
+public:
+
+	struct Record {
+		uint32_t offset;      // offset of the opcode byte in the stream
+		uint16_t operand;
+		uint8_t opcodeData;
+		uint8_t classByte;    // InstructionLengthKernel6502 class of opcodeData
+	};
+
+	static const size_t MAX_TEXT_LEN = Disassembler6502::MAX_INSTRUCTION_LEN;
+
+private:
+
+	const uint8_t* classTable;
+	Record pending;
+	uint32_t currentDataOffset;
+	uint8_t argumentsLeft;
+
+public:
+
+	// Builds the opcode tables on first use; construct before the real-time loop starts
+	StreamingDisassembler6502() noexcept;
+
+	// Returns true and fills record when data completes an instruction or is not a valid opcode
+	bool analyze(uint8_t data, Record& record) noexcept;
+
+	void reset() noexcept;
+
+	uint32_t getCurrentDataOffset() const noexcept;
+
+	static bool isValid(const Record& record) noexcept;
+
+	// Writes the same text as instructionString + ' ' + Disassembler6502::to_string(), or "???" for an invalid opcode.
+	// Returns the text length, the buffer is always NUL terminated when capacity > 0
+	static size_t format(const Record& record, char* buffer, size_t capacity) noexcept;
+};
+
+// Single producer, single consumer queue of records between the sampling context and the formatting context.
+// Capacity must be a power of two; a full queue drops the record and counts it instead of blocking
+template <size_t CAPACITY>
+class RecordQueue6502
+{
+	static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+private:
+
+	StreamingDisassembler6502::Record records[CAPACITY];
+	ETL_OR_STD::atomic<uint32_t> head;
+	ETL_OR_STD::atomic<uint32_t> tail;
+	ETL_OR_STD::atomic<uint32_t> dropped;
+
+public:
+
+	RecordQueue6502() noexcept : head(0), tail(0), dropped(0) {}
+
+	bool push(const StreamingDisassembler6502::Record& record) noexcept
+	{
+		const uint32_t currentTail = tail.load(ETL_OR_STD::memory_order_relaxed);
+
+		if (currentTail - head.load(ETL_OR_STD::memory_order_acquire) == CAPACITY) {
+			dropped.fetch_add(1, ETL_OR_STD::memory_order_relaxed);
+			return false;
+		}
+
+		records[currentTail & (CAPACITY - 1)] = record;
+		tail.store(currentTail + 1, ETL_OR_STD::memory_order_release);
+
+		return true;
+	}
+
+	bool pop(StreamingDisassembler6502::Record& record) noexcept
+	{
+		const uint32_t currentHead = head.load(ETL_OR_STD::memory_order_relaxed);
+
+		if (currentHead == tail.load(ETL_OR_STD::memory_order_acquire)) {
+			return false;
+		}
+
+		record = records[currentHead & (CAPACITY - 1)];
+		head.store(currentHead + 1, ETL_OR_STD::memory_order_release);
+
+		return true;
+	}
+
+	uint32_t getDropped() const noexcept
+	{
+		return dropped.load(ETL_OR_STD::memory_order_relaxed);
+	}
+};
+
+#endif
@@ -0,0 +1,390 @@
+#include "SymbolTable6502.h"
+#include "DecodeCore6502.h"
+#include "InstructionLengthKernel6502.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+	struct TextWriter {
+		char* buffer;
+		size_t capacity;
+		size_t length;
+
+		void append(const char* text)
+		{
+			for (; *text != '\0'; text++) {
+				if (length + 1 < capacity) {
+					buffer[length] = *text;
+				}
+				length++;
+			}
+		}
+
+		size_t finish()
+		{
+			if (capacity > 0) {
+				buffer[length < capacity ? length : capacity - 1] = '\0';
+			}
+			return length;
+		}
+	};
+
+	bool isSpace(char character)
+	{
+		return character == ' ' || character == '\t' || character == '\r';
+	}
+
+	bool isNameStart(char character)
+	{
+		return (character >= 'A' && character <= 'Z') || (character >= 'a' && character <= 'z') ||
+			character == '_' || character == '.' || character == '@';
+	}
+
+	bool isNameCharacter(char character)
+	{
+		return isNameStart(character) || (character >= '0' && character <= '9');
+	}
+
+	int digitValue(char character)
+	{
+		if (character >= '0' && character <= '9') {
+			return character - '0';
+		}
+		if (character >= 'A' && character <= 'F') {
+			return character - 'A' + 10;
+		}
+		if (character >= 'a' && character <= 'f') {
+			return character - 'a' + 10;
+		}
+		return 16;
+	}
+
+	void skipSpaces(const char*& text, const char* end)
+	{
+		while (text < end && isSpace(*text)) {
+			text++;
+		}
+	}
+
+	// "$hex", "0xhex", "%binary", otherwise hex or decimal digits; fails past 0xFFFF
+	bool parseAddress(const char*& text, const char* end, bool hexByDefault, uint16_t& address)
+	{
+		unsigned base = hexByDefault ? 16 : 10;
+
+		if (text < end && *text == '$') {
+			base = 16;
+			text++;
+		}
+		else if (text < end && *text == '%') {
+			base = 2;
+			text++;
+		}
+		else if (end - text > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+			base = 16;
+			text += 2;
+		}
+
+		uint32_t value = 0;
+		const char* digits = text;
+
+		for (; text < end && digitValue(*text) < static_cast<int>(base); text++) {
+			value = value * base + digitValue(*text);
+			if (value > 0xFFFF) {
+				return false;
+			}
+		}
+
+		address = static_cast<uint16_t>(value);
+		return text != digits;
+	}
+
+	bool parseName(const char*& text, const char* end, const char*& name, size_t& length)
+	{
+		if (text == end || !isNameStart(*text)) {
+			return false;
+		}
+
+		name = text;
+		while (text < end && isNameCharacter(*text)) {
+			text++;
+		}
+		length = text - name;
+
+		return true;
+	}
+
+	bool atLineEnd(const char* text, const char* end)
+	{
+		skipSpaces(text, end);
+		return text == end;
+	}
+
+	bool parseVice(const char* text, const char* end, uint16_t& address, const char*& name, size_t& length)
+	{
+		if (end - text < 3 || text[0] != 'a' || text[1] != 'l' || !isSpace(text[2])) {
+			return false;
+		}
+		text += 3;
+		skipSpaces(text, end);
+
+		// optional memory space prefix, "C:" for the CPU
+		if (end - text > 2 && text[1] == ':') {
+			text += 2;
+		}
+
+		if (!parseAddress(text, end, true, address)) {
+			return false;
+		}
+		skipSpaces(text, end);
+
+		if (text < end && *text == '.') {
+			text++;
+		}
+
+		return parseName(text, end, name, length) && atLineEnd(text, end);
+	}
+
+	bool parseEquate(const char* text, const char* end, uint16_t& address, const char*& name, size_t& length)
+	{
+		if (!parseName(text, end, name, length)) {
+			return false;
+		}
+		skipSpaces(text, end);
+
+		if (text < end && *text == '=') {
+			text++;
+		}
+		else if (end - text >= 2 && text[0] == ':' && text[1] == '=') {
+			text += 2;
+		}
+		else if (end - text > 3 && (text[0] | 0x20) == 'e' && (text[1] | 0x20) == 'q' && (text[2] | 0x20) == 'u' && isSpace(text[3])) {
+			text += 3;
+		}
+		else {
+			return false;
+		}
+		skipSpaces(text, end);
+
+		return parseAddress(text, end, false, address) && atLineEnd(text, end);
+	}
+
+	bool parseAddressName(const char* text, const char* end, uint16_t& address, const char*& name, size_t& length)
+	{
+		if (!parseAddress(text, end, true, address) || text == end || !isSpace(*text)) {
+			return false;
+		}
+		skipSpaces(text, end);
+
+		return parseName(text, end, name, length) && atLineEnd(text, end);
+	}
+
+	// Line without its comment and surrounding spaces
+	void trimLine(const char*& begin, const char*& end)
+	{
+		for (const char* text = begin; text < end; text++) {
+			if (*text == ';' || *text == '#' || (*text == '/' && text + 1 < end && text[1] == '/')) {
+				end = text;
+				break;
+			}
+		}
+
+		skipSpaces(begin, end);
+		while (end > begin && isSpace(end[-1])) {
+			end--;
+		}
+	}
+
+}
+
+SymbolTable6502::SymbolTable6502() :
+	nameOffsets(ADDRESS_COUNT, 0),
+	names(1, '\0'),
+	count(0)
+{
+}
+
+void SymbolTable6502::add(uint16_t address, const char* name, size_t length)
+{
+	// offset 0 is the empty name every missing symbol points at; replaced names stay in the pool until clear()
+	count += nameOffsets[address] == 0;
+	nameOffsets[address] = static_cast<uint32_t>(names.size());
+	names.insert(names.end(), name, name + length);
+	names.push_back('\0');
+}
+
+void SymbolTable6502::add(uint16_t address, const char* name)
+{
+	add(address, name, strlen(name));
+}
+
+void SymbolTable6502::remove(uint16_t address)
+{
+	count -= nameOffsets[address] != 0;
+	nameOffsets[address] = 0;
+}
+
+void SymbolTable6502::clear()
+{
+	nameOffsets.assign(ADDRESS_COUNT, 0);
+	names.assign(1, '\0');
+	count = 0;
+}
+
+size_t SymbolTable6502::size() const
+{
+	return count;
+}
+
+const char* SymbolTable6502::lookup(const void* table, uint16_t address)
+{
+	return static_cast<const SymbolTable6502*>(table)->find(address);
+}
+
+size_t SymbolTable6502::load(const char* text, size_t length, Format format)
+{
+	const char* const end = text + length;
+	size_t added = 0;
+
+	names.reserve(names.size() + length);
+
+	while (text < end) {
+		const char* lineEnd = static_cast<const char*>(memchr(text, '\n', end - text));
+		if (lineEnd == NULL) {
+			lineEnd = end;
+		}
+
+		const char* lineBegin = text;
+		const char* contentEnd = lineEnd;
+		trimLine(lineBegin, contentEnd);
+
+		uint16_t address = 0;
+		const char* name = NULL;
+		size_t nameLength = 0;
+		bool parsed = false;
+
+		switch (format)
+		{
+		case AUTO_FORMAT:
+			parsed =
+				parseVice(lineBegin, contentEnd, address, name, nameLength) ||
+				parseEquate(lineBegin, contentEnd, address, name, nameLength) ||
+				parseAddressName(lineBegin, contentEnd, address, name, nameLength);
+			break;
+		case VICE_FORMAT:
+			parsed = parseVice(lineBegin, contentEnd, address, name, nameLength);
+			break;
+		case EQUATE_FORMAT:
+			parsed = parseEquate(lineBegin, contentEnd, address, name, nameLength);
+			break;
+		case ADDRESS_NAME_FORMAT:
+			parsed = parseAddressName(lineBegin, contentEnd, address, name, nameLength);
+			break;
+		}
+
+		if (parsed) {
+			add(address, name, nameLength);
+			added++;
+		}
+
+		text = lineEnd + 1;
+	}
+
+	return added;
+}
+
+size_t SymbolTable6502::loadFile(const char* path, Format format)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return 0;
+	}
+
+	std::vector<char> text;
+	char chunk[64 * 1024];
+	size_t read;
+
+	while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		text.insert(text.end(), chunk, chunk + read);
+	}
+
+	const bool ok = ferror(file) == 0;
+	fclose(file);
+
+	return ok ? load(text.data(), text.size(), format) : 0;
+}
+
+size_t SymbolTable6502::addLabels(const InstructionColumns6502::View& view)
+{
+	if (view.count == 0) {
+		return 0;
+	}
+
+	const uint32_t first = view.addresses[0];
+	const uint32_t last = static_cast<uint32_t>(view.addresses[view.count - 1]) + view.operandLengths[view.count - 1];
+	size_t added = 0;
+	char label[16];
+
+	for (size_t row = 0; row < view.count; row++) {
+		const uint8_t opcode = view.opcodes[row];
+		const uint8_t addressingMode = view.addressingModes[row];
+		uint16_t target;
+
+		if (opcode == InstructionColumns6502::INVALID_OPCODE || view.operandLengths[row] == 0) {
+			continue;
+		}
+
+		if (addressingMode == Disassembler6502::PROGRAM_COUNTER_RELATIVE_AM) {
+			target = static_cast<uint16_t>(view.addresses[row] + 2 + static_cast<int8_t>(view.operands[row]));
+		}
+		else if ((opcode == Disassembler6502::JSR_INSTR || opcode == Disassembler6502::JMP_INSTR) && addressingMode == Disassembler6502::ABSOLUTE_AM) {
+			target = view.operands[row];
+		}
+		else {
+			continue;
+		}
+
+		if (target < first || target > last || nameOffsets[target] != 0) {
+			continue;
+		}
+
+		const int length = snprintf(label, sizeof(label), opcode == Disassembler6502::JSR_INSTR ? "SUB_%04X" : "L_%04X", target);
+		add(target, label, static_cast<size_t>(length));
+		added++;
+	}
+
+	return added;
+}
+
+size_t SymbolTable6502::format(const StreamingDisassembler6502::Record& record, char* buffer, size_t capacity) const
+{
+	const uint8_t argumentNumber = InstructionLengthKernel6502::operandLength(record.classByte);
+
+	if (!StreamingDisassembler6502::isValid(record) || argumentNumber == 0) {
+		return StreamingDisassembler6502::format(record, buffer, capacity);
+	}
+
+	const DecodeCore6502::Descriptor descriptor = DecodeCore6502::descriptor(record.opcodeData);
+	const Disassembler6502::AddressingMode addressingMode = static_cast<Disassembler6502::AddressingMode>(descriptor.addressingMode);
+
+	if (addressingMode == Disassembler6502::IMMEDIATE_ADDRESSING_AM) {
+		return StreamingDisassembler6502::format(record, buffer, capacity);
+	}
+
+	const uint16_t value = DecodeCore6502::operandValue(descriptor, record.operand, static_cast<uint16_t>(record.offset));
+
+	const char* name = find(value);
+	if (name == NULL) {
+		return StreamingDisassembler6502::format(record, buffer, capacity);
+	}
+
+	TextWriter writer = { buffer, capacity, 0 };
+	writer.append(DecodeCore6502::mnemonic(static_cast<Disassembler6502::Opcode>(descriptor.opcode)));
+	writer.append(" ");
+	writer.append(DecodeCore6502::operandPrefix(addressingMode));
+	writer.append(name);
+	writer.append(DecodeCore6502::operandSuffix(addressingMode));
+
+	return writer.finish();
+}
@@ -0,0 +1,78 @@
+#ifndef SYMBOL_TABLE_6502_H
+#define SYMBOL_TABLE_6502_H
+
+#include "InstructionColumns6502.h"
+#include "StreamingDisassembler6502.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Names for addresses of the 64 KiB address space.
+// Lookups go through a direct index of 32 bit offsets into one pool of NUL terminated names,
+// so find() is a single load and rendering with symbols never allocates.
+class SymbolTable6502
+{
+public:
+
+	static const size_t ADDRESS_COUNT = 0x10000;
+
+	enum Format {
+		// Decided line by line from the shapes below
+		AUTO_FORMAT,
+		// VICE monitor and ld65 -Ln: "al C:E000 .reset"
+		VICE_FORMAT,
+		// Assembler equates: "reset = $E000", "reset EQU $E000", "reset := $E000"
+		EQUATE_FORMAT,
+		// "E000 reset" or "$E000 reset"
+		ADDRESS_NAME_FORMAT
+	};
+
+private:
+
+	std::vector<uint32_t> nameOffsets;
+	std::vector<char> names;
+	size_t count;
+
+public:
+
+	SymbolTable6502();
+
+	// Replaces the name of address
+	void add(uint16_t address, const char* name, size_t length);
+
+	void add(uint16_t address, const char* name);
+
+	void remove(uint16_t address);
+
+	void clear();
+
+	size_t size() const;
+
+	// NULL when address has no symbol
+	const char* find(uint16_t address) const
+	{
+		const uint32_t offset = nameOffsets[address];
+		return offset != 0 ? names.data() + offset : NULL;
+	}
+
+	// Disassembler6502::SymbolLookup over the table passed as context
+	static const char* lookup(const void* table, uint16_t address);
+
+	// Loads symbol file text; comments after ';', '#' or "//" and lines that do not parse are skipped.
+	// Returns the number of symbols added
+	size_t load(const char* text, size_t length, Format format = AUTO_FORMAT);
+
+	// Returns the number of symbols added, 0 when the file could not be read
+	size_t loadFile(const char* path, Format format = AUTO_FORMAT);
+
+	// Names the targets of branches, JMP and JSR that lie inside the decoded image and have no symbol yet:
+	// "SUB_XXXX" for JSR targets and "L_XXXX" for the rest. Returns the number of labels added
+	size_t addLabels(const InstructionColumns6502::View& view);
+
+	// StreamingDisassembler6502::format() with operand addresses replaced by their symbols.
+	// Immediate operands stay numbers. Returns the text length; the buffer is always NUL terminated when capacity > 0
+	size_t format(const StreamingDisassembler6502::Record& record, char* buffer, size_t capacity) const;
+};
+
+#endif
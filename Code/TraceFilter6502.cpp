@@ -0,0 +1,143 @@
+#include "TraceFilter6502.h"
+#include "DecodeCore6502.h"
+
+#include <cstring>
+
+namespace {
+
+	bool inRanges(const TraceFilter6502::Range* ranges, size_t rangeCount, uint16_t address)
+	{
+		for (size_t i = 0; i < rangeCount; i++) {
+			if (static_cast<uint16_t>(address - ranges[i].first) <= static_cast<uint16_t>(ranges[i].last - ranges[i].first)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+}
+
+TraceFilter6502::TraceFilter6502()
+{
+	clear();
+}
+
+void TraceFilter6502::clear()
+{
+	pcRangeCount = 0;
+	dataRangeCount = 0;
+	opcodeFilter = false;
+	memset(opcodeMask, 0, sizeof(opcodeMask));
+	memset(pcBuckets, 0, sizeof(pcBuckets));
+}
+
+bool TraceFilter6502::addPcRange(uint16_t first, uint16_t last)
+{
+	if (pcRangeCount == MAX_RANGES || first > last) {
+		return false;
+	}
+
+	const Range range = { first, last };
+	pcRanges[pcRangeCount++] = range;
+
+	for (size_t bucket = first >> BusTrace6502::PC_BUCKET_SHIFT; bucket <= static_cast<size_t>(last >> BusTrace6502::PC_BUCKET_SHIFT); bucket++) {
+		pcBuckets[bucket / 64] |= static_cast<uint64_t>(1) << (bucket % 64);
+	}
+
+	return true;
+}
+
+bool TraceFilter6502::addDataRange(uint16_t first, uint16_t last)
+{
+	if (dataRangeCount == MAX_RANGES || first > last) {
+		return false;
+	}
+
+	const Range range = { first, last };
+	dataRanges[dataRangeCount++] = range;
+
+	return true;
+}
+
+void TraceFilter6502::addOpcodeData(uint8_t data)
+{
+	opcodeMask[data / 64] |= static_cast<uint64_t>(1) << (data % 64);
+	opcodeFilter = true;
+}
+
+void TraceFilter6502::addOpcode(Disassembler6502::Opcode opcode)
+{
+	for (size_t i = 0; i < 256; i++) {
+		if (DecodeCore6502::TABLE.entries[i].opcode == opcode) {
+			addOpcodeData(static_cast<uint8_t>(i));
+		}
+	}
+
+	// an opcode no byte decodes to still filters, it just lets nothing through
+	opcodeFilter = true;
+}
+
+bool TraceFilter6502::hasPcRanges() const
+{
+	return pcRangeCount != 0;
+}
+
+bool TraceFilter6502::hasDataRanges() const
+{
+	return dataRangeCount != 0;
+}
+
+bool TraceFilter6502::acceptsPc(uint16_t address) const
+{
+	return pcRangeCount == 0 || inRanges(pcRanges, pcRangeCount, address);
+}
+
+bool TraceFilter6502::acceptsData(uint16_t address) const
+{
+	return dataRangeCount == 0 || inRanges(dataRanges, dataRangeCount, address);
+}
+
+void TraceFilter6502::matchRanges(const Range* ranges, size_t rangeCount, const BusTrace6502::Sample* samples, size_t count, uint8_t* matches)
+{
+	if (rangeCount == 0) {
+		memset(matches, 1, count);
+		return;
+	}
+
+	memset(matches, 0, count);
+
+	// one pass per range with a single unsigned compare per sample keeps the inner loop branch free for the vectorizer
+	for (size_t r = 0; r < rangeCount; r++) {
+		const uint16_t first = ranges[r].first;
+		const uint16_t span = static_cast<uint16_t>(ranges[r].last - first);
+
+		for (size_t i = 0; i < count; i++) {
+			matches[i] |= static_cast<uint8_t>(static_cast<uint16_t>(samples[i].address - first) <= span);
+		}
+	}
+}
+
+void TraceFilter6502::matchPc(const BusTrace6502::Sample* samples, size_t count, uint8_t* matches) const
+{
+	matchRanges(pcRanges, pcRangeCount, samples, count, matches);
+}
+
+void TraceFilter6502::matchData(const BusTrace6502::Sample* samples, size_t count, uint8_t* matches) const
+{
+	matchRanges(dataRanges, dataRangeCount, samples, count, matches);
+}
+
+bool TraceFilter6502::mayFetchIn(const uint64_t* blockMask) const
+{
+	if (pcRangeCount == 0 || blockMask == NULL) {
+		return true;
+	}
+
+	uint64_t common = 0;
+	for (size_t i = 0; i < BusTrace6502::PC_MASK_WORDS; i++) {
+		common |= blockMask[i] & pcBuckets[i];
+	}
+
+	return common != 0;
+}
@@ -0,0 +1,76 @@
+#ifndef TRACE_FILTER_6502_H
+#define TRACE_FILTER_6502_H
+
+#include "BusTrace6502.h"
+#include "Disassembler6502.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Predicates that trace decoding checks before it builds a record, so instructions nobody asked for are
+// never decoded, formatted or emitted. An instruction passes when its PC lies in one of the PC ranges, its
+// opcode byte is in the opcode set and one of its data cycles touches a data range; a kind of predicate
+// with nothing added accepts everything. Ranges are inclusive and checked over whole batches of samples.
+class TraceFilter6502
+{
+public:
+
+	static const size_t MAX_RANGES = 8;
+
+	struct Range {
+		uint16_t first;
+		uint16_t last;
+	};
+
+private:
+
+	Range pcRanges[MAX_RANGES];
+	size_t pcRangeCount;
+	Range dataRanges[MAX_RANGES];
+	size_t dataRangeCount;
+	uint64_t opcodeMask[4];
+	bool opcodeFilter;
+	// PC_BUCKET_SIZE buckets touched by the PC ranges, in the layout of the BusTrace6502 PC index
+	uint64_t pcBuckets[BusTrace6502::PC_MASK_WORDS];
+
+	static void matchRanges(const Range* ranges, size_t rangeCount, const BusTrace6502::Sample* samples, size_t count, uint8_t* matches);
+
+public:
+
+	TraceFilter6502();
+
+	// Returns false when MAX_RANGES ranges were added already
+	bool addPcRange(uint16_t first, uint16_t last);
+
+	bool addDataRange(uint16_t first, uint16_t last);
+
+	void addOpcodeData(uint8_t data);
+
+	// Every opcode byte that decodes to opcode
+	void addOpcode(Disassembler6502::Opcode opcode);
+
+	void clear();
+
+	bool hasPcRanges() const;
+
+	bool hasDataRanges() const;
+
+	bool acceptsOpcode(uint8_t data) const
+	{
+		return !opcodeFilter || ((opcodeMask[data / 64] >> (data % 64)) & 1) != 0;
+	}
+
+	bool acceptsPc(uint16_t address) const;
+
+	bool acceptsData(uint16_t address) const;
+
+	// Sets matches[i] to 1 when samples[i].address lies in a PC range, 0 otherwise
+	void matchPc(const BusTrace6502::Sample* samples, size_t count, uint8_t* matches) const;
+
+	void matchData(const BusTrace6502::Sample* samples, size_t count, uint8_t* matches) const;
+
+	// False when a block whose PC index mask is blockMask cannot hold a fetch in a PC range
+	bool mayFetchIn(const uint64_t* blockMask) const;
+};
+
+#endif
@@ -0,0 +1,164 @@
+#ifdef USE_ETL
+#define ETL_NO_STL
+#include <etl/platform.h>
+#else
+#define ETL_OR_STD std
+#endif
+
+
+#include "InstructionLengthKernel6502.h"
+#include "StreamingDisassembler6502.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define HAS_TSC 1
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define HAS_TSC 1
+#endif
+
+
+// Host side latency distribution of StreamingDisassembler6502::analyze() and RecordQueue6502::push().
+// Every call is timed on its own, for all 256 opcodes in every operand phase, ROUNDS times over.
+// Times are time stamp counter ticks where the CPU has one, nanoseconds otherwise; the cost of reading
+// the counter is measured the same way and subtracted.
+
+namespace {
+
+	const size_t ROUNDS = 2000;
+	const size_t PHASES = 3;
+	const size_t QUEUE_CAPACITY = 1024;
+
+	inline uint64_t now()
+	{
+#ifdef HAS_TSC
+		return __rdtsc();
+#else
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	// Keeps the compiler from dropping the timed call
+	volatile uint32_t sink;
+
+	uint64_t percentile(const std::vector<uint64_t>& sorted, double fraction)
+	{
+		const size_t index = static_cast<size_t>(fraction * (sorted.size() - 1));
+		return sorted[index];
+	}
+
+	void print(const char* name, std::vector<uint64_t>& samples, uint64_t overhead)
+	{
+		for (uint64_t& sample : samples) {
+			sample = sample > overhead ? sample - overhead : 0;
+		}
+		std::sort(samples.begin(), samples.end());
+
+		printf("%-28s %9zu samples  p50 %4llu  p99 %4llu  p99.9 %4llu  max %6llu\n", name, samples.size(),
+			static_cast<unsigned long long>(percentile(samples, 0.5)),
+			static_cast<unsigned long long>(percentile(samples, 0.99)),
+			static_cast<unsigned long long>(percentile(samples, 0.999)),
+			static_cast<unsigned long long>(samples.back()));
+	}
+
+	uint64_t timerOverhead()
+	{
+		std::vector<uint64_t> samples(ROUNDS * 256);
+		for (uint64_t& sample : samples) {
+			const uint64_t start = now();
+			sample = now() - start;
+		}
+		std::sort(samples.begin(), samples.end());
+		return percentile(samples, 0.5);
+	}
+
+}
+
+int main()
+{
+	const uint64_t overhead = timerOverhead();
+#ifdef HAS_TSC
+	printf("unit: TSC ticks, timer overhead %llu subtracted\n", static_cast<unsigned long long>(overhead));
+#else
+	printf("unit: ns, timer overhead %llu subtracted\n", static_cast<unsigned long long>(overhead));
+#endif
+
+	StreamingDisassembler6502 disassembler;
+	StreamingDisassembler6502::Record record;
+
+	std::vector<uint64_t> phaseSamples[PHASES];
+	std::vector<uint64_t> allSamples;
+	uint64_t worst[PHASES] = {};
+	uint8_t worstOpcode[PHASES] = {};
+
+	for (size_t round = 0; round < ROUNDS; round++) {
+		for (size_t opcode = 0; opcode < 256; opcode++) {
+			const uint8_t length = InstructionLengthKernel6502::instructionLength(InstructionLengthKernel6502::classify(static_cast<uint8_t>(opcode)));
+			const uint8_t bytes[PHASES] = { static_cast<uint8_t>(opcode), static_cast<uint8_t>(round * 7), static_cast<uint8_t>(round * 13) };
+
+			disassembler.reset();
+
+			for (size_t phase = 0; phase < length; phase++) {
+				const uint64_t start = now();
+				const bool done = disassembler.analyze(bytes[phase], record);
+				const uint64_t ticks = now() - start;
+
+				sink = done ? record.operand : 0;
+				phaseSamples[phase].push_back(ticks);
+
+				if (ticks > worst[phase]) {
+					worst[phase] = ticks;
+					worstOpcode[phase] = static_cast<uint8_t>(opcode);
+				}
+			}
+		}
+	}
+
+	for (size_t phase = 0; phase < PHASES; phase++) {
+		allSamples.insert(allSamples.end(), phaseSamples[phase].begin(), phaseSamples[phase].end());
+	}
+
+	const char* const phaseNames[PHASES] = { "analyze() opcode byte", "analyze() first operand", "analyze() second operand" };
+	for (size_t phase = 0; phase < PHASES; phase++) {
+		print(phaseNames[phase], phaseSamples[phase], overhead);
+		printf("%-28s worst raw sample on opcode $%02X\n", "", worstOpcode[phase]);
+	}
+	print("analyze() all", allSamples, overhead);
+
+	static RecordQueue6502<QUEUE_CAPACITY> queue;
+	std::vector<uint64_t> pushSamples;
+	std::vector<uint64_t> fullSamples;
+	const StreamingDisassembler6502::Record pushed = { 0, 0x1234, 0xAD, InstructionLengthKernel6502::classify(0xAD) };
+
+	for (size_t round = 0; round < ROUNDS / 16; round++) {
+		for (size_t i = 0; i < QUEUE_CAPACITY; i++) {
+			const uint64_t start = now();
+			const bool accepted = queue.push(pushed);
+			pushSamples.push_back(now() - start);
+			sink = accepted;
+		}
+
+		// the queue is full now; a dropped record is the other path through push()
+		for (size_t i = 0; i < 64; i++) {
+			const uint64_t start = now();
+			const bool accepted = queue.push(pushed);
+			fullSamples.push_back(now() - start);
+			sink = accepted;
+		}
+
+		while (queue.pop(record)) {
+			sink = record.offset;
+		}
+	}
+
+	print("RecordQueue6502::push()", pushSamples, overhead);
+	print("RecordQueue6502::push() full", fullSamples, overhead);
+
+	return 0;
+}